@@ -1,8 +1,16 @@
 #ifndef _ALPHABETAPRUNING_H_
 #define _ALPHABETAPRUNING_H_
 #include "sudokill_core.h"
-#include <omp.h>
+#include "evaluation.h"
+#include "timer.h"
+#include "trace.h"
+#include "log.h"
+#include "thread_pool.h"
 #include <limits>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <algorithm>
 
 namespace hps
 {
@@ -11,6 +19,51 @@ namespace sudokill
 
 struct AlphaBetaPruning
 {
+  /// <summary> Stop signals shared by the threads of one search. </summary>
+  /// <remarks>
+  ///   <para> Flags are polled at every node. The clock and the caller's stop
+  ///     signal are polled every PollInterval nodes of a thread, which keeps
+  ///     the deadline check off the hot path.
+  ///   </para>
+  /// </remarks>
+  struct SearchControl
+  {
+    enum { PollInterval = 1024, };
+
+    SearchControl(const double timeLimitSec_,
+                  const std::atomic<bool>* stopSignal_)
+      : victoryIsMine(false),
+        aborted(false),
+        timeLimitSec(timeLimitSec_),
+        stopSignal(stopSignal_),
+        timer()
+    {}
+
+    /// <summary> Check the clock and the caller's stop signal. </summary>
+    inline void Poll()
+    {
+      if (((NULL != stopSignal) && stopSignal->load(std::memory_order_relaxed)) ||
+          ((timeLimitSec > 0.0) && (timer.GetTime() >= timeLimitSec)))
+      {
+        aborted.store(true, std::memory_order_relaxed);
+      }
+    }
+
+    inline bool Stopped() const
+    {
+      return victoryIsMine.load(std::memory_order_relaxed) ||
+             aborted.load(std::memory_order_relaxed);
+    }
+
+    /// <summary> A root ply is a guaranteed win; the rest is moot. </summary>
+    std::atomic<bool> victoryIsMine;
+    /// <summary> Out of time or stopped: results are partial. </summary>
+    std::atomic<bool> aborted;
+    double timeLimitSec;
+    const std::atomic<bool>* stopSignal;
+    Timer timer;
+  };
+
   /// <summary> Helper struct to pass for thread-level processing. </summary>
   struct ThreadParams
   {
@@ -21,7 +74,14 @@ struct AlphaBetaPruning
         bestMinimax(0),
         bestPlyIdx(-1),
         dfsPlys(),
-        victoryIsMine(NULL)
+        frontierEvals(),
+        control(NULL),
+        nodes(0),
+        pollCountdown(0),
+        extensionsLeft(0),
+        fullDepthMoves(0),
+        reductionMinPlys(0),
+        selDepth(0)
     {}
 
     Board state;
@@ -30,7 +90,16 @@ struct AlphaBetaPruning
     int bestMinimax;
     int bestPlyIdx;
     std::vector<Board::MoveList > dfsPlys;
-    volatile bool* victoryIsMine;
+    std::vector<std::vector<ChildEvaluation> > frontierEvals;
+    SearchControl* control;
+    long long nodes;
+    int pollCountdown;
+    /// <summary> Single-reply extensions left on the current line. </summary>
+    int extensionsLeft;
+    int fullDepthMoves;
+    int reductionMinPlys;
+    /// <summary> Deepest node visited. </summary>
+    int selDepth;
   };
 
   /// <summary> The parallel minimax parameters. </summary>
@@ -39,14 +108,132 @@ struct AlphaBetaPruning
     Params()
       : maxDepth(3),
         depth(0),
+        timeLimitSec(0.0),
+        stopSignal(NULL),
+        singleReplyExtensions(4),
+        fullDepthMoves(4),
+        reductionMinPlys(3),
+        splitRootPlys(true),
+        onlyRootPlys(),
+        pool(NULL),
+        complete(true),
+        nodes(0),
+        selDepth(0),
         rootPlys(),
+        rootPlyNodes(),
+        rootPlyScores(),
+        rootHash(0),
         threadData()
     {}
 
+    /// <summary> Copies the settings and results; the copy allocates its
+    ///   own per-thread state.
+    /// </summary>
+    Params(const Params& rhs)
+      : maxDepth(rhs.maxDepth),
+        depth(rhs.depth),
+        timeLimitSec(rhs.timeLimitSec),
+        stopSignal(rhs.stopSignal),
+        singleReplyExtensions(rhs.singleReplyExtensions),
+        fullDepthMoves(rhs.fullDepthMoves),
+        reductionMinPlys(rhs.reductionMinPlys),
+        splitRootPlys(rhs.splitRootPlys),
+        onlyRootPlys(rhs.onlyRootPlys),
+        pool(rhs.pool),
+        complete(rhs.complete),
+        nodes(rhs.nodes),
+        selDepth(rhs.selDepth),
+        rootPlys(rhs.rootPlys),
+        rootPlyNodes(rhs.rootPlyNodes),
+        rootPlyScores(rhs.rootPlyScores),
+        rootHash(rhs.rootHash),
+        threadData()
+    {}
+
+    Params& operator=(const Params& rhs)
+    {
+      maxDepth = rhs.maxDepth;
+      depth = rhs.depth;
+      timeLimitSec = rhs.timeLimitSec;
+      stopSignal = rhs.stopSignal;
+      singleReplyExtensions = rhs.singleReplyExtensions;
+      fullDepthMoves = rhs.fullDepthMoves;
+      reductionMinPlys = rhs.reductionMinPlys;
+      splitRootPlys = rhs.splitRootPlys;
+      onlyRootPlys = rhs.onlyRootPlys;
+      pool = rhs.pool;
+      complete = rhs.complete;
+      nodes = rhs.nodes;
+      selDepth = rhs.selDepth;
+      rootPlys = rhs.rootPlys;
+      rootPlyNodes = rhs.rootPlyNodes;
+      rootPlyScores = rhs.rootPlyScores;
+      rootHash = rhs.rootHash;
+      return *this;
+    }
+
+    ~Params()
+    {
+      for (size_t threadIdx = 0; threadIdx < threadData.size(); ++threadIdx)
+      {
+        delete threadData[threadIdx];
+      }
+    }
+
     int maxDepth;
     int depth;
+    /// <summary> Abort the search after this many seconds (0 is no limit). </summary>
+    double timeLimitSec;
+    /// <summary> Abort the search when another thread sets this. </summary>
+    const std::atomic<bool>* stopSignal;
+    /// <summary> Plys by which one line may be extended, one for each node
+    ///   with a single valid move (0 is off).
+    /// </summary>
+    int singleReplyExtensions;
+    /// <summary> Children searched to full depth before the rest are
+    ///   reduced by a ply, and searched again in full when they raise the
+    ///   bound (0 is off).
+    /// </summary>
+    int fullDepthMoves;
+    /// <summary> Reduce only at nodes with this many plys left to the horizon. </summary>
+    int reductionMinPlys;
+    /// <summary> Let workers out of root plys help search the replies of
+    ///   root plys still running.
+    /// </summary>
+    bool splitRootPlys;
+    /// <summary> Search only these of the valid root plys; empty is all.
+    ///   Lets other processes search the rest of the root.
+    /// </summary>
+    Board::MoveList onlyRootPlys;
+    /// <summary> Workers for the search; NULL is ThreadPool::Search(). </summary>
+    ThreadPool* pool;
+    /// <summary> Output: false when the search was aborted, in which case
+    ///   the ply is the best among the root plys searched to the end.
+    /// </summary>
+    bool complete;
+    /// <summary> Output: nodes visited by the search. </summary>
+    long long nodes;
+    /// <summary> Output: depth of the deepest node visited. </summary>
+    int selDepth;
+    /// <summary> Output: the root plys in search order. </summary>
     Board::MoveList rootPlys;
-    std::vector<ThreadParams> threadData;
+    /// <summary> Output: nodes under each of rootPlys; empty unless the
+    ///   search completed. They order the root plys of the next search of
+    ///   the same position.
+    /// </summary>
+    std::vector<long long> rootPlyNodes;
+    /// <summary> Output: the minimax of each of rootPlys. Every root ply is
+    ///   searched with a full window, so these are exact and rank all the
+    ///   plys. Empty when root triage decided the search, when it was
+    ///   aborted, or when a proven win cut the other plys short.
+    /// </summary>
+    std::vector<int> rootPlyScores;
+    /// <summary> Output: Board::Hash() of the position searched. </summary>
+    uint64_t rootHash;
+    /// <summary> One per pool worker, allocated by that worker so that its
+    ///   state is local to the worker's NUMA node. NULL until first used.
+    /// </summary>
+    std::vector<ThreadParams*> threadData;
   };
 
   /// <summary> Run alpha-beta pruning to get the ply for the state. </summary>
@@ -57,6 +244,7 @@ struct AlphaBetaPruning
                  Cell* ply)
   {
     assert(params && state && evalFunc && ply);
+    TraceSpan runSpan("alphabeta", params->maxDepth);
 
     const int maxDepth = params->maxDepth;
     int& depth = params->depth;
@@ -66,102 +254,166 @@ struct AlphaBetaPruning
 //              << "." << std::endl;
     ++depth;
 
-    // Get the children of the current state.
+    // The last search of this position predicts the size of each subtree.
     Board::MoveList& plys = params->rootPlys;
+    Board::MoveList lastPlys;
+    std::vector<long long> lastPlyNodes;
+    if (state->Hash() == params->rootHash)
+    {
+      lastPlys.swap(plys);
+      lastPlyNodes.swap(params->rootPlyNodes);
+    }
+    params->rootHash = state->Hash();
+    params->rootPlyNodes.clear();
+    params->rootPlyScores.clear();
+    // Get the children of the current state.
     plys.clear();
     state->ValidMoves(&plys);
+    if (!params->onlyRootPlys.empty())
+    {
+      const Board::MoveList& only = params->onlyRootPlys;
+      Board::MoveList kept;
+      for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+      {
+        if (only.end() != std::find(only.begin(), only.end(), plys[plyIdx]))
+        {
+          kept.push_back(plys[plyIdx]);
+        }
+      }
+      plys.swap(kept);
+    }
     //std::sort(plys.begin(), plys.end(), PlyTorqueComp(state));
     // A leaf has no non-suicidal moves. Who won?
-    volatile bool victoryIsMine = false;
+    SearchControl control(params->timeLimitSec, params->stopSignal);
+    control.Poll();
+    params->nodes = 0;
+    params->selDepth = depth;
     int minimax;
+    bool decided = false;
     if (plys.empty())
     {
       minimax = ScoreLeaf(depth, state, ply);
     }
+    else if (TriageRootPlys(depth, state, &plys, &minimax, ply))
+    {
+      decided = true;
+    }
     else
     {
-      // Setup threads.
-      std::vector<ThreadParams>& threadData = params->threadData;
-      {
-        const int numProcs = omp_get_num_procs();
-        threadData.resize(numProcs);
-        int initMinimax = std::numeric_limits<int>::min();
-        for (int threadIdx = 0; threadIdx < numProcs; ++threadIdx)
-        {
-          ThreadParams& threadParams = threadData[threadIdx];
-          {
-            threadParams.bestMinimax = initMinimax;
-            threadParams.bestPlyIdx = -1;
-            threadParams.depth = depth;
-            threadParams.maxDepth = maxDepth;
-            threadParams.state = *state;
-            threadParams.victoryIsMine = &victoryIsMine;
-            threadParams.dfsPlys.clear();
-            threadParams.dfsPlys.resize(maxDepth - 1);
-          }
-        }
-      }
-      // Initialize alpha and beta for depth 1.
-      const int alpha = std::numeric_limits<int>::min();
-      const int beta = std::numeric_limits<int>::max();
-      // Parallelize the first level.
-#pragma omp parallel for schedule(dynamic, 1)
-      for (int plyIdx = 0; plyIdx < static_cast<int>(plys.size()); ++plyIdx)
-      {
-        const int threadIdx = omp_get_thread_num();
-        ThreadParams& threadParams = threadData[threadIdx];
-        if (!victoryIsMine)
-        {
-          // Apply the ply for this state.
-          Cell& mkChildPly = plys[plyIdx];
-          threadParams.state.PlayMove(mkChildPly);
-          // Run on the subtree.
-          const int minimax = RunThread(alpha, beta, &threadParams, evalFunc);
-          // Undo the ply for the next worker.
-          threadParams.state.Undo();
-          // Collect best minimax for this thread.
-          if ((-1 == threadParams.bestPlyIdx) ||
-              (minimax > threadParams.bestMinimax))
-          {
-            threadParams.bestMinimax = minimax;
-            threadParams.bestPlyIdx = plyIdx;
-            if (std::numeric_limits<int>::max() == minimax)
-            {
-//              std::cout << "Thread " << threadIdx << " found victoryIsMine on "
-//                        << "ply " << plyIdx << " of " << plys.size()
-//                        << "." << std::endl;
-              victoryIsMine = true;
-            }
-          }
-        }
-      }
+      OrderRootPlys(*state, lastPlys, lastPlyNodes, &plys);
+      // Search the root plys on the pool; each worker claims the next ply.
+      ThreadPool& pool = (NULL != params->pool) ? *params->pool : ThreadPool::Search();
+      std::vector<ThreadParams*>& threadData = params->threadData;
+      threadData.resize(pool.Size(), NULL);
+      params->rootPlyNodes.assign(plys.size(), 0);
+      params->rootPlyScores.assign(plys.size(), 0);
+      RootJob<BoardEvaulationFunction> job(params, state, evalFunc, &control,
+                                           params->splitRootPlys && (pool.Size() > 1));
+      pool.Run(&job);
       // Gather best result from all threads.
       {
         int bestPlyIdx;
         GatherRunThreadResults<std::greater<int> >(threadData,
                                                    &minimax, &bestPlyIdx);
+        // Nothing finished before the abort: any ply will do.
+        if (-1 == bestPlyIdx)
+        {
+          bestPlyIdx = 0;
+          minimax = 0;
+        }
         // Set MINIMax ply.
         *ply = plys[bestPlyIdx];
       }
+      for (size_t threadIdx = 0; threadIdx < threadData.size(); ++threadIdx)
+      {
+        params->nodes += threadData[threadIdx]->nodes;
+        params->selDepth = std::max(params->selDepth, threadData[threadIdx]->selDepth);
+      }
+    }
+    params->complete = decided || !control.aborted.load(std::memory_order_relaxed);
+    if (!params->complete)
+    {
+      params->rootPlyNodes.clear();
+    }
+    if (!params->complete || control.victoryIsMine.load(std::memory_order_relaxed))
+    {
+      params->rootPlyScores.clear();
     }
 
     --depth;
+    // Time limits and stop signals end searches as a matter of course.
+    if (!params->complete)
+    {
+      HPS_LOG(Log_Debug, "AlphaBeta was aborted after " << params->nodes
+                         << " nodes; the result is partial.");
+    }
     if(minimax == std::numeric_limits<int>::max())
     {
-      std::cout << "AlphaBeta found a guaranteed win." << std::endl;
+      HPS_LOG(Log_Info, "AlphaBeta found a guaranteed win.");
     }
     else if(minimax == std::numeric_limits<int>::min())
     {
-      std::cout << "AlphaBeta found a guaranteed loss." << std::endl;
+      HPS_LOG(Log_Info, "AlphaBeta found a guaranteed loss.");
     }
     else
     {
-      std::cout << "AlphaBeta did not find a guaranteed win or loss."
-                << std::endl;
+      HPS_LOG(Log_Debug, "AlphaBeta did not find a guaranteed win or loss.");
     }
     return minimax;
   }
 
+  /// <summary> The deepest search worth running: searching past the last
+  ///   empty cell adds nothing.
+  /// </summary>
+  inline static int DepthCap(const Board& state, const int maxDepth)
+  {
+    const int emptyCells = (Board::MaxX * Board::MaxY) -
+                           static_cast<int>(state.GetOccupied().size());
+    return std::max(std::min(maxDepth, emptyCells + 1), 2);
+  }
+
+  /// <summary> Run() to each depth from 2 through depthCap in turn. </summary>
+  /// <remarks>
+  ///   <para> Each iteration keeps the root ply costs in params, which order
+  ///     the root plys of the next. The caller's iteration object has
+  ///     <code> bool BeginIteration(int depth, Params* params); </code>
+  ///     to set the limits of an iteration, or return false to skip it, and
+  ///     <code> bool EndIteration(int depth, int minimax, const Cell& ply,
+  ///       const Params& params); </code>
+  ///     to take its result, or return false to stop.
+  ///   </para>
+  ///   <para> Deepening also stops after a partial iteration, and after a
+  ///     proven result, which will not change with depth.
+  ///   </para>
+  /// </remarks>
+  template <typename BoardEvaulationFunction, typename Iteration>
+  static void Deepen(const int depthCap,
+                     Params* params,
+                     Board* state,
+                     const BoardEvaulationFunction* evalFunc,
+                     Iteration* iteration)
+  {
+    assert(params && state && evalFunc && iteration);
+    for (int depth = 2; depth <= depthCap; ++depth)
+    {
+      TraceSpan iterationSpan("iteration", depth);
+      params->maxDepth = depth;
+      params->depth = 0;
+      if (!iteration->BeginIteration(depth, params))
+      {
+        break;
+      }
+      Cell ply;
+      const int minimax = Run(params, state, evalFunc, &ply);
+      if (!iteration->EndIteration(depth, minimax, ply, *params) || !params->complete ||
+          (std::numeric_limits<int>::max() == minimax) ||
+          (std::numeric_limits<int>::min() == minimax))
+      {
+        break;
+      }
+    }
+  }
+
 private:
 
   inline static bool IdentifyMax(const int depth)
@@ -172,6 +424,11 @@ private:
   inline static int ScoreLeaf(const int depth, Board* state, Cell* ply)
   {
     AnyPlyWillDo(state, ply);
+    return LeafScore(depth);
+  }
+
+  inline static int LeafScore(const int depth)
+  {
     if (IdentifyMax(depth))
     {
       // I have no moves, so I lose.
@@ -184,28 +441,433 @@ private:
     }
   }
 
+  /// <summary> The replies to a root ply, open to idle workers. </summary>
+  /// <remarks>
+  ///   <para> The root is MAX, so the node after a root ply minimizes and
+  ///     its bound is the lowest reply score so far.
+  ///   </para>
+  /// </remarks>
+  struct SplitPoint
+  {
+    SplitPoint() : open(false), replies(), nextReplyIdx(0), beta(0), busy(0), helperNodes(0) {}
+    /// <summary> Set with release once replies and beta are written. </summary>
+    std::atomic<bool> open;
+    Board::MoveList replies;
+    std::atomic<int> nextReplyIdx;
+    std::atomic<int> beta;
+    /// <summary> Workers inside a reply; the owner waits for none. </summary>
+    std::atomic<int> busy;
+    std::atomic<long long> helperNodes;
+  };
+
+  /// <summary> The root plys of one Run() as a job for the thread pool. </summary>
+  /// <remarks>
+  ///   <para> Workers claim root plys in the order given, largest predicted
+  ///     subtree first. A worker with no root ply left helps the plys still
+  ///     running by taking their unstarted replies. The owner searches the
+  ///     first reply alone, so helpers start with its bound (young brothers
+  ///     wait).
+  ///   </para>
+  /// </remarks>
+  template <typename BoardEvaulationFunction>
+  struct RootJob
+  {
+    RootJob(Params* params_,
+            const Board* state_,
+            const BoardEvaulationFunction* evalFunc_,
+            SearchControl* control_,
+            const bool split_)
+      : params(params_),
+        state(state_),
+        evalFunc(evalFunc_),
+        control(control_),
+        split(split_),
+        nextPlyIdx(0),
+        unfinished(static_cast<int>(params_->rootPlys.size())),
+        splits(new SplitPoint[params_->rootPlys.size()])
+    {}
+
+    ~RootJob()
+    {
+      delete[] splits;
+    }
+
+    void operator()(const int threadIdx)
+    {
+      ThreadParams*& threadParamsPtr = params->threadData[threadIdx];
+      if (NULL == threadParamsPtr)
+      {
+        threadParamsPtr = new ThreadParams();
+      }
+      ThreadParams& threadParams = *threadParamsPtr;
+      {
+        threadParams.bestMinimax = std::numeric_limits<int>::min();
+        threadParams.bestPlyIdx = -1;
+        threadParams.depth = params->depth;
+        threadParams.maxDepth = params->maxDepth;
+        threadParams.state = *state;
+        threadParams.control = control;
+        threadParams.nodes = 0;
+        threadParams.pollCountdown = SearchControl::PollInterval;
+        threadParams.extensionsLeft = std::max(params->singleReplyExtensions, 0);
+        threadParams.fullDepthMoves = params->fullDepthMoves;
+        threadParams.reductionMinPlys = std::max(params->reductionMinPlys, 2);
+        threadParams.selDepth = params->depth;
+        // Extensions push the horizon past maxDepth.
+        const size_t levels = params->maxDepth - 1 + threadParams.extensionsLeft;
+        threadParams.dfsPlys.clear();
+        threadParams.dfsPlys.resize(levels);
+        threadParams.frontierEvals.resize(levels);
+      }
+      const Board::MoveList& plys = params->rootPlys;
+      const int numPlys = static_cast<int>(plys.size());
+      for (int plyIdx = nextPlyIdx.fetch_add(1, std::memory_order_relaxed);
+           (plyIdx < numPlys) && !control->Stopped();
+           plyIdx = nextPlyIdx.fetch_add(1, std::memory_order_relaxed))
+      {
+        TraceSpan plySpan("root_ply", plyIdx);
+        const long long nodesBefore = threadParams.nodes;
+        // Apply the ply for this state.
+        threadParams.state.PlayMove(plys[plyIdx]);
+        // Run on the subtree.
+        const int minimax = SearchRootPly(&threadParams, &splits[plyIdx]);
+        // Undo the ply for the next root ply.
+        threadParams.state.Undo();
+        assert(threadParams.state.GetOccupied().size() ==
+               state->GetOccupied().size());
+        params->rootPlyNodes[plyIdx] = (threadParams.nodes - nodesBefore) +
+          splits[plyIdx].helperNodes.load(std::memory_order_relaxed);
+        unfinished.fetch_sub(1, std::memory_order_release);
+        // An aborted subtree did not produce a score.
+        if (control->aborted.load(std::memory_order_relaxed))
+        {
+          break;
+        }
+        params->rootPlyScores[plyIdx] = minimax;
+        // Collect best minimax for this thread.
+        if ((-1 == threadParams.bestPlyIdx) ||
+            (minimax > threadParams.bestMinimax))
+        {
+          threadParams.bestMinimax = minimax;
+          threadParams.bestPlyIdx = plyIdx;
+          if (std::numeric_limits<int>::max() == minimax)
+          {
+            control->victoryIsMine.store(true, std::memory_order_relaxed);
+          }
+        }
+      }
+      if (split)
+      {
+        Help(&threadParams);
+      }
+    }
+
+    /// <summary> Search the node after a root ply, split when worthwhile. </summary>
+    int SearchRootPly(ThreadParams* threadParams, SplitPoint* splitPoint)
+    {
+      // Initialize alpha and beta for depth 1.
+      const int alpha = std::numeric_limits<int>::min();
+      const int beta = std::numeric_limits<int>::max();
+      // Replies at or next to the horizon are too small to share.
+      if (!split || ((threadParams->maxDepth - (threadParams->depth + 1)) < 2))
+      {
+        return RunThread(alpha, beta, threadParams, evalFunc);
+      }
+      Board::MoveList& replies = splitPoint->replies;
+      threadParams->state.ValidMoves(&replies);
+      // Leaves and single replies take the usual path.
+      if (replies.size() < 2)
+      {
+        return RunThread(alpha, beta, threadParams, evalFunc);
+      }
+      if (Stopped(threadParams))
+      {
+        return 0;
+      }
+      int& depth = threadParams->depth;
+      ++depth;
+      threadParams->selDepth = std::max(threadParams->selDepth, depth);
+      threadParams->state.PlayMove(replies.front());
+      const int firstScore = RunThread(alpha, beta, threadParams, evalFunc);
+      threadParams->state.Undo();
+      splitPoint->beta.store(firstScore, std::memory_order_relaxed);
+      splitPoint->nextReplyIdx.store(1, std::memory_order_relaxed);
+      splitPoint->open.store(true, std::memory_order_release);
+      SearchReplies(threadParams, splitPoint, false);
+      splitPoint->open.store(false, std::memory_order_relaxed);
+      while (0 != splitPoint->busy.load(std::memory_order_acquire))
+      {
+        std::this_thread::yield();
+      }
+      --depth;
+      // With alpha at its minimum, the bound is the node's score.
+      return splitPoint->beta.load(std::memory_order_relaxed);
+    }
+
+    /// <summary> Claim and search replies until none are left. The board
+    ///   is at the node after the root ply.
+    /// </summary>
+    void SearchReplies(ThreadParams* threadParams, SplitPoint* splitPoint, const bool helper)
+    {
+      const int alpha = std::numeric_limits<int>::min();
+      const int numReplies = static_cast<int>(splitPoint->replies.size());
+      const bool reduceLate = (threadParams->fullDepthMoves > 0) &&
+        ((threadParams->maxDepth - threadParams->depth) >= threadParams->reductionMinPlys);
+      for (;;)
+      {
+        splitPoint->busy.fetch_add(1, std::memory_order_acq_rel);
+        const int replyIdx = splitPoint->nextReplyIdx.fetch_add(1, std::memory_order_relaxed);
+        if ((replyIdx >= numReplies) || control->Stopped())
+        {
+          splitPoint->busy.fetch_sub(1, std::memory_order_release);
+          return;
+        }
+        const long long nodesBefore = threadParams->nodes;
+        const int beta = splitPoint->beta.load(std::memory_order_relaxed);
+        threadParams->state.PlayMove(splitPoint->replies[replyIdx]);
+        int score;
+        if (reduceLate && (replyIdx >= threadParams->fullDepthMoves))
+        {
+          --threadParams->maxDepth;
+          score = RunThread(alpha, beta, threadParams, evalFunc);
+          ++threadParams->maxDepth;
+          if (score < beta)
+          {
+            score = RunThread(alpha, beta, threadParams, evalFunc);
+          }
+        }
+        else
+        {
+          score = RunThread(alpha, beta, threadParams, evalFunc);
+        }
+        threadParams->state.Undo();
+        int bound = splitPoint->beta.load(std::memory_order_relaxed);
+        while ((score < bound) &&
+               !splitPoint->beta.compare_exchange_weak(bound, score, std::memory_order_relaxed))
+        {}
+        if (helper)
+        {
+          splitPoint->helperNodes.fetch_add(threadParams->nodes - nodesBefore,
+                                            std::memory_order_relaxed);
+        }
+        splitPoint->busy.fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    /// <summary> Take replies of running root plys until all are done. </summary>
+    void Help(ThreadParams* threadParams)
+    {
+      const Board::MoveList& plys = params->rootPlys;
+      const int numPlys = static_cast<int>(plys.size());
+      while ((unfinished.load(std::memory_order_acquire) > 0) && !control->Stopped())
+      {
+        bool helped = false;
+        for (int plyIdx = 0; plyIdx < numPlys; ++plyIdx)
+        {
+          SplitPoint& splitPoint = splits[plyIdx];
+          if (!splitPoint.open.load(std::memory_order_acquire) ||
+              (splitPoint.nextReplyIdx.load(std::memory_order_relaxed) >=
+               static_cast<int>(splitPoint.replies.size())))
+          {
+            continue;
+          }
+          TraceSpan helpSpan("help_ply", plyIdx);
+          threadParams->state.PlayMove(plys[plyIdx]);
+          ++threadParams->depth;
+          SearchReplies(threadParams, &splitPoint, true);
+          --threadParams->depth;
+          threadParams->state.Undo();
+          helped = true;
+        }
+        if (!helped)
+        {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    Params* params;
+    const Board* state;
+    const BoardEvaulationFunction* evalFunc;
+    SearchControl* control;
+    /// <summary> Let idle workers share the replies of running root plys. </summary>
+    bool split;
+    std::atomic<int> nextPlyIdx;
+    /// <summary> Root plys not yet searched to the end. </summary>
+    std::atomic<int> unfinished;
+    SplitPoint* splits;
+
+  private:
+    RootJob(const RootJob&);
+    RootJob& operator=(const RootJob&);
+  };
+
+  /// <summary> Settle the root plys that the candidate masks decide
+  ///   within two plys, before any search.
+  /// </summary>
+  /// <remarks>
+  ///   <para> A ply that leaves the opponent no valid move wins at once. A
+  ///     ply whose only reply leaves us no valid move loses, so it is
+  ///     dropped.
+  ///   </para>
+  /// </remarks>
+  /// <returns> True when this decides the result and there is nothing to search. </returns>
+  static bool TriageRootPlys(const int depth,
+                             Board* state,
+                             Board::MoveList* plys,
+                             int* minimax,
+                             Cell* ply)
+  {
+    assert(state && plys && !plys->empty() && minimax && ply);
+    std::vector<int> replyCounts(plys->size());
+    {
+      const CandidateMasks& masks = state->GetCandidates();
+      for (size_t plyIdx = 0; plyIdx < plys->size(); ++plyIdx)
+      {
+        const Cell& testPly = (*plys)[plyIdx];
+        replyCounts[plyIdx] = masks.ValidCountAfter(
+          CandidateMasks::CellIndex(testPly.location.x, testPly.location.y), testPly.value);
+        if (0 == replyCounts[plyIdx])
+        {
+          *ply = testPly;
+          *minimax = LeafScore(depth + 1);
+          return true;
+        }
+      }
+    }
+    Board::MoveList kept;
+    Board::MoveList replies;
+    int forced = 0;
+    int losing = 0;
+    for (size_t plyIdx = 0; plyIdx < plys->size(); ++plyIdx)
+    {
+      const Cell& testPly = (*plys)[plyIdx];
+      if (1 != replyCounts[plyIdx])
+      {
+        kept.push_back(testPly);
+        continue;
+      }
+      state->PlayMove(testPly);
+      state->ValidMoves(&replies);
+      assert(1 == replies.size());
+      const Cell& reply = replies.front();
+      const int counterCount = state->GetCandidates().ValidCountAfter(
+        CandidateMasks::CellIndex(reply.location.x, reply.location.y), reply.value);
+      state->Undo();
+      if (0 == counterCount)
+      {
+        ++losing;
+      }
+      else
+      {
+        ++forced;
+        kept.push_back(testPly);
+      }
+    }
+    if ((forced > 0) || (losing > 0))
+    {
+      HPS_LOG(Log_Debug, "Root triage: " << forced << " forced and "
+                         << losing << " losing of " << plys->size() << " plys.");
+    }
+    // Every ply loses: take any.
+    if (kept.empty())
+    {
+      *ply = plys->front();
+      *minimax = LeafScore(depth + 2);
+      return true;
+    }
+    plys->swap(kept);
+    return false;
+  }
+
+  /// <summary> Order the root plys largest predicted subtree first, so that
+  ///   no big subtree starts after the others are done.
+  /// </summary>
+  /// <remarks>
+  ///   <para> A subtree's size is its node count in the last search of the
+  ///     position when every ply has one, or else the ply's reply count.
+  ///   </para>
+  /// </remarks>
+  static void OrderRootPlys(const Board& state,
+                            const Board::MoveList& lastPlys,
+                            const std::vector<long long>& lastPlyNodes,
+                            Board::MoveList* plys)
+  {
+    assert(plys);
+    std::vector<std::pair<long long, int> > costs(plys->size());
+    bool measured = !lastPlys.empty() && (lastPlys.size() == lastPlyNodes.size());
+    for (size_t plyIdx = 0; measured && (plyIdx < plys->size()); ++plyIdx)
+    {
+      const Board::MoveList::const_iterator lastPly =
+        std::find(lastPlys.begin(), lastPlys.end(), (*plys)[plyIdx]);
+      measured = lastPly != lastPlys.end();
+      costs[plyIdx] = std::make_pair(measured ? lastPlyNodes[lastPly - lastPlys.begin()] : 0,
+                                     static_cast<int>(plyIdx));
+    }
+    if (!measured)
+    {
+      const CandidateMasks& masks = state.GetCandidates();
+      for (size_t plyIdx = 0; plyIdx < plys->size(); ++plyIdx)
+      {
+        const Cell& testPly = (*plys)[plyIdx];
+        costs[plyIdx] = std::make_pair(
+          static_cast<long long>(masks.ValidCountAfter(
+            CandidateMasks::CellIndex(testPly.location.x, testPly.location.y), testPly.value)),
+          static_cast<int>(plyIdx));
+      }
+    }
+    std::stable_sort(costs.begin(), costs.end(), LargerCost());
+    Board::MoveList ordered(plys->size());
+    for (size_t plyIdx = 0; plyIdx < costs.size(); ++plyIdx)
+    {
+      ordered[plyIdx] = (*plys)[costs[plyIdx].second];
+    }
+    plys->swap(ordered);
+  }
+
+  struct LargerCost
+  {
+    inline bool operator()(const std::pair<long long, int>& lhs,
+                           const std::pair<long long, int>& rhs) const
+    {
+      return lhs.first > rhs.first;
+    }
+  };
+
   template <typename MinimaxFunc>
-  static void GatherRunThreadResults(const std::vector<ThreadParams>& data,
+  static void GatherRunThreadResults(const std::vector<ThreadParams*>& data,
                                      int* minimax, int* bestPlyIdx)
   {
-    std::vector<ThreadParams>::const_iterator result = data.begin();
-    *minimax = result->bestMinimax;
-    *bestPlyIdx = result->bestPlyIdx;
+    std::vector<ThreadParams*>::const_iterator result = data.begin();
+    *minimax = (*result)->bestMinimax;
+    *bestPlyIdx = (*result)->bestPlyIdx;
     MinimaxFunc minimaxFunc;
     for (; result < data.end(); ++result)
     {
-      if (minimaxFunc(result->bestMinimax, *minimax))
+      // Skip threads that did not finish a ply.
+      if (-1 == (*result)->bestPlyIdx)
       {
-        *minimax = result->bestMinimax;
-        *bestPlyIdx = result->bestPlyIdx;
+        continue;
+      }
+      if ((-1 == *bestPlyIdx) || minimaxFunc((*result)->bestMinimax, *minimax))
+      {
+        *minimax = (*result)->bestMinimax;
+        *bestPlyIdx = (*result)->bestPlyIdx;
       }
     }
   }
 
+  /// <remarks>
+  ///   <para> Late children, from fullDepthMoves on, are searched with the
+  ///     horizon a ply nearer. One whose reduced score would raise the bound
+  ///     is searched again to full depth before it is trusted.
+  ///   </para>
+  /// </remarks>
   template <typename MinimaxFunc, typename BoardEvaulationFunction>
   static void ABPruningChildrenHelper(ThreadParams* params,
                                       Board::MoveList::const_iterator testPly,
                                       Board::MoveList::const_iterator endPly,
+                                      int plyIdx,
                                       const BoardEvaulationFunction* evalFunc,
                                       const int* alpha,
                                       const int* beta,
@@ -214,19 +876,35 @@ private:
     assert(params && evalFunc);
 
     Board* state = &params->state;
-    volatile bool* victoryIsMine = params->victoryIsMine;
+    const SearchControl* control = params->control;
+    const bool reduceLate = (params->fullDepthMoves > 0) &&
+                            ((params->maxDepth - params->depth) >= params->reductionMinPlys);
     // Score all plys to find minimax.
     MinimaxFunc minimaxFunc;
-    for (; testPly != endPly; ++testPly)
+    for (; testPly != endPly; ++testPly, ++plyIdx)
     {
-      if (*victoryIsMine)
+      if (control->Stopped())
       {
-        //std::cout << "Got victory signal." << std::endl;
+        //std::cout << "Got stop signal." << std::endl;
         *minimax = 0;
         break;
       }
       state->PlayMove(*testPly);
-      int score = RunThread(*alpha, *beta, params, evalFunc);
+      int score;
+      if (reduceLate && (plyIdx >= params->fullDepthMoves))
+      {
+        --params->maxDepth;
+        score = RunThread(*alpha, *beta, params, evalFunc);
+        ++params->maxDepth;
+        if (minimaxFunc(score, *minimax))
+        {
+          score = RunThread(*alpha, *beta, params, evalFunc);
+        }
+      }
+      else
+      {
+        score = RunThread(*alpha, *beta, params, evalFunc);
+      }
       if (minimaxFunc(score, *minimax))
       {
         *minimax = score;
@@ -239,6 +917,95 @@ private:
     }
   }
 
+  /// <summary> Count a node and test if the search must unwind. </summary>
+  inline static bool Stopped(ThreadParams* params)
+  {
+    ++params->nodes;
+    if (0 == --params->pollCountdown)
+    {
+      params->pollCountdown = SearchControl::PollInterval;
+      params->control->Poll();
+    }
+    return params->control->Stopped();
+  }
+
+  template <bool Batch> struct BatchTag {};
+
+  /// <summary> Minimax over the children of a frontier node using a single
+  ///   EvaluateChildren() call in place of a make/undo per child.
+  /// </summary>
+  /// <remarks>
+  ///   <para> Scores are combined exactly as ABPruningChildrenHelper does so
+  ///     that results match the per-child search. A child with a single
+  ///     reply would be extended, so it is searched as RunThread() would.
+  ///   </para>
+  /// </remarks>
+  template <typename BoardEvaulationFunction>
+  static int ScoreFrontier(const int a,
+                           const int b,
+                           ThreadParams* params,
+                           const Board::MoveList& plys,
+                           const BoardEvaulationFunction* evalFunc,
+                           BatchTag<true>)
+  {
+    assert(!plys.empty());
+    // Extended children search deeper, so each level has its own buffer.
+    std::vector<ChildEvaluation>& evals = params->frontierEvals[params->depth - 2];
+    evals.resize(plys.size());
+    evalFunc->EvaluateChildren(params->state, plys, &evals[0]);
+    // The children are visited without entering RunThread().
+    params->selDepth = std::max(params->selDepth, params->depth + 1);
+    const int childLeafScore = LeafScore(params->depth + 1);
+    const bool isMax = IdentifyMax(params->depth);
+    int alpha = a;
+    int beta = b;
+    for (size_t plyIdx = 0; (plyIdx < plys.size()) && ((0 == plyIdx) || (alpha < beta)); ++plyIdx)
+    {
+      const ChildEvaluation& eval = evals[plyIdx];
+      int score;
+      if (eval.terminal)
+      {
+        score = childLeafScore;
+      }
+      else if (eval.singleReply && (params->extensionsLeft > 0))
+      {
+        params->state.PlayMove(plys[plyIdx]);
+        score = RunThread(alpha, beta, params, evalFunc);
+        params->state.Undo();
+      }
+      else
+      {
+        score = eval.score;
+      }
+      if (isMax)
+      {
+        alpha = (0 == plyIdx) ? score : std::max(alpha, score);
+      }
+      else
+      {
+        beta = (0 == plyIdx) ? score : std::min(beta, score);
+      }
+    }
+    if (isMax)
+    {
+      return (alpha >= beta) ? beta : alpha;
+    }
+    else
+    {
+      return (alpha >= beta) ? alpha : beta;
+    }
+  }
+
+  template <typename BoardEvaulationFunction>
+  static int ScoreFrontier(const int, const int, ThreadParams*,
+                           const Board::MoveList&,
+                           const BoardEvaulationFunction*,
+                           BatchTag<false>)
+  {
+    assert(false && "Evaluator cannot score children in a batch.");
+    return 0;
+  }
+
   template <typename BoardEvaulationFunction>
   static int RunThread(const int a,
                        const int b,
@@ -247,6 +1014,13 @@ private:
   {
     assert(params && evalFunc);
 
+    // Unwind without searching once stopped. Callers still Undo() their
+    // ply, so each thread's board is restored on the way out.
+    if (Stopped(params))
+    {
+      return 0;
+    }
+
     int& depth = params->depth;
     const int& maxDepth = params->maxDepth;
     Board* state = &params->state;
@@ -258,6 +1032,14 @@ private:
     plys.clear();
     state->ValidMoves(&plys);
     //std::sort(plys.begin(), plys.end(), PlyTorqueComp(state));
+    params->selDepth = std::max(params->selDepth, depth);
+    // A forced move does not branch, so see a ply further down its line.
+    const bool extend = (1 == plys.size()) && (params->extensionsLeft > 0);
+    if (extend)
+    {
+      --params->extensionsLeft;
+      ++params->maxDepth;
+    }
     // Collect incoming a and b.
     int alpha = a;
     int beta = b;
@@ -265,14 +1047,20 @@ private:
     int minimax;
     if (plys.empty())
     {
-      Cell tossPly;
-      minimax = ScoreLeaf(depth, state, &tossPly);
+      minimax = LeafScore(depth);
     }
     // If depth bound reached, return score current state.
     else if (maxDepth == depth)
     {
       minimax = (*evalFunc)(*state);
     }
+    // If the children are at the depth bound, score them all at once.
+    else if ((maxDepth == depth + 1) &&
+             EvaluatesChildren<BoardEvaulationFunction>::value)
+    {
+      minimax = ScoreFrontier(alpha, beta, params, plys, evalFunc,
+                              BatchTag<EvaluatesChildren<BoardEvaulationFunction>::value>());
+    }
     else
     {
       // Init score.
@@ -287,7 +1075,7 @@ private:
       {
         alpha = minimax;
         ABPruningChildrenHelper<std::greater<int> >(params, ++testPly,
-                                                    plys.end(),
+                                                    plys.end(), 1,
                                                     evalFunc,
                                                     &alpha, &beta, &alpha);
         if (alpha >= beta)
@@ -304,7 +1092,7 @@ private:
       {
         beta = minimax;
         ABPruningChildrenHelper<std::less<int> >(params, ++testPly,
-                                                 plys.end(),
+                                                 plys.end(), 1,
                                                  evalFunc,
                                                  &alpha, &beta, &beta);
         if (alpha >= beta)
@@ -317,6 +1105,11 @@ private:
         }
       }
     }
+    if (extend)
+    {
+      ++params->extensionsLeft;
+      --params->maxDepth;
+    }
     --depth;
     return minimax;
   }
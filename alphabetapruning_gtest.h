@@ -0,0 +1,322 @@
+#ifndef _HPS_SUDOKILL_ALPHABETAPRUNING_GTEST_H_
+#define _HPS_SUDOKILL_ALPHABETAPRUNING_GTEST_H_
+
+#include "alphabetapruning.h"
+#include "sudokill_gtest_util.h"
+#include "timer.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+namespace _hps_sudokill_alphabetapruning_gtest_h_
+{
+using namespace hps;
+using namespace hps::sudokill_gtest;
+
+/// <summary> Deterministic mid-game position with a large search tree. </summary>
+void SetupMidgame(Board* board)
+{
+  *board = Board();
+  Board::MoveList moves;
+  for (int i = 0; i < 20; ++i)
+  {
+    board->ValidMoves(&moves);
+    ASSERT_FALSE(moves.empty());
+    board->PlayMove(moves[(i * 7) % moves.size()]);
+  }
+}
+
+void ExpectThreadStatesRestored(const AlphaBetaPruning::Params& params,
+                                const Board& board)
+{
+  for (size_t threadIdx = 0; threadIdx < params.threadData.size(); ++threadIdx)
+  {
+    const Board& state = params.threadData[threadIdx]->state;
+    EXPECT_EQ(board.GetOccupied().size(), state.GetOccupied().size());
+    EXPECT_EQ(board.GetLastMove(), state.GetLastMove());
+  }
+}
+
+/// <summary> Plain minimax with the leaf rules of the search. </summary>
+int ReferenceMinimax(const int depth, const int maxDepth, Board* board)
+{
+  Board::MoveList plys;
+  board->ValidMoves(&plys);
+  const bool isMax = (depth & 1) != 0;
+  if (plys.empty())
+  {
+    return isMax ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+  }
+  if (maxDepth == depth)
+  {
+    return ShrinkPossibleMovesEvaluationFunc()(*board);
+  }
+  int minimax = isMax ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+  for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+  {
+    board->PlayMove(plys[plyIdx]);
+    const int score = ReferenceMinimax(depth + 1, maxDepth, board);
+    board->Undo();
+    minimax = isMax ? std::max(minimax, score) : std::min(minimax, score);
+  }
+  return minimax;
+}
+
+TEST(AlphaBetaPruning, MatchesMinimax)
+{
+  ShrinkPossibleMovesEvaluationFunc f;
+  int triaged = 0;
+  for (int line = 0; line < 90; ++line)
+  {
+    Board board = Position(35 + (line % 30), 3 + (2 * (line / 30)));
+    Board::MoveList plys;
+    board.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      continue;
+    }
+    AlphaBetaPruning::Params params;
+    params.maxDepth = 3;
+    params.singleReplyExtensions = 0;
+    params.fullDepthMoves = 0;
+    Cell ply;
+    const int minimax = AlphaBetaPruning::Run(&params, &board, &f, &ply);
+    EXPECT_EQ(ReferenceMinimax(1, params.maxDepth, &board), minimax);
+    ASSERT_TRUE(board.IsValidMove(ply));
+    board.PlayMove(ply);
+    EXPECT_EQ(minimax, ReferenceMinimax(2, params.maxDepth, &board));
+    board.Undo();
+    triaged += (0 == params.nodes) ? 1 : 0;
+  }
+  // Some lines end in a ply the root triage settles without a search.
+  EXPECT_GT(triaged, 0);
+}
+
+TEST(AlphaBetaPruning, SplitRootPlysMatchesMinimax)
+{
+  ShrinkPossibleMovesEvaluationFunc f;
+  ThreadPool::Options options;
+  options.numThreads = 4;
+  ThreadPool pool(options);
+  for (int line = 0; line < 12; ++line)
+  {
+    Board board = Position(40 + (2 * line), 3);
+    Board::MoveList plys;
+    board.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      continue;
+    }
+    AlphaBetaPruning::Params params;
+    params.maxDepth = 4;
+    params.singleReplyExtensions = 0;
+    params.fullDepthMoves = 0;
+    params.pool = &pool;
+    Cell ply;
+    const int minimax = AlphaBetaPruning::Run(&params, &board, &f, &ply);
+    EXPECT_EQ(ReferenceMinimax(1, params.maxDepth, &board), minimax);
+    ExpectThreadStatesRestored(params, board);
+    long long rootNodes = 0;
+    for (size_t plyIdx = 0; plyIdx < params.rootPlyNodes.size(); ++plyIdx)
+    {
+      rootNodes += params.rootPlyNodes[plyIdx];
+    }
+    EXPECT_EQ(params.nodes, rootNodes);
+  }
+}
+
+TEST(AlphaBetaPruning, RootPlysLargestFirst)
+{
+  Board board;
+  SetupMidgame(&board);
+  ShrinkPossibleMovesEvaluationFunc f;
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 3;
+  Cell ply;
+  AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  ASSERT_EQ(params.rootPlys.size(), params.rootPlyNodes.size());
+  const Board::MoveList lastPlys = params.rootPlys;
+  const std::vector<long long> lastPlyNodes = params.rootPlyNodes;
+  // The next search of the position starts with the biggest subtrees.
+  params.maxDepth = 4;
+  AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  ASSERT_EQ(lastPlys.size(), params.rootPlys.size());
+  long long previous = std::numeric_limits<long long>::max();
+  for (size_t plyIdx = 0; plyIdx < params.rootPlys.size(); ++plyIdx)
+  {
+    const size_t lastIdx = std::find(lastPlys.begin(), lastPlys.end(),
+                                     params.rootPlys[plyIdx]) - lastPlys.begin();
+    ASSERT_LT(lastIdx, lastPlys.size());
+    EXPECT_LE(lastPlyNodes[lastIdx], previous);
+    previous = lastPlyNodes[lastIdx];
+  }
+}
+
+TEST(AlphaBetaPruning, RootTriageDropsLosingPlys)
+{
+  ShrinkPossibleMovesEvaluationFunc f;
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 3;
+  Cell ply;
+  // One of four plys has a single reply that leaves us stuck.
+  Board board = Position(57, 2);
+  const int minimax = AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  EXPECT_EQ(ReferenceMinimax(1, params.maxDepth, &board), minimax);
+  EXPECT_EQ(3u, params.rootPlys.size());
+  // The only ply loses that way.
+  board = Position(62, 4);
+  EXPECT_EQ(std::numeric_limits<int>::min(),
+            AlphaBetaPruning::Run(&params, &board, &f, &ply));
+  EXPECT_EQ(0, params.nodes);
+  EXPECT_TRUE(board.IsValidMove(ply));
+}
+
+TEST(AlphaBetaPruning, Complete)
+{
+  Board board;
+  SetupMidgame(&board);
+  ShrinkPossibleMovesEvaluationFunc f;
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 3;
+  Cell ply;
+  AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  EXPECT_TRUE(params.complete);
+  EXPECT_GT(params.nodes, 0);
+  EXPECT_TRUE(board.IsValidMove(ply));
+}
+
+TEST(AlphaBetaPruning, SingleReplyExtensions)
+{
+  ShrinkPossibleMovesEvaluationFunc f;
+  bool extended = false;
+  for (int moves = 30; moves < 60; ++moves)
+  {
+    Board board;
+    Board::MoveList plys;
+    for (int i = 0; i < moves; ++i)
+    {
+      board.ValidMoves(&plys);
+      if (plys.empty())
+      {
+        break;
+      }
+      board.PlayMove(plys[(i * 7) % plys.size()]);
+    }
+    AlphaBetaPruning::Params params;
+    params.maxDepth = 3;
+    params.fullDepthMoves = 0;
+    params.singleReplyExtensions = 0;
+    Cell ply;
+    AlphaBetaPruning::Run(&params, &board, &f, &ply);
+    // Root triage decides some positions without a search.
+    const bool searched = !params.rootPlyNodes.empty();
+    EXPECT_TRUE(!searched || (params.selDepth >= params.maxDepth));
+    EXPECT_LE(params.selDepth, params.maxDepth);
+    params.singleReplyExtensions = 2;
+    AlphaBetaPruning::Run(&params, &board, &f, &ply);
+    EXPECT_TRUE(params.complete);
+    EXPECT_TRUE(!searched || (params.selDepth >= params.maxDepth));
+    EXPECT_LE(params.selDepth, params.maxDepth + params.singleReplyExtensions);
+    ExpectThreadStatesRestored(params, board);
+    extended = extended || (params.selDepth > params.maxDepth);
+  }
+  EXPECT_TRUE(extended);
+}
+
+TEST(AlphaBetaPruning, LateMoveReductions)
+{
+  Board board;
+  SetupMidgame(&board);
+  ShrinkPossibleMovesEvaluationFunc f;
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 5;
+  params.singleReplyExtensions = 0;
+  params.fullDepthMoves = 0;
+  Cell fullPly;
+  AlphaBetaPruning::Run(&params, &board, &f, &fullPly);
+  const long long fullNodes = params.nodes;
+  params.fullDepthMoves = 2;
+  params.reductionMinPlys = 2;
+  Cell reducedPly;
+  AlphaBetaPruning::Run(&params, &board, &f, &reducedPly);
+  EXPECT_TRUE(params.complete);
+  EXPECT_LT(params.nodes, fullNodes);
+  EXPECT_TRUE(board.IsValidMove(reducedPly));
+  ExpectThreadStatesRestored(params, board);
+}
+
+TEST(AlphaBetaPruning, StopSignal)
+{
+  Board board;
+  SetupMidgame(&board);
+  ShrinkPossibleMovesEvaluationFunc f;
+  std::atomic<bool> stop(true);
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 6;
+  params.stopSignal = &stop;
+  Cell ply;
+  AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  EXPECT_FALSE(params.complete);
+  EXPECT_TRUE(board.IsValidMove(ply));
+  ExpectThreadStatesRestored(params, board);
+}
+
+TEST(AlphaBetaPruning, TimeLimit)
+{
+  Board board;
+  SetupMidgame(&board);
+  ShrinkPossibleMovesEvaluationFunc f;
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 12;
+  params.timeLimitSec = 0.05;
+  Cell ply;
+  Timer timer;
+  AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  const double elapsed = timer.GetTime();
+  EXPECT_FALSE(params.complete);
+  EXPECT_LT(elapsed, 1.0);
+  EXPECT_TRUE(board.IsValidMove(ply));
+  ExpectThreadStatesRestored(params, board);
+}
+
+/// <summary> Records the depths searched; stops after lastDepth. </summary>
+struct CountingIteration
+{
+  explicit CountingIteration(const int lastDepth_) : lastDepth(lastDepth_), depths() {}
+
+  bool BeginIteration(const int depth, AlphaBetaPruning::Params*)
+  {
+    return depth <= lastDepth;
+  }
+
+  bool EndIteration(const int depth, const int, const Cell&, const AlphaBetaPruning::Params&)
+  {
+    depths.push_back(depth);
+    return true;
+  }
+
+  int lastDepth;
+  std::vector<int> depths;
+};
+
+TEST(AlphaBetaPruning, Deepen)
+{
+  Board board;
+  SetupMidgame(&board);
+  ShrinkPossibleMovesEvaluationFunc f;
+  AlphaBetaPruning::Params params;
+  CountingIteration iteration(4);
+  AlphaBetaPruning::Deepen(6, &params, &board, &f, &iteration);
+  ASSERT_EQ(3U, iteration.depths.size());
+  EXPECT_EQ(2, iteration.depths.front());
+  EXPECT_EQ(4, iteration.depths.back());
+  // Past the last empty cell, the cap stops at one more ply.
+  const Board full = Position(81, 1);
+  const int emptyCells = (Board::MaxX * Board::MaxY) -
+                         static_cast<int>(full.GetOccupied().size());
+  EXPECT_EQ(std::max(emptyCells + 1, 2), AlphaBetaPruning::DepthCap(full, 30));
+  EXPECT_EQ(2, AlphaBetaPruning::DepthCap(Board(), 1));
+}
+
+}
+
+#endif //_HPS_SUDOKILL_ALPHABETAPRUNING_GTEST_H_
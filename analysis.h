@@ -0,0 +1,336 @@
+#ifndef _HPS_SUDOKILL_ANALYSIS_H_
+#define _HPS_SUDOKILL_ANALYSIS_H_
+#include "sudokill_core.h"
+#include "alphabetapruning.h"
+#include "eval_weights.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include <assert.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> One of the best root plys of a position. </summary>
+struct AnalysisLine
+{
+  AnalysisLine() : ply(), score(0), pv() {}
+  Cell ply;
+  /// <summary> Minimax from the view of the player to move. </summary>
+  int score;
+  /// <summary> Principal variation, starting with ply; cut short when the
+  ///   time limit runs out.
+  /// </summary>
+  Board::MoveList pv;
+};
+
+/// <summary> The result of analyzing one position. </summary>
+struct Analysis
+{
+  Analysis() : depth(0), selDepth(0), nodes(0), seconds(0.0), complete(false), lines() {}
+  /// <summary> Depth of the last iteration that finished. </summary>
+  int depth;
+  int selDepth;
+  /// <summary> Nodes over all iterations, not counting the variations. </summary>
+  long long nodes;
+  double seconds;
+  /// <summary> False when the time ran out before the depth cap. </summary>
+  bool complete;
+  /// <summary> Best first; empty when there is no valid move. </summary>
+  std::vector<AnalysisLine> lines;
+};
+
+/// <summary> Search positions offline and rank their root plys. </summary>
+/// <remarks>
+///   <para> Each position is searched with iterative deepening like
+///     AlphaBetaPlayer, to the depth cap or the time limit, and the ranking
+///     of the last finished iteration is kept. Every root ply is searched
+///     with a full window, so the search scores them all exactly.
+///   </para>
+///   <para> The search keeps no principal variation, so each of the best
+///     lines is followed by searching its positions again: the opponent's
+///     replies with the weights negated, which makes the opponent's best
+///     reply the maximum. These searches start a fresh extension budget, so
+///     a variation may leave the ply's score deep in the line.
+///   </para>
+///   <para> A batch runs one position per worker of a SearchTeam. </para>
+/// </remarks>
+class Analyzer
+{
+public:
+  struct Options
+  {
+    Options()
+    : maxDepth(11),
+      timeLimitSec(0.0),
+      multiPv(3),
+      numJobs(0),
+      numThreads(1),
+      weights()
+    {}
+    int maxDepth;
+    /// <summary> Per position, variations included: deepening stops at three
+    ///   quarters of it. 0 is no limit. Depth 2 always finishes.
+    /// </summary>
+    double timeLimitSec;
+    /// <summary> Root plys to report, with their variations. </summary>
+    int multiPv;
+    /// <summary> Positions analyzed at once; 0 is one per CPU. </summary>
+    int numJobs;
+    /// <summary> Search threads per position. </summary>
+    int numThreads;
+    EvalWeights weights;
+  };
+
+  explicit Analyzer(const Options& options_ = Options())
+  : options(options_),
+    jobs(options_.numJobs, options_.numThreads)
+  {}
+
+  /// <summary> Analyze one position on the given pool. </summary>
+  static void Analyze(const Options& options,
+                      ThreadPool* pool,
+                      const Board& board,
+                      Analysis* analysis)
+  {
+    assert(analysis);
+    *analysis = Analysis();
+    Timer timer;
+    Board state = board;
+    Board::MoveList plys;
+    state.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      analysis->complete = true;
+      return;
+    }
+    const WeightedEvaluationFunc f(options.weights, state.GetPlayerMovesCount());
+    AlphaBetaPruning::Params params;
+    params.pool = pool;
+    // Scores of the root plys in the last finished iteration.
+    std::vector<std::pair<int, Cell> > ranked;
+    analysis->complete = true;
+    Iteration iteration(options, timer, &ranked, analysis);
+    AlphaBetaPruning::Deepen(AlphaBetaPruning::DepthCap(state, options.maxDepth),
+                             &params, &state, &f, &iteration);
+    const size_t numLines = std::min(ranked.size(),
+                                     static_cast<size_t>(std::max(options.multiPv, 1)));
+    analysis->lines.resize(numLines);
+    for (size_t lineIdx = 0; lineIdx < numLines; ++lineIdx)
+    {
+      AnalysisLine& line = analysis->lines[lineIdx];
+      line.score = ranked[lineIdx].first;
+      line.ply = ranked[lineIdx].second;
+      FollowLine(options.weights, analysis->depth, pool, state, options.timeLimitSec, timer,
+                 &line);
+    }
+    analysis->seconds = timer.GetTime();
+  }
+
+  /// <summary> Analyze every board, Jobs() of them at once. </summary>
+  void AnalyzeAll(const std::vector<Board>& boards, std::vector<Analysis>* analyses)
+  {
+    assert(analyses);
+    analyses->clear();
+    analyses->resize(boards.size());
+    if (boards.empty())
+    {
+      return;
+    }
+    BatchItem item = { &options, &boards, analyses, };
+    jobs.ForEach(static_cast<int>(boards.size()), &item);
+  }
+
+  inline int Jobs() const
+  {
+    return jobs.Size();
+  }
+
+  inline const Options& GetOptions() const
+  {
+    return options;
+  }
+
+  /// <summary> Weights scoring every board as the negation of weights. </summary>
+  static EvalWeights Negated(const EvalWeights& weights)
+  {
+    EvalWeights negated = weights;
+    negated.mobility = -weights.mobility;
+    negated.playable = -weights.playable;
+    negated.deadCells = -weights.deadCells;
+    negated.parity = -weights.parity;
+    return negated;
+  }
+
+  /// <summary> Negate a score of the negated weights, keeping proven results. </summary>
+  inline static int NegatedScore(const int score)
+  {
+    if (std::numeric_limits<int>::max() == score)
+    {
+      return std::numeric_limits<int>::min();
+    }
+    if (std::numeric_limits<int>::min() == score)
+    {
+      return std::numeric_limits<int>::max();
+    }
+    return -score;
+  }
+
+private:
+  Analyzer(const Analyzer&);
+  Analyzer& operator=(const Analyzer&);
+
+  struct HigherScore
+  {
+    inline bool operator()(const std::pair<int, Cell>& lhs,
+                           const std::pair<int, Cell>& rhs) const
+    {
+      return lhs.first > rhs.first;
+    }
+  };
+
+  /// <summary> Ranks the root plys after each full iteration. </summary>
+  struct Iteration
+  {
+    Iteration(const Options& options_,
+              const Timer& timer_,
+              std::vector<std::pair<int, Cell> >* ranked_,
+              Analysis* analysis_)
+    : options(options_), timer(timer_), ranked(ranked_), analysis(analysis_)
+    {}
+
+    bool BeginIteration(const int depth, AlphaBetaPruning::Params* params)
+    {
+      if ((options.timeLimitSec > 0.0) && (depth > 2))
+      {
+        // Leave a quarter of the time to follow the variations.
+        params->timeLimitSec = (0.75 * options.timeLimitSec) - timer.GetTime();
+        if (params->timeLimitSec <= 0.0)
+        {
+          analysis->complete = false;
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool EndIteration(const int depth,
+                      const int minimax,
+                      const Cell& ply,
+                      const AlphaBetaPruning::Params& params)
+    {
+      analysis->nodes += params.nodes;
+      if (!params.complete)
+      {
+        analysis->complete = false;
+        return false;
+      }
+      analysis->depth = depth;
+      analysis->selDepth = params.selDepth;
+      ranked->clear();
+      // Triage or a proven win decides the search without ranking the rest.
+      if (params.rootPlyScores.empty())
+      {
+        ranked->push_back(std::make_pair(minimax, ply));
+      }
+      else
+      {
+        for (size_t plyIdx = 0; plyIdx < params.rootPlys.size(); ++plyIdx)
+        {
+          ranked->push_back(std::make_pair(params.rootPlyScores[plyIdx],
+                                           params.rootPlys[plyIdx]));
+        }
+        std::stable_sort(ranked->begin(), ranked->end(), HigherScore());
+      }
+      return true;
+    }
+
+    const Options& options;
+    const Timer& timer;
+    std::vector<std::pair<int, Cell> >* ranked;
+    Analysis* analysis;
+  };
+
+  /// <summary> Fill the line's variation to the depth it was searched to,
+  ///   or less when the time limit, counted on timer, runs out first.
+  /// </summary>
+  static void FollowLine(const EvalWeights& weights,
+                         const int depth,
+                         ThreadPool* pool,
+                         const Board& root,
+                         const double timeLimitSec,
+                         const Timer& timer,
+                         AnalysisLine* line)
+  {
+    assert(line);
+    // Both score from the root player's view; the opponent maximizes the
+    // negation.
+    const WeightedEvaluationFunc rootEval(weights, root.GetPlayerMovesCount());
+    const WeightedEvaluationFunc replyEval(Negated(weights), root.GetPlayerMovesCount());
+    Board state = root;
+    line->pv.assign(1, line->ply);
+    state.PlayMove(line->ply);
+    AlphaBetaPruning::Params params;
+    params.pool = pool;
+    Board::MoveList plys;
+    // The last ply of a search of depth 2 is the one at the horizon.
+    for (int horizon = depth - 1; horizon >= 2; --horizon)
+    {
+      state.ValidMoves(&plys);
+      if (plys.empty())
+      {
+        break;
+      }
+      params.maxDepth = horizon;
+      params.depth = 0;
+      if (timeLimitSec > 0.0)
+      {
+        params.timeLimitSec = timeLimitSec - timer.GetTime();
+        if (params.timeLimitSec <= 0.0)
+        {
+          break;
+        }
+      }
+      Cell ply;
+      if (line->pv.size() & 1)
+      {
+        AlphaBetaPruning::Run(&params, &state, &replyEval, &ply);
+      }
+      else
+      {
+        AlphaBetaPruning::Run(&params, &state, &rootEval, &ply);
+      }
+      if (!params.complete)
+      {
+        break;
+      }
+      line->pv.push_back(ply);
+      state.PlayMove(ply);
+    }
+  }
+
+  struct BatchItem
+  {
+    void operator()(const int boardIdx, ThreadPool* pool)
+    {
+      Analyze(*options, pool, (*boards)[boardIdx], &(*analyses)[boardIdx]);
+    }
+
+    const Options* options;
+    const std::vector<Board>* boards;
+    std::vector<Analysis>* analyses;
+  };
+
+  Options options;
+  SearchTeam jobs;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_ANALYSIS_H_
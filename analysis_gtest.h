@@ -0,0 +1,139 @@
+#ifndef _HPS_SUDOKILL_ANALYSIS_GTEST_H_
+#define _HPS_SUDOKILL_ANALYSIS_GTEST_H_
+
+#include "analysis.h"
+#include "sudokill_gtest_util.h"
+#include "gtest/gtest.h"
+#include <limits>
+#include <vector>
+
+namespace _hps_sudokill_analysis_gtest_h_
+{
+using namespace hps;
+using namespace hps::sudokill_gtest;
+
+TEST(Analysis, RootPlyScoresRankTheSearch)
+{
+  const Board board = Position(40, 7);
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = 3;
+  ThreadPool pool(poolOptions);
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 4;
+  params.pool = &pool;
+  const WeightedEvaluationFunc f(EvalWeights(), board.GetPlayerMovesCount());
+  Cell ply;
+  Board state = board;
+  const int minimax = AlphaBetaPruning::Run(&params, &state, &f, &ply);
+  ASSERT_EQ(params.rootPlys.size(), params.rootPlyScores.size());
+  const std::vector<int>::const_iterator best =
+    std::max_element(params.rootPlyScores.begin(), params.rootPlyScores.end());
+  EXPECT_EQ(minimax, *best);
+  EXPECT_EQ(minimax, params.rootPlyScores[std::find(params.rootPlys.begin(),
+                                                    params.rootPlys.end(), ply) -
+                                          params.rootPlys.begin()]);
+}
+
+TEST(Analysis, NegatedWeights)
+{
+  EvalWeights weights;
+  weights.parity = 300;
+  weights.playable = 5;
+  const Board board = Position(35, 3);
+  const WeightedEvaluationFunc f(weights, 0);
+  const WeightedEvaluationFunc negated(Analyzer::Negated(weights), 0);
+  EXPECT_EQ(-f(board), negated(board));
+  EXPECT_EQ(std::numeric_limits<int>::min(),
+            Analyzer::NegatedScore(std::numeric_limits<int>::max()));
+  EXPECT_EQ(std::numeric_limits<int>::max(),
+            Analyzer::NegatedScore(std::numeric_limits<int>::min()));
+  EXPECT_EQ(-7, Analyzer::NegatedScore(7));
+}
+
+TEST(Analysis, MultiPv)
+{
+  Analyzer::Options options;
+  options.maxDepth = 5;
+  options.multiPv = 4;
+  options.numJobs = 1;
+  Analyzer analyzer(options);
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = 1;
+  ThreadPool pool(poolOptions);
+  const Board board = Position(38, 5);
+  Analysis analysis;
+  Analyzer::Analyze(options, &pool, board, &analysis);
+  EXPECT_TRUE(analysis.complete);
+  EXPECT_EQ(5, analysis.depth);
+  ASSERT_FALSE(analysis.lines.empty());
+  EXPECT_GE(4U, analysis.lines.size());
+  // The best line is the move the search plays.
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 5;
+  params.pool = &pool;
+  const WeightedEvaluationFunc f(options.weights, board.GetPlayerMovesCount());
+  Cell ply;
+  Board state = board;
+  const int minimax = AlphaBetaPruning::Run(&params, &state, &f, &ply);
+  EXPECT_EQ(minimax, analysis.lines.front().score);
+  for (size_t lineIdx = 0; lineIdx < analysis.lines.size(); ++lineIdx)
+  {
+    const AnalysisLine& line = analysis.lines[lineIdx];
+    if (lineIdx > 0)
+    {
+      EXPECT_GE(analysis.lines[lineIdx - 1].score, line.score);
+      EXPECT_FALSE(analysis.lines[lineIdx - 1].ply == line.ply);
+    }
+    // The variation is a game, one move per ply searched.
+    ASSERT_FALSE(line.pv.empty());
+    EXPECT_EQ(line.ply, line.pv.front());
+    EXPECT_GE(4U, line.pv.size());
+    state = board;
+    for (size_t pvIdx = 0; pvIdx < line.pv.size(); ++pvIdx)
+    {
+      ASSERT_TRUE(state.IsValidMove(line.pv[pvIdx]));
+      state.PlayMove(line.pv[pvIdx]);
+    }
+  }
+}
+
+TEST(Analysis, BatchMatchesOneByOne)
+{
+  Analyzer::Options options;
+  options.maxDepth = 4;
+  options.multiPv = 2;
+  options.numJobs = 3;
+  Analyzer analyzer(options);
+  ASSERT_EQ(3, analyzer.Jobs());
+  std::vector<Board> boards;
+  for (int boardIdx = 0; boardIdx < 7; ++boardIdx)
+  {
+    boards.push_back(Position(30 + (3 * boardIdx), 1 + boardIdx));
+  }
+  // A finished game has nothing to analyze.
+  boards.push_back(Position(81, 1));
+  std::vector<Analysis> analyses;
+  analyzer.AnalyzeAll(boards, &analyses);
+  ASSERT_EQ(boards.size(), analyses.size());
+  EXPECT_TRUE(analyses.back().lines.empty());
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = 1;
+  ThreadPool pool(poolOptions);
+  for (size_t boardIdx = 0; boardIdx < boards.size(); ++boardIdx)
+  {
+    Analysis analysis;
+    Analyzer::Analyze(options, &pool, boards[boardIdx], &analysis);
+    EXPECT_EQ(analysis.depth, analyses[boardIdx].depth);
+    EXPECT_EQ(analysis.nodes, analyses[boardIdx].nodes);
+    ASSERT_EQ(analysis.lines.size(), analyses[boardIdx].lines.size());
+    for (size_t lineIdx = 0; lineIdx < analysis.lines.size(); ++lineIdx)
+    {
+      EXPECT_EQ(analysis.lines[lineIdx].score, analyses[boardIdx].lines[lineIdx].score);
+      EXPECT_TRUE(analysis.lines[lineIdx].pv == analyses[boardIdx].lines[lineIdx].pv);
+    }
+  }
+}
+
+}
+
+#endif //_HPS_SUDOKILL_ANALYSIS_GTEST_H_
@@ -2,6 +2,7 @@
 #define _HPS_SUDOKILL_BOARD_PARSER_H_
 #include "sudokill_core.h"
 #include <string>
+#include <limits>
 #include <sstream>
 #include <iostream>
 
@@ -38,6 +39,14 @@ struct Parser
     return true;
   }
 
+  /// <summary> Test that a cell is on the board with a value in range. </summary>
+  inline static bool IsOnBoard(const Cell& cell)
+  {
+    return (cell.location.x >= 0) && (cell.location.x < Board::MaxX) &&
+           (cell.location.y >= 0) && (cell.location.y < Board::MaxY) &&
+           (cell.value >= Board::MinValue) && (cell.value <= Board::MaxValue);
+  }
+
   /// <summary> Read next non-empty line from stream. </summary>
   inline static bool ReadNextLineNonEmpty(std::istream& stream, std::string* line)
   {
@@ -52,6 +61,53 @@ struct Parser
     return false;
   }
 
+  /// <summary> Read the next state string, from StateStringBegin() through
+  ///   StateStringEnd(), skipping anything between them. Start with an
+  ///   empty stateString.
+  /// </summary>
+  static bool ReadStateString(std::istream& stream, std::string* stateString)
+  {
+    assert(stateString);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+      if (!line.empty() && ('\r' == line[line.size() - 1]))
+      {
+        line.erase(line.size() - 1);
+      }
+      if (StateStringBegin() == line)
+      {
+        *stateString = line + "\n";
+      }
+      else if (!stateString->empty())
+      {
+        *stateString += line + "\n";
+        if (StateStringEnd() == line)
+        {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /// <summary> Write a minimax score, with proven results as "win" and "loss". </summary>
+  static void PrintScore(std::ostream& stream, const int score)
+  {
+    if (std::numeric_limits<int>::max() == score)
+    {
+      stream << "win";
+    }
+    else if (std::numeric_limits<int>::min() == score)
+    {
+      stream << "loss";
+    }
+    else
+    {
+      stream << score;
+    }
+  }
+
   /// <summary> Construct game from state string. </summary>
   static bool Parse(const std::string& stateString, Board* board)
   {
@@ -76,10 +132,12 @@ struct Parser
       {
         if (loadingPresets)
         {
+          if (!IsOnBoard(cell)) { return false; }
           presets.push_back(cell);
         }
         else
         {
+          if (!IsOnBoard(cell) || !board->IsValidMove(cell)) { return false; }
           board->PlayMove(cell);
         }
       }
@@ -3,6 +3,9 @@
 
 #include "board_parser.h"
 #include "gtest/gtest.h"
+#include <limits>
+#include <sstream>
+#include <string>
 
 namespace _hps_board_parser_gtest_h_
 {
@@ -27,6 +30,40 @@ TEST(Parser, Parse)
   EXPECT_EQ(board.GetLastMove(), Cell(Point(4, 3), 8));
 }
 
+TEST(Parser, ReadStateString)
+{
+  std::stringstream stream(
+    "noise\r\n"
+    "MOVE START\r\n"
+    "0 0 5\r\n"
+    "MOVE END\r\n"
+    "between\n"
+    "MOVE START\n"
+    "-1 -1 -1\n"
+    "MOVE END\n"
+    "MOVE START\n");
+  std::string stateString;
+  ASSERT_TRUE(Parser::ReadStateString(stream, &stateString));
+  EXPECT_EQ("MOVE START\n0 0 5\nMOVE END\n", stateString);
+  stateString.clear();
+  ASSERT_TRUE(Parser::ReadStateString(stream, &stateString));
+  EXPECT_EQ("MOVE START\n-1 -1 -1\nMOVE END\n", stateString);
+  stateString.clear();
+  // An unfinished state string is not read.
+  EXPECT_FALSE(Parser::ReadStateString(stream, &stateString));
+}
+
+TEST(Parser, PrintScore)
+{
+  std::stringstream stream;
+  Parser::PrintScore(stream, std::numeric_limits<int>::max());
+  stream << " ";
+  Parser::PrintScore(stream, std::numeric_limits<int>::min());
+  stream << " ";
+  Parser::PrintScore(stream, -12);
+  EXPECT_EQ("win loss -12", stream.str());
+}
+
 }
 
 #endif //_HPS_BOARD_PARSER_GTEST_H_
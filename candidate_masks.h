@@ -0,0 +1,531 @@
+#ifndef _HPS_SUDOKILL_CANDIDATE_MASKS_H_
+#define _HPS_SUDOKILL_CANDIDATE_MASKS_H_
+#include <assert.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HPS_CANDIDATE_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Sudoku candidate values for all 81 cells of the board. </summary>
+/// <remarks>
+///   <para> Cells are indexed as y * 9 + x. Bit (v - 1) of a mask is set when
+///     value v may be placed. Units are the 9 rows, then the 9 columns, then
+///     the 9 boxes; each holds the mask of values already used there.
+///   </para>
+///   <para> Fill the inputs with Clear() and Place(), then Compute() runs the
+///     fastest kernel supported by the CPU over every cell at once.
+///   </para>
+/// </remarks>
+struct CandidateMasks
+{
+  typedef unsigned short Mask;
+
+  enum { Dim = 9, };
+  enum { NumCells = Dim * Dim, };
+  // Cell arrays are padded to a whole number of 256-bit vectors.
+  enum { PaddedCells = 96, };
+  enum { NumUnits = 3 * Dim, };
+  enum { RowUnit = 0, ColumnUnit = Dim, BoxUnit = 2 * Dim, };
+  enum { AllValues = 0x1FF, };
+  // Marks an occupied (or padding) cell in the input.
+  enum { OccupiedFlag = 0x8000 | AllValues, };
+
+  inline static int CellIndex(const int x, const int y)
+  {
+    return (y * Dim) + x;
+  }
+  inline static int CellX(const int cellIdx) { return cellIdx % Dim; }
+  inline static int CellY(const int cellIdx) { return cellIdx / Dim; }
+  inline static int CellBox(const int cellIdx)
+  {
+    return ((CellY(cellIdx) / 3) * 3) + (CellX(cellIdx) / 3);
+  }
+  inline static Mask ValueBit(const int value)
+  {
+    return static_cast<Mask>(1 << (value - 1));
+  }
+
+  /// <summary> Reset to an empty board. </summary>
+  inline void Clear()
+  {
+    memset(units, 0, sizeof(units));
+    memset(occupied, 0, sizeof(occupied));
+    for (int cellIdx = NumCells; cellIdx < PaddedCells; ++cellIdx)
+    {
+      occupied[cellIdx] = OccupiedFlag;
+    }
+  }
+
+  /// <summary> Record a placed value in the inputs. </summary>
+  inline void Place(const int cellIdx, const int value)
+  {
+    assert(cellIdx >= 0 && cellIdx < NumCells);
+    assert(value >= 1 && value <= Dim);
+    const Mask bit = ValueBit(value);
+    units[RowUnit + CellY(cellIdx)] |= bit;
+    units[ColumnUnit + CellX(cellIdx)] |= bit;
+    units[BoxUnit + CellBox(cellIdx)] |= bit;
+    occupied[cellIdx] = OccupiedFlag;
+  }
+
+  inline bool Occupied(const int cellIdx) const
+  {
+    return 0 != occupied[cellIdx];
+  }
+
+  /// <summary> Compute cells, counts, total and deadCells from the inputs. </summary>
+  inline void Compute();
+
+  /// <summary> What Play() removed, so that Unplay() can restore it. </summary>
+  struct Delta
+  {
+    /// <summary> Bit i is set when peer i lost the played value. </summary>
+    unsigned int peers;
+    /// <summary> Candidates of the played cell. </summary>
+    Mask cell;
+  };
+
+  /// <summary> Place value at the empty cell and update the candidates of
+  ///   its peers in place. Requires Compute() or a previous Play().
+  /// </summary>
+  inline Delta Play(const int cellIdx, const int value);
+
+  /// <summary> Take back the value placed at cellIdx by Play(). </summary>
+  inline void Unplay(const int cellIdx, const int value, const Delta& delta);
+
+  /// <summary> Number of Sudoku-valid moves once value is placed at the
+  ///   empty cell. Requires Compute().
+  /// </summary>
+  inline int SudokuCountAfter(const int cellIdx, const int value) const;
+
+  /// <summary> Number of Sudokill-valid moves for the opponent once value is
+  ///   placed at the empty cell. Requires Compute().
+  /// </summary>
+  inline int ValidCountAfter(const int cellIdx, const int value) const;
+
+  /// <summary> Used values per row, column and box. </summary>
+  unsigned int units[NumUnits];
+  /// <summary> OccupiedFlag for filled cells, otherwise 0. </summary>
+  unsigned int occupied[PaddedCells];
+  /// <summary> Candidate values per cell (0 when occupied). </summary>
+  Mask cells[PaddedCells];
+  /// <summary> Number of candidate values per cell. </summary>
+  Mask counts[PaddedCells];
+  /// <summary> Sum of counts, i.e. the number of Sudoku-valid moves. </summary>
+  int total;
+  /// <summary> Empty cells that have no candidate value left. </summary>
+  int deadCells;
+};
+
+namespace detail
+{
+
+/// <summary> Unit lookup tables used by the candidate kernels. </summary>
+struct CandidateTables
+{
+  CandidateTables()
+  {
+    typedef CandidateMasks CM;
+    for (int cellIdx = 0; cellIdx < CM::PaddedCells; ++cellIdx)
+    {
+      const bool pad = cellIdx >= CM::NumCells;
+      row[cellIdx] = pad ? 0 : CM::RowUnit + CM::CellY(cellIdx);
+      column[cellIdx] = pad ? 0 : CM::ColumnUnit + CM::CellX(cellIdx);
+      box[cellIdx] = pad ? 0 : CM::BoxUnit + CM::CellBox(cellIdx);
+    }
+    // Lines hold the row then the column; peers add the rest of the box.
+    for (int cellIdx = 0; cellIdx < CM::NumCells; ++cellIdx)
+    {
+      const int x = CM::CellX(cellIdx);
+      const int y = CM::CellY(cellIdx);
+      int numPeers = 0;
+      for (int i = 0; i < CM::Dim; ++i)
+      {
+        if (i != x) { peers[cellIdx][numPeers++] = CM::CellIndex(i, y); }
+      }
+      for (int i = 0; i < CM::Dim; ++i)
+      {
+        if (i != y) { peers[cellIdx][numPeers++] = CM::CellIndex(x, i); }
+      }
+      assert(NumLineCells == numPeers);
+      const int boxX = (x / 3) * 3;
+      const int boxY = (y / 3) * 3;
+      for (int i = boxX; i < boxX + 3; ++i)
+      {
+        for (int j = boxY; j < boxY + 3; ++j)
+        {
+          if ((i != x) && (j != y))
+          {
+            peers[cellIdx][numPeers++] = CM::CellIndex(i, j);
+          }
+        }
+      }
+      assert(NumPeers == numPeers);
+    }
+  }
+  enum { NumLineCells = 2 * (CandidateMasks::Dim - 1), };
+  enum { NumPeers = NumLineCells + 4, };
+  int row[CandidateMasks::PaddedCells];
+  int column[CandidateMasks::PaddedCells];
+  int box[CandidateMasks::PaddedCells];
+  int peers[CandidateMasks::NumCells][NumPeers];
+};
+
+inline const CandidateTables& GetCandidateTables()
+{
+  static const CandidateTables s_tables;
+  return s_tables;
+}
+
+inline int PopCount9(const unsigned int mask)
+{
+#ifdef __GNUC__
+  return __builtin_popcount(mask);
+#else
+  int count = 0;
+  for (unsigned int m = mask; m; m &= m - 1) { ++count; }
+  return count;
+#endif
+}
+
+inline int LowestBit(const unsigned int mask)
+{
+  assert(0 != mask);
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  int bit = 0;
+  while (0 == (mask & (1u << bit))) { ++bit; }
+  return bit;
+#endif
+}
+
+inline void CandidateKernelScalar(CandidateMasks* masks)
+{
+  typedef CandidateMasks CM;
+  const CandidateTables& tables = GetCandidateTables();
+  int total = 0;
+  int deadCells = 0;
+  for (int cellIdx = 0; cellIdx < CM::PaddedCells; ++cellIdx)
+  {
+    const unsigned int occ = masks->occupied[cellIdx];
+    const unsigned int blocked = occ |
+                                 masks->units[tables.row[cellIdx]] |
+                                 masks->units[tables.column[cellIdx]] |
+                                 masks->units[tables.box[cellIdx]];
+    const unsigned int cand = ~blocked & CM::AllValues;
+    const int count = PopCount9(cand);
+    masks->cells[cellIdx] = static_cast<CM::Mask>(cand);
+    masks->counts[cellIdx] = static_cast<CM::Mask>(count);
+    total += count;
+    deadCells += (0 == occ) && (0 == cand);
+  }
+  masks->total = total;
+  masks->deadCells = deadCells;
+}
+
+#ifdef HPS_CANDIDATE_SIMD
+__attribute__((target("sse4.1")))
+inline __m128i PopCountEpi32Sse(const __m128i v)
+{
+  const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                    1, 2, 2, 3, 2, 3, 3, 4);
+  const __m128i low = _mm_set1_epi8(0x0F);
+  const __m128i bytes = _mm_add_epi8(
+    _mm_shuffle_epi8(lut, _mm_and_si128(v, low)),
+    _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), low)));
+  return _mm_madd_epi16(_mm_maddubs_epi16(bytes, _mm_set1_epi8(1)),
+                        _mm_set1_epi16(1));
+}
+
+__attribute__((target("sse4.1")))
+inline int HorizontalSumEpi32Sse(const __m128i v)
+{
+  __m128i sum = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("sse4.1")))
+inline void CandidateKernelSse41(CandidateMasks* masks)
+{
+  typedef CandidateMasks CM;
+  const CandidateTables& tables = GetCandidateTables();
+  const unsigned int* units = masks->units;
+  const __m128i allValues = _mm_set1_epi32(CM::AllValues);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i total = zero;
+  __m128i dead = zero;
+  for (int cellIdx = 0; cellIdx < CM::PaddedCells; cellIdx += 8)
+  {
+    __m128i cand[2];
+    __m128i count[2];
+    for (int half = 0; half < 2; ++half)
+    {
+      const int c = cellIdx + (4 * half);
+      // SSE has no gather, so the unit masks are inserted lane by lane.
+      const __m128i unitMask = _mm_setr_epi32(
+        units[tables.row[c + 0]] | units[tables.column[c + 0]] | units[tables.box[c + 0]],
+        units[tables.row[c + 1]] | units[tables.column[c + 1]] | units[tables.box[c + 1]],
+        units[tables.row[c + 2]] | units[tables.column[c + 2]] | units[tables.box[c + 2]],
+        units[tables.row[c + 3]] | units[tables.column[c + 3]] | units[tables.box[c + 3]]);
+      const __m128i occ = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(masks->occupied + c));
+      cand[half] = _mm_andnot_si128(_mm_or_si128(occ, unitMask), allValues);
+      count[half] = PopCountEpi32Sse(cand[half]);
+      total = _mm_add_epi32(total, count[half]);
+      // Dead lanes are all ones, so subtracting counts them.
+      dead = _mm_sub_epi32(dead,
+                           _mm_and_si128(_mm_cmpeq_epi32(occ, zero),
+                                         _mm_cmpeq_epi32(cand[half], zero)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(masks->cells + cellIdx),
+                     _mm_packus_epi32(cand[0], cand[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(masks->counts + cellIdx),
+                     _mm_packus_epi32(count[0], count[1]));
+  }
+  masks->total = HorizontalSumEpi32Sse(total);
+  masks->deadCells = HorizontalSumEpi32Sse(dead);
+}
+
+__attribute__((target("avx2")))
+inline __m256i PopCountEpi32Avx2(const __m256i v)
+{
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3,
+                                       1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0F);
+  const __m256i bytes = _mm256_add_epi8(
+    _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+    _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+  return _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, _mm256_set1_epi8(1)),
+                           _mm256_set1_epi16(1));
+}
+
+__attribute__((target("avx2")))
+inline int HorizontalSumEpi32Avx2(const __m256i v)
+{
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2")))
+inline void CandidateKernelAvx2(CandidateMasks* masks)
+{
+  typedef CandidateMasks CM;
+  const CandidateTables& tables = GetCandidateTables();
+  const int* units = reinterpret_cast<const int*>(masks->units);
+  const __m256i allValues = _mm256_set1_epi32(CM::AllValues);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i total = zero;
+  __m256i dead = zero;
+  for (int cellIdx = 0; cellIdx < CM::PaddedCells; cellIdx += 16)
+  {
+    __m256i cand[2];
+    __m256i count[2];
+    for (int half = 0; half < 2; ++half)
+    {
+      const int c = cellIdx + (8 * half);
+      const __m256i rowIdx = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(tables.row + c));
+      const __m256i colIdx = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(tables.column + c));
+      const __m256i boxIdx = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(tables.box + c));
+      const __m256i unitMask = _mm256_or_si256(
+        _mm256_i32gather_epi32(units, rowIdx, 4),
+        _mm256_or_si256(_mm256_i32gather_epi32(units, colIdx, 4),
+                        _mm256_i32gather_epi32(units, boxIdx, 4)));
+      const __m256i occ = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(masks->occupied + c));
+      cand[half] = _mm256_andnot_si256(_mm256_or_si256(occ, unitMask), allValues);
+      count[half] = PopCountEpi32Avx2(cand[half]);
+      total = _mm256_add_epi32(total, count[half]);
+      dead = _mm256_sub_epi32(dead,
+                              _mm256_and_si256(_mm256_cmpeq_epi32(occ, zero),
+                                               _mm256_cmpeq_epi32(cand[half], zero)));
+    }
+    // Packing works per 128-bit lane, so restore the cell order afterwards.
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(masks->cells + cellIdx),
+                        _mm256_permute4x64_epi64(_mm256_packus_epi32(cand[0], cand[1]),
+                                                 _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(masks->counts + cellIdx),
+                        _mm256_permute4x64_epi64(_mm256_packus_epi32(count[0], count[1]),
+                                                 _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  masks->total = HorizontalSumEpi32Avx2(total);
+  masks->deadCells = HorizontalSumEpi32Avx2(dead);
+}
+#endif // HPS_CANDIDATE_SIMD
+
+} // end ns detail
+
+/// <summary> Instruction sets with a candidate kernel. </summary>
+enum CandidateKernelIsa
+{
+  CandidateKernelIsa_Scalar,
+  CandidateKernelIsa_Sse41,
+  CandidateKernelIsa_Avx2,
+};
+
+typedef void (*CandidateKernel)(CandidateMasks*);
+
+/// <summary> Test if the running CPU can execute the given kernel. </summary>
+inline bool CandidateKernelSupported(const CandidateKernelIsa isa)
+{
+  switch (isa)
+  {
+  case CandidateKernelIsa_Scalar:
+    return true;
+#ifdef HPS_CANDIDATE_SIMD
+  case CandidateKernelIsa_Sse41:
+    return __builtin_cpu_supports("sse4.1");
+  case CandidateKernelIsa_Avx2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+/// <summary> Get the kernel for an instruction set. It must be supported. </summary>
+inline CandidateKernel GetCandidateKernel(const CandidateKernelIsa isa)
+{
+  assert(CandidateKernelSupported(isa));
+  switch (isa)
+  {
+#ifdef HPS_CANDIDATE_SIMD
+  case CandidateKernelIsa_Sse41:
+    return &detail::CandidateKernelSse41;
+  case CandidateKernelIsa_Avx2:
+    return &detail::CandidateKernelAvx2;
+#endif
+  default:
+    return &detail::CandidateKernelScalar;
+  }
+}
+
+/// <summary> Best supported instruction set, detected once. </summary>
+inline CandidateKernelIsa BestCandidateKernelIsa()
+{
+  static const CandidateKernelIsa s_isa =
+    CandidateKernelSupported(CandidateKernelIsa_Avx2) ? CandidateKernelIsa_Avx2 :
+    CandidateKernelSupported(CandidateKernelIsa_Sse41) ? CandidateKernelIsa_Sse41 :
+                                                         CandidateKernelIsa_Scalar;
+  return s_isa;
+}
+
+inline void CandidateMasks::Compute()
+{
+  static const CandidateKernel s_kernel =
+    GetCandidateKernel(BestCandidateKernelIsa());
+  (*s_kernel)(this);
+}
+
+inline CandidateMasks::Delta CandidateMasks::Play(const int cellIdx,
+                                                 const int value)
+{
+  assert(!Occupied(cellIdx));
+  const int* peers = detail::GetCandidateTables().peers[cellIdx];
+  const Mask bit = ValueBit(value);
+  Delta delta;
+  delta.peers = 0;
+  delta.cell = cells[cellIdx];
+  int removed = counts[cellIdx];
+  for (int peerIdx = 0; peerIdx < detail::CandidateTables::NumPeers; ++peerIdx)
+  {
+    Mask& peer = cells[peers[peerIdx]];
+    if (peer & bit)
+    {
+      peer = static_cast<Mask>(peer & ~bit);
+      --counts[peers[peerIdx]];
+      ++removed;
+      delta.peers |= 1u << peerIdx;
+      deadCells += 0 == peer;
+    }
+  }
+  total -= removed;
+  cells[cellIdx] = 0;
+  counts[cellIdx] = 0;
+  Place(cellIdx, value);
+  return delta;
+}
+
+inline void CandidateMasks::Unplay(const int cellIdx,
+                                   const int value,
+                                   const Delta& delta)
+{
+  assert(Occupied(cellIdx));
+  const int* peers = detail::GetCandidateTables().peers[cellIdx];
+  const Mask bit = ValueBit(value);
+  units[RowUnit + CellY(cellIdx)] &= ~bit;
+  units[ColumnUnit + CellX(cellIdx)] &= ~bit;
+  units[BoxUnit + CellBox(cellIdx)] &= ~bit;
+  occupied[cellIdx] = 0;
+  cells[cellIdx] = delta.cell;
+  counts[cellIdx] = static_cast<Mask>(detail::PopCount9(delta.cell));
+  int restored = counts[cellIdx];
+  for (unsigned int peerBits = delta.peers; peerBits; peerBits &= peerBits - 1)
+  {
+    const int peerCellIdx = peers[detail::LowestBit(peerBits)];
+    deadCells -= 0 == cells[peerCellIdx];
+    cells[peerCellIdx] = static_cast<Mask>(cells[peerCellIdx] | bit);
+    ++counts[peerCellIdx];
+    ++restored;
+  }
+  total += restored;
+}
+
+inline int CandidateMasks::SudokuCountAfter(const int cellIdx,
+                                            const int value) const
+{
+  assert(!Occupied(cellIdx));
+  const detail::CandidateTables& tables = detail::GetCandidateTables();
+  const int* peers = tables.peers[cellIdx];
+  const Mask bit = ValueBit(value);
+  int removed = counts[cellIdx];
+  for (int peerIdx = 0; peerIdx < detail::CandidateTables::NumPeers; ++peerIdx)
+  {
+    removed += 0 != (cells[peers[peerIdx]] & bit);
+  }
+  return total - removed;
+}
+
+inline int CandidateMasks::ValidCountAfter(const int cellIdx,
+                                           const int value) const
+{
+  assert(!Occupied(cellIdx));
+  const detail::CandidateTables& tables = detail::GetCandidateTables();
+  const int* lines = tables.peers[cellIdx];
+  const Mask keep = static_cast<Mask>(~ValueBit(value));
+  int unoccupiedFound = 0;
+  int count = 0;
+  for (int lineIdx = 0; lineIdx < detail::CandidateTables::NumLineCells; ++lineIdx)
+  {
+    const int lineCellIdx = lines[lineIdx];
+    if (!Occupied(lineCellIdx))
+    {
+      ++unoccupiedFound;
+      count += detail::PopCount9(cells[lineCellIdx] & keep);
+    }
+  }
+  // Mirrors GenericBoard::ValidMoves: full lines free the opponent.
+  return (0 != unoccupiedFound) ? count : SudokuCountAfter(cellIdx, value);
+}
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_CANDIDATE_MASKS_H_
@@ -0,0 +1,95 @@
+#ifndef _HPS_SUDOKILL_CANDIDATE_MASKS_GTEST_H_
+#define _HPS_SUDOKILL_CANDIDATE_MASKS_GTEST_H_
+
+#include "sudokill_core.h"
+#include "sudokill_gtest_util.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_candidate_masks_gtest_h_
+{
+using namespace hps;
+using namespace hps::sudokill_gtest;
+
+/// <summary> Compare masks against the per-cell rule checks. </summary>
+void ExpectMatchesBoard(const Board& board, const CandidateMasks& masks)
+{
+  int total = 0;
+  int deadCells = 0;
+  for (int x = 0; x < Board::MaxX; ++x)
+  {
+    for (int y = 0; y < Board::MaxY; ++y)
+    {
+      const Point p(x, y);
+      const int cellIdx = CandidateMasks::CellIndex(x, y);
+      int count = 0;
+      for (int v = Board::MinValue; v <= Board::MaxValue; ++v)
+      {
+        const bool valid = board.IsSudokuValidMove(p, v);
+        EXPECT_EQ(valid, 0 != (masks.cells[cellIdx] & CandidateMasks::ValueBit(v)));
+        count += valid;
+      }
+      EXPECT_EQ(board.Occupied(p), masks.Occupied(cellIdx));
+      EXPECT_EQ(count, masks.counts[cellIdx]);
+      total += count;
+      deadCells += !board.Occupied(p) && (0 == count);
+    }
+  }
+  EXPECT_EQ(total, masks.total);
+  EXPECT_EQ(deadCells, masks.deadCells);
+}
+
+TEST(CandidateMasks, EmptyBoard)
+{
+  Board board;
+  CandidateMasks masks;
+  board.ComputeCandidates(&masks);
+  EXPECT_EQ(9 * 9 * 9, masks.total);
+  EXPECT_EQ(0, masks.deadCells);
+  ExpectMatchesBoard(board, masks);
+}
+
+TEST(CandidateMasks, AllKernels)
+{
+  const CandidateKernelIsa isas[] = { CandidateKernelIsa_Scalar,
+                                      CandidateKernelIsa_Sse41,
+                                      CandidateKernelIsa_Avx2, };
+  for (int trial = 0; trial < 50; ++trial)
+  {
+    Board board;
+    PlayRandomMoves(RandBound(80), &board);
+    CandidateMasks input;
+    board.ComputeCandidates(&input);
+    for (size_t isaIdx = 0; isaIdx < sizeof(isas) / sizeof(isas[0]); ++isaIdx)
+    {
+      if (!CandidateKernelSupported(isas[isaIdx]))
+      {
+        std::cout << "Skipping unsupported kernel " << isas[isaIdx] << "." << std::endl;
+        continue;
+      }
+      CandidateMasks masks = input;
+      (*GetCandidateKernel(isas[isaIdx]))(&masks);
+      ExpectMatchesBoard(board, masks);
+    }
+  }
+}
+
+TEST(CandidateMasks, DeadCells)
+{
+  // Column 0 holds 1-8 so (0,8) may only be 9; row 8 holds 9 elsewhere.
+  Board::MoveList presets;
+  for (int y = 0; y < 8; ++y)
+  {
+    presets.push_back(Cell(Point(0, y), y + 1));
+  }
+  presets.push_back(Cell(Point(4, 8), 9));
+  Board board(presets);
+  CandidateMasks masks;
+  board.ComputeCandidates(&masks);
+  EXPECT_EQ(0, masks.cells[CandidateMasks::CellIndex(0, 8)]);
+  EXPECT_EQ(1, masks.deadCells);
+  ExpectMatchesBoard(board, masks);
+}
+
+}
+
+#endif //_HPS_SUDOKILL_CANDIDATE_MASKS_GTEST_H_
@@ -0,0 +1,274 @@
+#ifndef _HPS_SUDOKILL_COMPACT_BOARD_H_
+#define _HPS_SUDOKILL_COMPACT_BOARD_H_
+#include "sudokill_core.h"
+#include <string.h>
+#include <stdint.h>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> A fixed-size, trivially copyable board snapshot. </summary>
+/// <remarks>
+///   <para> Values are packed two cells per byte next to the used-value masks
+///     of every row, column and box and the last move, so that the whole
+///     state is 96 bytes. Copying it is a memcpy and needs no allocation,
+///     which makes it the form for snapshots, hashing, records and the wire.
+///   </para>
+///   <para> Only the last move of the players is kept. Converting back to a
+///     Board therefore yields every other cell as a preset followed by the
+///     last move, which plays identically but has GetPlayerMovesCount() of 1.
+///   </para>
+/// </remarks>
+struct CompactBoard
+{
+  typedef CandidateMasks CM;
+
+  enum { NumCells = CM::NumCells, };
+  enum { PackedBytes = (NumCells + 1) / 2, };
+  enum { NoLastMove = 0xFF, };
+
+  /// <summary> Make an empty board. </summary>
+  inline void Clear()
+  {
+    memset(this, 0, sizeof(*this));
+    lastMove = NoLastMove;
+  }
+
+  /// <summary> Snapshot a Board. </summary>
+  static CompactBoard FromBoard(const Board& board)
+  {
+    CompactBoard compact;
+    compact.Clear();
+    const Board::MoveList& occupied = board.GetOccupied();
+    for (Board::MoveList::const_iterator cell = occupied.begin();
+         cell != occupied.end();
+         ++cell)
+    {
+      compact.Place(CM::CellIndex(cell->location.x, cell->location.y),
+                    cell->value);
+    }
+    if (board.GetPlayerMovesCount() > 0)
+    {
+      const Cell& last = board.GetLastMove();
+      compact.lastMove = static_cast<unsigned char>(
+        CM::CellIndex(last.location.x, last.location.y));
+    }
+    return compact;
+  }
+
+  /// <summary> Split into presets and the last move, as a server sends them. </summary>
+  /// <returns> True when there is a last move. </returns>
+  bool ToMoveList(Board::MoveList* presets, Cell* last) const
+  {
+    assert(presets && last);
+    presets->clear();
+    for (int cellIdx = 0; cellIdx < NumCells; ++cellIdx)
+    {
+      if (Occupied(cellIdx) && (cellIdx != lastMove))
+      {
+        presets->push_back(MakeCell(cellIdx));
+      }
+    }
+    if (NoLastMove == lastMove)
+    {
+      return false;
+    }
+    *last = MakeCell(lastMove);
+    return true;
+  }
+
+  /// <summary> Rebuild a Board from the snapshot. </summary>
+  void ToBoard(Board* board) const
+  {
+    assert(board);
+    Board::MoveList presets;
+    Cell last;
+    const bool hasLast = ToMoveList(&presets, &last);
+    *board = Board(presets);
+    if (hasLast)
+    {
+      board->PlayMove(last);
+    }
+  }
+
+  inline int ValueAt(const int cellIdx) const
+  {
+    const unsigned char packed = cells[cellIdx >> 1];
+    return (cellIdx & 1) ? (packed >> 4) : (packed & 0x0F);
+  }
+
+  inline bool Occupied(const int cellIdx) const
+  {
+    return Board::Empty != ValueAt(cellIdx);
+  }
+
+  inline bool HasLastMove() const
+  {
+    return NoLastMove != lastMove;
+  }
+
+  /// <summary> Test Sudoku rules for value at the cell. </summary>
+  inline bool IsSudokuValidMove(const int cellIdx, const int value) const
+  {
+    return !Occupied(cellIdx) && (0 == (UsedMask(cellIdx) & CM::ValueBit(value)));
+  }
+
+  /// <summary> Test Sudokill rules, as in GenericBoard::IsValidMove. </summary>
+  bool IsValidMove(const Cell& cell) const
+  {
+    const Point& p = cell.location;
+    if ((p.x < 0) || (p.x >= CM::Dim) || (p.y < 0) || (p.y >= CM::Dim) ||
+        (cell.value < Board::MinValue) || (cell.value > Board::MaxValue) ||
+        !IsSudokuValidMove(CM::CellIndex(p.x, p.y), cell.value))
+    {
+      return false;
+    }
+    if (!HasLastMove())
+    {
+      return true;
+    }
+    const int lastX = CM::CellX(lastMove);
+    const int lastY = CM::CellY(lastMove);
+    if ((lastX == p.x) || (lastY == p.y))
+    {
+      return true;
+    }
+    // Anywhere goes only when the last move's row and column are full.
+    for (int i = 0; i < CM::Dim; ++i)
+    {
+      if (!Occupied(CM::CellIndex(i, lastY)) || !Occupied(CM::CellIndex(lastX, i)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Apply a valid move. There is no undo: copy instead. </summary>
+  inline void PlayMove(const Cell& cell)
+  {
+    assert(IsValidMove(cell));
+    const int cellIdx = CM::CellIndex(cell.location.x, cell.location.y);
+    Place(cellIdx, cell.value);
+    lastMove = static_cast<unsigned char>(cellIdx);
+  }
+
+  /// <summary> Sudokill-valid moves in the same order as
+  ///   GenericBoard::ValidMoves.
+  /// </summary>
+  void ValidMoves(Board::MoveList* moveBuffer) const
+  {
+    assert(moveBuffer);
+    moveBuffer->clear();
+    if (HasLastMove())
+    {
+      const int lastX = CM::CellX(lastMove);
+      const int lastY = CM::CellY(lastMove);
+      int unoccupiedFound = 0;
+      for (int x = 0; x < CM::Dim; ++x)
+      {
+        unoccupiedFound += PushCandidates(CM::CellIndex(x, lastY), moveBuffer);
+      }
+      for (int y = 0; y < CM::Dim; ++y)
+      {
+        unoccupiedFound += PushCandidates(CM::CellIndex(lastX, y), moveBuffer);
+      }
+      if (0 != unoccupiedFound)
+      {
+        return;
+      }
+    }
+    for (int x = 0; x < CM::Dim; ++x)
+    {
+      for (int y = 0; y < CM::Dim; ++y)
+      {
+        PushCandidates(CM::CellIndex(x, y), moveBuffer);
+      }
+    }
+  }
+
+  /// <summary> 64-bit hash of the cells and the last move. </summary>
+  inline uint64_t Hash() const
+  {
+    uint64_t words[6];
+    memset(words, 0, sizeof(words));
+    memcpy(words, cells, sizeof(cells));
+    reinterpret_cast<unsigned char*>(words)[sizeof(cells)] = lastMove;
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 6; ++i)
+    {
+      h ^= words[i];
+      h *= 0xBF58476D1CE4E5B9ULL;
+      h ^= h >> 31;
+    }
+    return h;
+  }
+
+  inline bool operator==(const CompactBoard& rhs) const
+  {
+    return (0 == memcmp(cells, rhs.cells, sizeof(cells))) &&
+           (lastMove == rhs.lastMove);
+  }
+  inline bool operator!=(const CompactBoard& rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+  /// <summary> Two 4-bit values per byte, even cells in the low nibble. </summary>
+  unsigned char cells[PackedBytes];
+  /// <summary> Cell index of the players' last move, or NoLastMove. </summary>
+  unsigned char lastMove;
+  /// <summary> Used values per row, column and box as in CandidateMasks. </summary>
+  unsigned short units[CM::NumUnits];
+
+private:
+  inline void Place(const int cellIdx, const int value)
+  {
+    assert(!Occupied(cellIdx));
+    cells[cellIdx >> 1] |= static_cast<unsigned char>(
+      (cellIdx & 1) ? (value << 4) : value);
+    const unsigned short bit = CM::ValueBit(value);
+    units[CM::RowUnit + CM::CellY(cellIdx)] |= bit;
+    units[CM::ColumnUnit + CM::CellX(cellIdx)] |= bit;
+    units[CM::BoxUnit + CM::CellBox(cellIdx)] |= bit;
+  }
+
+  inline unsigned int UsedMask(const int cellIdx) const
+  {
+    return units[CM::RowUnit + CM::CellY(cellIdx)] |
+           units[CM::ColumnUnit + CM::CellX(cellIdx)] |
+           units[CM::BoxUnit + CM::CellBox(cellIdx)];
+  }
+
+  inline Cell MakeCell(const int cellIdx) const
+  {
+    return Cell(Point(CM::CellX(cellIdx), CM::CellY(cellIdx)), ValueAt(cellIdx));
+  }
+
+  /// <returns> 1 when the cell is empty, else 0. </returns>
+  inline int PushCandidates(const int cellIdx, Board::MoveList* moveBuffer) const
+  {
+    if (Occupied(cellIdx))
+    {
+      return 0;
+    }
+    const unsigned int candidates = ~UsedMask(cellIdx) & CM::AllValues;
+    const Point p(CM::CellX(cellIdx), CM::CellY(cellIdx));
+    for (int v = Board::MinValue; v <= Board::MaxValue; ++v)
+    {
+      if (candidates & CM::ValueBit(v))
+      {
+        moveBuffer->push_back(Cell(p, v));
+      }
+    }
+    return 1;
+  }
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_COMPACT_BOARD_H_
@@ -0,0 +1,88 @@
+#ifndef _HPS_SUDOKILL_COMPACT_BOARD_GTEST_H_
+#define _HPS_SUDOKILL_COMPACT_BOARD_GTEST_H_
+
+#include "compact_board.h"
+#include "gtest/gtest.h"
+#include <type_traits>
+
+namespace _hps_sudokill_compact_board_gtest_h_
+{
+using namespace hps;
+
+TEST(CompactBoard, Layout)
+{
+  EXPECT_TRUE(std::is_trivially_copyable<CompactBoard>::value);
+  EXPECT_LE(sizeof(CompactBoard), 128u);
+}
+
+TEST(CompactBoard, MatchesBoard)
+{
+  Board::MoveList moves;
+  Board::MoveList compactMoves;
+  for (int trial = 0; trial < 20; ++trial)
+  {
+    Board board;
+    for (;;)
+    {
+      const CompactBoard compact = CompactBoard::FromBoard(board);
+      board.ValidMoves(&moves);
+      compact.ValidMoves(&compactMoves);
+      ASSERT_EQ(moves.size(), compactMoves.size());
+      for (size_t moveIdx = 0; moveIdx < moves.size(); ++moveIdx)
+      {
+        ASSERT_EQ(moves[moveIdx], compactMoves[moveIdx]);
+        ASSERT_TRUE(compact.IsValidMove(moves[moveIdx]));
+      }
+      for (int x = 0; x < Board::MaxX; ++x)
+      {
+        for (int y = 0; y < Board::MaxY; ++y)
+        {
+          const int cellIdx = CandidateMasks::CellIndex(x, y);
+          ASSERT_EQ(board.ValueAt(Point(x, y)), compact.ValueAt(cellIdx));
+          for (int v = Board::MinValue; v <= Board::MaxValue; ++v)
+          {
+            ASSERT_EQ(board.IsValidMove(Point(x, y), v),
+                      compact.IsValidMove(Cell(Point(x, y), v)));
+          }
+        }
+      }
+      if (moves.empty())
+      {
+        break;
+      }
+      const Cell& move = moves[RandBound(static_cast<int>(moves.size()))];
+      // Playing on the snapshot matches snapshotting after the play.
+      CompactBoard played = compact;
+      played.PlayMove(move);
+      board.PlayMove(move);
+      ASSERT_TRUE(played == CompactBoard::FromBoard(board));
+      ASSERT_EQ(played.Hash(), CompactBoard::FromBoard(board).Hash());
+      ASSERT_NE(compact.Hash(), played.Hash());
+    }
+  }
+}
+
+TEST(CompactBoard, RoundTrip)
+{
+  Board::MoveList presets;
+  presets.push_back(Cell(Point(0, 0), 5));
+  presets.push_back(Cell(Point(0, 3), 4));
+  Board board(presets);
+  board.PlayMove(Cell(Point(4, 3), 8));
+  board.PlayMove(Cell(Point(4, 7), 2));
+  const CompactBoard compact = CompactBoard::FromBoard(board);
+  Board restored;
+  compact.ToBoard(&restored);
+  EXPECT_EQ(board.GetOccupied().size(), restored.GetOccupied().size());
+  EXPECT_EQ(board.GetLastMove(), restored.GetLastMove());
+  EXPECT_TRUE(compact == CompactBoard::FromBoard(restored));
+  Board::MoveList moves;
+  Board::MoveList restoredMoves;
+  board.ValidMoves(&moves);
+  restored.ValidMoves(&restoredMoves);
+  EXPECT_EQ(moves, restoredMoves);
+}
+
+}
+
+#endif //_HPS_SUDOKILL_COMPACT_BOARD_GTEST_H_
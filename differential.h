@@ -0,0 +1,398 @@
+#ifndef _HPS_SUDOKILL_DIFFERENTIAL_H_
+#define _HPS_SUDOKILL_DIFFERENTIAL_H_
+#include "sudokill_core.h"
+#include "reference_board.h"
+#include "compact_board.h"
+#include "evaluation.h"
+#include "rand_bound.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> One step of a differential trace. </summary>
+struct DiffStep
+{
+  enum Op { Op_Play, Op_Undo, };
+
+  DiffStep() : op(Op_Play), ply() {}
+  explicit DiffStep(const Cell& ply_) : op(Op_Play), ply(ply_) {}
+  static DiffStep Undo()
+  {
+    DiffStep step;
+    step.op = Op_Undo;
+    return step;
+  }
+
+  Op op;
+  Cell ply;
+};
+
+/// <summary> A starting position and the steps played from it. </summary>
+struct DiffTrace
+{
+  Board::MoveList presets;
+  std::vector<DiffStep> steps;
+};
+
+/// <summary> Differential tester of a board against ReferenceBoard. </summary>
+/// <remarks>
+///   <para> Random traces of plays and undos run through both boards, which
+///     are compared after every step on ValueAt, IsValidMove and
+///     IsSudokuValidMove of every (cell, value), ValidMoves and
+///     SudokuValidMoves as sets, the CompactBoard snapshot and the
+///     ShrinkPossibleMovesEvaluationFunc scores. A failing trace is shrunk
+///     by removing steps and presets for as long as it still fails.
+///   </para>
+///   <para> FastBoard is Board or a type with its interface, which lets the
+///     tests plant a bug.
+///   </para>
+/// </remarks>
+template <typename FastBoard>
+struct GenericDifferential
+{
+  typedef Board::MoveList MoveList;
+
+  enum { MaxCheckedChildren = 8, };
+
+  /// <summary> Play a random trace, comparing after every step. </summary>
+  /// <returns> True when the boards agree; else trace holds the steps up to
+  ///   the first divergence and what describes it.
+  /// </returns>
+  static bool RunRandom(Rng& rng, const int maxSteps, DiffTrace* trace, std::string* what)
+  {
+    assert(trace && what);
+    trace->presets.clear();
+    trace->steps.clear();
+    MoveList moves;
+    // Start from presets now and then, as a server might.
+    if (0 == rng.Bound(4))
+    {
+      ReferenceBoard presetBoard;
+      const int numPresets = static_cast<int>(rng.Bound(25));
+      for (int presetIdx = 0; presetIdx < numPresets; ++presetIdx)
+      {
+        presetBoard.SudokuValidMoves(&moves);
+        if (moves.empty())
+        {
+          break;
+        }
+        trace->presets.push_back(moves[rng.Bound(static_cast<uint32_t>(moves.size()))]);
+        presetBoard = ReferenceBoard(trace->presets);
+      }
+    }
+    ReferenceBoard reference(trace->presets);
+    FastBoard fast(trace->presets);
+    if (!Compare(reference, fast, what))
+    {
+      return false;
+    }
+    for (int stepIdx = 0; stepIdx < maxSteps; ++stepIdx)
+    {
+      DiffStep step;
+      reference.ValidMoves(&moves);
+      if ((reference.GetPlayerMovesCount() > 0) &&
+          (moves.empty() || (0 == rng.Bound(5))))
+      {
+        step = DiffStep::Undo();
+      }
+      else if (moves.empty())
+      {
+        break;
+      }
+      else
+      {
+        step = DiffStep(moves[rng.Bound(static_cast<uint32_t>(moves.size()))]);
+      }
+      trace->steps.push_back(step);
+      Apply(step, &reference, &fast);
+      if (!Compare(reference, fast, what))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Replay a trace, comparing after every step. </summary>
+  /// <remarks>
+  ///   <para> Plays that the reference rejects and undos with no player
+  ///     moves are skipped, so that any subsequence of a trace replays.
+  ///   </para>
+  /// </remarks>
+  static bool Replay(const DiffTrace& trace, std::string* what)
+  {
+    assert(what);
+    // Presets that break Sudoku rules are not positions at all.
+    ReferenceBoard presetBoard;
+    for (MoveList::const_iterator preset = trace.presets.begin();
+         preset != trace.presets.end();
+         ++preset)
+    {
+      if (!presetBoard.IsSudokuValidMove(preset->location, preset->value))
+      {
+        *what = "invalid presets";
+        return true;
+      }
+      MoveList placed = presetBoard.GetOccupied();
+      placed.push_back(*preset);
+      presetBoard = ReferenceBoard(placed);
+    }
+    ReferenceBoard reference(trace.presets);
+    FastBoard fast(trace.presets);
+    if (!Compare(reference, fast, what))
+    {
+      return false;
+    }
+    for (std::vector<DiffStep>::const_iterator step = trace.steps.begin();
+         step != trace.steps.end();
+         ++step)
+    {
+      if ((DiffStep::Op_Play == step->op) ? !reference.IsValidMove(step->ply)
+                                          : (0 == reference.GetPlayerMovesCount()))
+      {
+        continue;
+      }
+      Apply(*step, &reference, &fast);
+      if (!Compare(reference, fast, what))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Remove steps and presets while the trace still fails. </summary>
+  static void Shrink(DiffTrace* trace)
+  {
+    assert(trace);
+    std::string what;
+    bool removed = true;
+    while (removed)
+    {
+      removed = false;
+      // Drop chunks first, halving down to single steps.
+      for (size_t chunk = std::max<size_t>(trace->steps.size() / 2, 1); chunk > 0; chunk /= 2)
+      {
+        for (size_t begin = 0; begin < trace->steps.size();)
+        {
+          DiffTrace candidate = *trace;
+          const size_t end = std::min(begin + chunk, candidate.steps.size());
+          candidate.steps.erase(candidate.steps.begin() + begin,
+                                candidate.steps.begin() + end);
+          if (!Replay(candidate, &what))
+          {
+            *trace = candidate;
+            removed = true;
+          }
+          else
+          {
+            begin += chunk;
+          }
+        }
+      }
+      for (size_t presetIdx = 0; presetIdx < trace->presets.size();)
+      {
+        DiffTrace candidate = *trace;
+        candidate.presets.erase(candidate.presets.begin() + presetIdx);
+        if (!Replay(candidate, &what))
+        {
+          *trace = candidate;
+          removed = true;
+        }
+        else
+        {
+          ++presetIdx;
+        }
+      }
+    }
+  }
+
+  /// <summary> Compare every observable of the two boards. </summary>
+  static bool Compare(const ReferenceBoard& reference, const FastBoard& fast, std::string* what)
+  {
+    assert(what);
+    std::stringstream ss;
+    MoveList validMoves;
+    MoveList sudokuMoves;
+    MoveList actual;
+    reference.ValidMoves(&validMoves);
+    reference.SudokuValidMoves(&sudokuMoves);
+    // Single queries are checked against the move lists, which is as strict
+    // as asking the reference for each and much faster.
+    bool isValid[CandidateMasks::NumCells][Board::MaxValue + 1] = {};
+    bool isSudokuValid[CandidateMasks::NumCells][Board::MaxValue + 1] = {};
+    for (MoveList::const_iterator move = validMoves.begin(); move != validMoves.end(); ++move)
+    {
+      isValid[CandidateMasks::CellIndex(move->location.x, move->location.y)][move->value] = true;
+    }
+    for (MoveList::const_iterator move = sudokuMoves.begin(); move != sudokuMoves.end(); ++move)
+    {
+      isSudokuValid[CandidateMasks::CellIndex(move->location.x, move->location.y)][move->value] = true;
+    }
+    for (int x = 0; x < Board::MaxX; ++x)
+    {
+      for (int y = 0; y < Board::MaxY; ++y)
+      {
+        const Point p(x, y);
+        if (reference.ValueAt(p) != fast.ValueAt(p))
+        {
+          ss << "ValueAt(" << x << "," << y << "): " << reference.ValueAt(p)
+             << " != " << fast.ValueAt(p);
+          *what = ss.str();
+          return false;
+        }
+        const int cellIdx = CandidateMasks::CellIndex(x, y);
+        for (int v = Board::MinValue; v <= Board::MaxValue; ++v)
+        {
+          if (isValid[cellIdx][v] != fast.IsValidMove(Cell(p, v)))
+          {
+            ss << "IsValidMove(" << x << "," << y << "," << v << "): "
+               << isValid[cellIdx][v] << " != " << !isValid[cellIdx][v];
+            *what = ss.str();
+            return false;
+          }
+          if (isSudokuValid[cellIdx][v] != fast.IsSudokuValidMove(p, v))
+          {
+            ss << "IsSudokuValidMove(" << x << "," << y << "," << v << "): "
+               << isSudokuValid[cellIdx][v] << " != " << !isSudokuValid[cellIdx][v];
+            *what = ss.str();
+            return false;
+          }
+        }
+      }
+    }
+
+    fast.ValidMoves(&actual);
+    if (!SameSet(&validMoves, &actual))
+    {
+      *what = "ValidMoves";
+      return false;
+    }
+    const CompactBoard compact = CompactBoard::FromBoard(fast);
+    compact.ValidMoves(&actual);
+    if (!SameSet(&validMoves, &actual))
+    {
+      *what = "CompactBoard::ValidMoves";
+      return false;
+    }
+    // SudokuValidMoves appends.
+    actual.clear();
+    fast.SudokuValidMoves(&actual);
+    if (!SameSet(&sudokuMoves, &actual))
+    {
+      *what = "SudokuValidMoves";
+      return false;
+    }
+
+    const ShrinkPossibleMovesEvaluationFunc evaluate;
+    if (static_cast<int>(sudokuMoves.size()) != evaluate(fast))
+    {
+      ss << "evaluation: " << sudokuMoves.size() << " != " << evaluate(fast);
+      *what = ss.str();
+      return false;
+    }
+    // The children scores should be those of the boards after each ply.
+    // The reference is slow, so check a spread of at most MaxCheckedChildren.
+    std::vector<ChildEvaluation> evals(validMoves.size());
+    if (!evals.empty())
+    {
+      evaluate.EvaluateChildren(fast, validMoves, &evals[0]);
+    }
+    ReferenceBoard child = reference;
+    MoveList childMoves;
+    const size_t stride = 1 + (validMoves.size() / MaxCheckedChildren);
+    for (size_t plyIdx = 0; plyIdx < validMoves.size(); plyIdx += stride)
+    {
+      const Cell& ply = validMoves[plyIdx];
+      child.PlayMove(ply);
+      child.SudokuValidMoves(&childMoves);
+      const int score = static_cast<int>(childMoves.size());
+      child.ValidMoves(&childMoves);
+      const bool terminal = childMoves.empty();
+      child.Undo();
+      if ((score != evals[plyIdx].score) || (terminal != evals[plyIdx].terminal))
+      {
+        ss << "EvaluateChildren(" << ply.location.x << "," << ply.location.y
+           << "," << ply.value << "): (" << score << "," << terminal
+           << ") != (" << evals[plyIdx].score << "," << evals[plyIdx].terminal << ")";
+        *what = ss.str();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Print a trace as C++ that rebuilds it. </summary>
+  static void Print(const DiffTrace& trace, std::ostream& out)
+  {
+    out << "DiffTrace trace;\n";
+    for (MoveList::const_iterator preset = trace.presets.begin();
+         preset != trace.presets.end();
+         ++preset)
+    {
+      out << "trace.presets.push_back(Cell(Point(" << preset->location.x << ", "
+          << preset->location.y << "), " << preset->value << "));\n";
+    }
+    for (std::vector<DiffStep>::const_iterator step = trace.steps.begin();
+         step != trace.steps.end();
+         ++step)
+    {
+      if (DiffStep::Op_Undo == step->op)
+      {
+        out << "trace.steps.push_back(DiffStep::Undo());\n";
+      }
+      else
+      {
+        out << "trace.steps.push_back(DiffStep(Cell(Point(" << step->ply.location.x
+            << ", " << step->ply.location.y << "), " << step->ply.value << ")));\n";
+      }
+    }
+  }
+
+private:
+  static void Apply(const DiffStep& step, ReferenceBoard* reference, FastBoard* fast)
+  {
+    if (DiffStep::Op_Undo == step.op)
+    {
+      reference->Undo();
+      fast->Undo();
+    }
+    else
+    {
+      reference->PlayMove(step.ply);
+      fast->PlayMove(step.ply);
+    }
+  }
+
+  struct CellLess
+  {
+    inline bool operator()(const Cell& lhs, const Cell& rhs) const
+    {
+      if (lhs.location.x != rhs.location.x) { return lhs.location.x < rhs.location.x; }
+      if (lhs.location.y != rhs.location.y) { return lhs.location.y < rhs.location.y; }
+      return lhs.value < rhs.value;
+    }
+  };
+
+  /// <summary> Compare as sets; sorts both lists. </summary>
+  static bool SameSet(MoveList* lhs, MoveList* rhs)
+  {
+    std::sort(lhs->begin(), lhs->end(), CellLess());
+    std::sort(rhs->begin(), rhs->end(), CellLess());
+    return *lhs == *rhs;
+  }
+};
+
+typedef GenericDifferential<Board> Differential;
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_DIFFERENTIAL_H_
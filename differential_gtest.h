@@ -0,0 +1,66 @@
+#ifndef _HPS_SUDOKILL_DIFFERENTIAL_GTEST_H_
+#define _HPS_SUDOKILL_DIFFERENTIAL_GTEST_H_
+
+#include "differential.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_differential_gtest_h_
+{
+using namespace hps;
+
+/// <summary> A board that forgets one ply. </summary>
+struct BuggyBoard : public Board
+{
+  BuggyBoard() : Board() {}
+  explicit BuggyBoard(const MoveList& preset) : Board(preset) {}
+
+  void ValidMoves(MoveList* moveBuffer) const
+  {
+    Board::ValidMoves(moveBuffer);
+    moveBuffer->erase(std::remove(moveBuffer->begin(), moveBuffer->end(),
+                                  Cell(Point(4, 4), 9)),
+                      moveBuffer->end());
+  }
+};
+
+TEST(Differential, BoardMatchesReference)
+{
+  Rng rng(RandBound(1 << 30));
+  DiffTrace trace;
+  std::string what;
+  for (int trial = 0; trial < 10; ++trial)
+  {
+    const bool agree = Differential::RunRandom(rng, 60, &trace, &what);
+    if (!agree)
+    {
+      Differential::Shrink(&trace);
+      Differential::Print(trace, std::cerr);
+    }
+    ASSERT_TRUE(agree) << what;
+  }
+}
+
+TEST(Differential, ShrinksDivergence)
+{
+  typedef GenericDifferential<BuggyBoard> BuggyDifferential;
+  Rng rng(7);
+  DiffTrace trace;
+  std::string what;
+  bool agree = true;
+  for (int trial = 0; agree && (trial < 100); ++trial)
+  {
+    agree = BuggyDifferential::RunRandom(rng, 100, &trace, &what);
+  }
+  ASSERT_FALSE(agree);
+  BuggyDifferential::Shrink(&trace);
+  EXPECT_FALSE(BuggyDifferential::Replay(trace, &what));
+  EXPECT_EQ(std::string("ValidMoves"), what);
+  // Without presets the bug shows at once; after a move in row or column 4
+  // it takes one ply.
+  EXPECT_TRUE(trace.presets.empty());
+  EXPECT_LE(trace.steps.size(), 1u);
+}
+
+}
+
+#endif //_HPS_SUDOKILL_DIFFERENTIAL_GTEST_H_
@@ -0,0 +1,902 @@
+#ifndef _HPS_SUDOKILL_DISTRIBUTED_H_
+#define _HPS_SUDOKILL_DISTRIBUTED_H_
+#include "sudokill_core.h"
+#include "alphabetapruning.h"
+#include "eval_weights.h"
+#include "game_record.h"
+#include "log.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Frames and sockets of the distributed search. </summary>
+/// <remarks>
+///   <para> A frame is a little-endian uint32 payload size, a message type
+///     byte and the payload. The master opens with Msg_Hello, then sends
+///     one Msg_Search at a time to each worker, which answers each with one
+///     Msg_Result, including searches cut short by Msg_Stop.
+///     <code>
+///       Msg_Hello   uint8 version, int32 per EvalWeights field
+///       Msg_Search  uint32 job, uint8 depth, uint8 ply cell, uint8 ply value,
+///                   root position as a GameRecord
+///       Msg_Stop    (empty)
+///       Msg_Result  uint32 job, int32 score, uint64 nodes, uint8 selective
+///                   depth, uint8 complete
+///     </code>
+///   </para>
+///   <para> Addresses are "unix:PATH" for a UNIX socket, or "HOST:PORT" for
+///     TCP; a worker listens on "PORT" for every interface.
+///   </para>
+/// </remarks>
+struct DistributedProtocol
+{
+  enum { Version = 1, };
+  enum { MaxPayload = 256, };
+  enum
+  {
+    Msg_Hello = 1,
+    Msg_Search = 2,
+    Msg_Stop = 3,
+    Msg_Result = 4,
+  };
+
+  typedef std::vector<unsigned char> Bytes;
+
+  static bool SendFrame(const int fd, const int type, const Bytes& payload)
+  {
+    assert(payload.size() <= MaxPayload);
+    Bytes frame;
+    Put(payload.size(), 4, &frame);
+    frame.push_back(static_cast<unsigned char>(type));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return SendAll(fd, &frame[0], frame.size());
+  }
+
+  /// <summary> Block for the next frame; false on a closed or bad stream. </summary>
+  static bool ReceiveFrame(const int fd, int* type, Bytes* payload)
+  {
+    assert(type && payload);
+    unsigned char header[5];
+    if (!ReceiveAll(fd, header, sizeof(header)))
+    {
+      return false;
+    }
+    const size_t size = static_cast<size_t>(Get(header, 4));
+    if (size > MaxPayload)
+    {
+      return false;
+    }
+    *type = header[4];
+    payload->resize(size);
+    return (0 == size) || ReceiveAll(fd, &(*payload)[0], size);
+  }
+
+  inline static void Put(const uint64_t value, const int numBytes, Bytes* bytes)
+  {
+    for (int byteIdx = 0; byteIdx < numBytes; ++byteIdx)
+    {
+      bytes->push_back(static_cast<unsigned char>(value >> (8 * byteIdx)));
+    }
+  }
+
+  inline static uint64_t Get(const unsigned char* bytes, const int numBytes)
+  {
+    uint64_t value = 0;
+    for (int byteIdx = numBytes - 1; byteIdx >= 0; --byteIdx)
+    {
+      value = (value << 8) | bytes[byteIdx];
+    }
+    return value;
+  }
+
+  /// <summary> Connect to a listening worker; -1 on failure. </summary>
+  static int Connect(const std::string& address)
+  {
+    if (IsUnix(address))
+    {
+      sockaddr_un addr;
+      if (!UnixAddress(address, &addr))
+      {
+        return -1;
+      }
+      const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if ((fd >= 0) && (0 != connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))))
+      {
+        close(fd);
+        return -1;
+      }
+      return fd;
+    }
+    const size_t colon = address.rfind(':');
+    if (std::string::npos == colon)
+    {
+      return -1;
+    }
+    addrinfo* found = Resolve(address.substr(0, colon), address.substr(colon + 1), 0);
+    int fd = -1;
+    for (addrinfo* ai = found; (NULL != ai) && (fd < 0); ai = ai->ai_next)
+    {
+      fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+      if ((fd >= 0) && (0 != connect(fd, ai->ai_addr, ai->ai_addrlen)))
+      {
+        close(fd);
+        fd = -1;
+      }
+    }
+    if (NULL != found)
+    {
+      freeaddrinfo(found);
+    }
+    NoDelay(fd);
+    return fd;
+  }
+
+  /// <summary> Listen for masters; -1 on failure. </summary>
+  static int Listen(const std::string& address)
+  {
+    int fd = -1;
+    if (IsUnix(address))
+    {
+      sockaddr_un addr;
+      if (!UnixAddress(address, &addr))
+      {
+        return -1;
+      }
+      unlink(addr.sun_path);
+      fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if ((fd >= 0) && (0 != bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))))
+      {
+        close(fd);
+        fd = -1;
+      }
+    }
+    else
+    {
+      const size_t colon = address.rfind(':');
+      const std::string host = (std::string::npos == colon) ? std::string() :
+                               address.substr(0, colon);
+      const std::string port = (std::string::npos == colon) ? address :
+                               address.substr(colon + 1);
+      addrinfo* found = Resolve(host, port, AI_PASSIVE);
+      for (addrinfo* ai = found; (NULL != ai) && (fd < 0); ai = ai->ai_next)
+      {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        const int reuse = 1;
+        if ((fd >= 0) &&
+            ((0 != setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse))) ||
+             (0 != bind(fd, ai->ai_addr, ai->ai_addrlen))))
+        {
+          close(fd);
+          fd = -1;
+        }
+      }
+      if (NULL != found)
+      {
+        freeaddrinfo(found);
+      }
+    }
+    if ((fd >= 0) && (0 != listen(fd, 8)))
+    {
+      close(fd);
+      fd = -1;
+    }
+    return fd;
+  }
+
+  /// <summary> Accept the next master; -1 on failure. </summary>
+  static int Accept(const int listenFd)
+  {
+    int fd;
+    do
+    {
+      fd = accept(listenFd, NULL, NULL);
+    } while ((fd < 0) && (EINTR == errno));
+    NoDelay(fd);
+    return fd;
+  }
+
+private:
+  static bool SendAll(const int fd, const unsigned char* data, size_t size)
+  {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while (size > 0)
+    {
+      const ssize_t sent = send(fd, data, size, flags);
+      if (sent < 0)
+      {
+        if (EINTR == errno)
+        {
+          continue;
+        }
+        return false;
+      }
+      data += sent;
+      size -= static_cast<size_t>(sent);
+    }
+    return true;
+  }
+
+  static bool ReceiveAll(const int fd, unsigned char* data, size_t size)
+  {
+    while (size > 0)
+    {
+      const ssize_t received = recv(fd, data, size, 0);
+      if (received <= 0)
+      {
+        if ((received < 0) && (EINTR == errno))
+        {
+          continue;
+        }
+        return false;
+      }
+      data += received;
+      size -= static_cast<size_t>(received);
+    }
+    return true;
+  }
+
+  inline static bool IsUnix(const std::string& address)
+  {
+    return 0 == address.compare(0, 5, "unix:");
+  }
+
+  static bool UnixAddress(const std::string& address, sockaddr_un* addr)
+  {
+    const std::string path = address.substr(5);
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path.empty() || (path.size() >= sizeof(addr->sun_path)))
+    {
+      return false;
+    }
+    memcpy(addr->sun_path, path.c_str(), path.size());
+    return true;
+  }
+
+  static addrinfo* Resolve(const std::string& host, const std::string& port, const int flags)
+  {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = flags;
+    addrinfo* found = NULL;
+    if (0 != getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &found))
+    {
+      return NULL;
+    }
+    return found;
+  }
+
+  /// <summary> Frames are small and answered at once; do not delay them. </summary>
+  inline static void NoDelay(const int fd)
+  {
+    if (fd >= 0)
+    {
+      const int on = 1;
+      // Fails harmlessly on UNIX sockets.
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+  }
+};
+
+/// <summary> One root ply to search, as the master sends it. </summary>
+struct DistributedJob
+{
+  DistributedJob() : jobId(0), depth(0), ply(), position() {}
+
+  DistributedProtocol::Bytes Encode() const
+  {
+    DistributedProtocol::Bytes bytes;
+    DistributedProtocol::Put(jobId, 4, &bytes);
+    DistributedProtocol::Put(static_cast<uint64_t>(depth), 1, &bytes);
+    DistributedProtocol::Put(static_cast<uint64_t>(
+      CandidateMasks::CellIndex(ply.location.x, ply.location.y)), 1, &bytes);
+    DistributedProtocol::Put(static_cast<uint64_t>(ply.value), 1, &bytes);
+    const size_t recordAt = bytes.size();
+    bytes.resize(recordAt + GameRecord::RecordBytes);
+    position.Encode(&bytes[recordAt]);
+    return bytes;
+  }
+
+  bool Decode(const DistributedProtocol::Bytes& bytes)
+  {
+    if ((7 + GameRecord::RecordBytes) != bytes.size())
+    {
+      return false;
+    }
+    jobId = static_cast<uint32_t>(DistributedProtocol::Get(&bytes[0], 4));
+    depth = bytes[4];
+    const int cellIdx = bytes[5];
+    if (cellIdx >= CandidateMasks::NumCells)
+    {
+      return false;
+    }
+    ply = Cell(Point(CandidateMasks::CellX(cellIdx), CandidateMasks::CellY(cellIdx)), bytes[6]);
+    return position.Decode(&bytes[7]);
+  }
+
+  uint32_t jobId;
+  /// <summary> Depth of the master's search; the root ply is the first. </summary>
+  int depth;
+  Cell ply;
+  /// <summary> The root position, before the ply. </summary>
+  GameRecord position;
+};
+
+/// <summary> A worker's answer to one DistributedJob. </summary>
+struct DistributedResult
+{
+  DistributedResult() : jobId(0), score(0), nodes(0), selDepth(0), complete(false) {}
+
+  DistributedProtocol::Bytes Encode() const
+  {
+    DistributedProtocol::Bytes bytes;
+    DistributedProtocol::Put(jobId, 4, &bytes);
+    DistributedProtocol::Put(static_cast<uint32_t>(score), 4, &bytes);
+    DistributedProtocol::Put(static_cast<uint64_t>(nodes), 8, &bytes);
+    DistributedProtocol::Put(static_cast<uint64_t>(selDepth), 1, &bytes);
+    DistributedProtocol::Put(complete ? 1 : 0, 1, &bytes);
+    return bytes;
+  }
+
+  bool Decode(const DistributedProtocol::Bytes& bytes)
+  {
+    if (18 != bytes.size())
+    {
+      return false;
+    }
+    jobId = static_cast<uint32_t>(DistributedProtocol::Get(&bytes[0], 4));
+    score = static_cast<int32_t>(static_cast<uint32_t>(DistributedProtocol::Get(&bytes[4], 4)));
+    nodes = static_cast<long long>(DistributedProtocol::Get(&bytes[8], 8));
+    selDepth = bytes[16];
+    complete = 0 != bytes[17];
+    return true;
+  }
+
+  uint32_t jobId;
+  /// <summary> Minimax of the root ply from the root player's view. </summary>
+  int score;
+  long long nodes;
+  int selDepth;
+  /// <summary> False when the search was stopped; the score means nothing. </summary>
+  bool complete;
+};
+
+/// <summary> The worker side: searches the root plys a master sends. </summary>
+/// <remarks>
+///   <para> A worker searches the master's root with every other root ply
+///     left out, so each ply gets the full window and the extensions it
+///     would get in one process.
+///   </para>
+///   <para> The calling thread reads the master's frames while a second
+///     thread searches, so that Msg_Stop ends a search at once.
+///   </para>
+/// </remarks>
+class DistributedWorker
+{
+public:
+  explicit DistributedWorker(const ThreadPool::Options& poolOptions = ThreadPool::Options())
+  : pool(poolOptions)
+  {}
+
+  /// <summary> Search one root ply. </summary>
+  /// <returns> False when the ply is not valid in the position. </returns>
+  static bool SearchPly(const EvalWeights& weights,
+                        const DistributedJob& job,
+                        ThreadPool* pool,
+                        const std::atomic<bool>* stopSignal,
+                        AlphaBetaPruning::Params* params,
+                        DistributedResult* result)
+  {
+    assert(params && result);
+    *result = DistributedResult();
+    result->jobId = job.jobId;
+    Board state;
+    job.position.ToBoard(&state);
+    if ((job.depth < 2) || !state.IsValidMove(job.ply))
+    {
+      return false;
+    }
+    const WeightedEvaluationFunc f(weights, state.GetPlayerMovesCount());
+    params->pool = pool;
+    params->stopSignal = stopSignal;
+    params->onlyRootPlys.assign(1, job.ply);
+    // With one root ply and no transposition table, shallower iterations
+    // would order nothing for the deeper ones; search straight to the depth.
+    params->maxDepth = job.depth;
+    params->depth = 0;
+    Cell ply;
+    result->score = AlphaBetaPruning::Run(params, &state, &f, &ply);
+    result->nodes = params->nodes;
+    result->selDepth = params->selDepth;
+    result->complete = params->complete;
+    return true;
+  }
+
+  /// <summary> Serve one master until it disconnects; closes fd. </summary>
+  /// <returns> False when the master broke the protocol. </returns>
+  bool Serve(const int fd)
+  {
+    Session session;
+    session.fd = fd;
+    std::thread searcher(&DistributedWorker::SearchLoop, this, &session);
+    bool ok = true;
+    int type;
+    DistributedProtocol::Bytes payload;
+    while (DistributedProtocol::ReceiveFrame(fd, &type, &payload))
+    {
+      if ((DistributedProtocol::Msg_Hello == type) && ReadHello(payload, &session))
+      {
+        continue;
+      }
+      if (DistributedProtocol::Msg_Search == type)
+      {
+        DistributedJob job;
+        if (job.Decode(payload))
+        {
+          std::lock_guard<std::mutex> guard(session.lock);
+          session.job = job;
+          session.pending = true;
+          session.stop.store(false);
+          session.wake.notify_one();
+          continue;
+        }
+      }
+      if (DistributedProtocol::Msg_Stop == type)
+      {
+        session.stop.store(true);
+        continue;
+      }
+      HPS_LOG(Log_Warning, "Bad frame of type " << type << " from the master.");
+      ok = false;
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> guard(session.lock);
+      session.quit = true;
+      session.stop.store(true);
+      session.wake.notify_one();
+    }
+    searcher.join();
+    close(fd);
+    return ok && !session.failed;
+  }
+
+private:
+  DistributedWorker(const DistributedWorker&);
+  DistributedWorker& operator=(const DistributedWorker&);
+
+  struct Session
+  {
+    Session()
+    : fd(-1), weights(), lock(), wake(), job(), pending(false), quit(false),
+      failed(false), stop(false)
+    {}
+    int fd;
+    /// <summary> From Msg_Hello; read by the searcher under lock. </summary>
+    EvalWeights weights;
+    std::mutex lock;
+    std::condition_variable wake;
+    DistributedJob job;
+    bool pending;
+    bool quit;
+    /// <summary> A job was not valid; set by the searcher. </summary>
+    bool failed;
+    std::atomic<bool> stop;
+  };
+
+  static bool ReadHello(const DistributedProtocol::Bytes& payload, Session* session)
+  {
+    if ((payload.size() != static_cast<size_t>(1 + (4 * EvalWeights::NumFields))) ||
+        (DistributedProtocol::Version != payload[0]))
+    {
+      return false;
+    }
+    EvalWeights weights;
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      weights.*(EvalWeights::Fields()[fieldIdx].member) = static_cast<int32_t>(
+        static_cast<uint32_t>(DistributedProtocol::Get(&payload[1 + (4 * fieldIdx)], 4)));
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+    session->weights = weights;
+    return true;
+  }
+
+  void SearchLoop(Session* session)
+  {
+    AlphaBetaPruning::Params params;
+    for (;;)
+    {
+      DistributedJob job;
+      EvalWeights weights;
+      {
+        std::unique_lock<std::mutex> guard(session->lock);
+        session->wake.wait(guard, [session] { return session->pending || session->quit; });
+        if (session->quit)
+        {
+          return;
+        }
+        job = session->job;
+        weights = session->weights;
+        session->pending = false;
+      }
+      DistributedResult result;
+      if (!SearchPly(weights, job, &pool, &session->stop, &params, &result))
+      {
+        HPS_LOG(Log_Warning, "Job " << job.jobId << " is not a valid search.");
+        std::lock_guard<std::mutex> guard(session->lock);
+        session->failed = true;
+        // Close the reading side so that Serve() returns.
+        shutdown(session->fd, SHUT_RDWR);
+        return;
+      }
+      DistributedProtocol::SendFrame(session->fd, DistributedProtocol::Msg_Result,
+                                     result.Encode());
+    }
+  }
+
+  ThreadPool pool;
+};
+
+/// <summary> The master side: splits the root plys among worker processes. </summary>
+/// <remarks>
+///   <para> Root plys go out one at a time, largest predicted subtree
+///     first, to whichever worker is free, so workers on slow hosts simply
+///     take fewer plys. A proven win ends the search: the other workers are
+///     told to stop. A ply whose worker disconnects goes to another one.
+///   </para>
+///   <para> At the time limit the busy workers are told to stop too. A
+///     worker that has not answered StopGraceMs after a stop is dropped, so
+///     a hung host cannot hold the search up. Without a time limit the
+///     master waits as long as the connections stay open.
+///   </para>
+/// </remarks>
+class DistributedSearch
+{
+public:
+  enum { StopGraceMs = 1000, };
+
+  struct Result
+  {
+    Result()
+    : move(), score(0), nodes(0), selDepth(0), complete(false), rootPlys(), rootPlyScores()
+    {}
+    Cell move;
+    /// <summary> Minimax from the view of the player to move. </summary>
+    int score;
+    long long nodes;
+    int selDepth;
+    /// <summary> False when the time limit, or lost workers, left root
+    ///   plys unsearched.
+    /// </summary>
+    bool complete;
+    /// <summary> The root plys in the order they were sent. </summary>
+    Board::MoveList rootPlys;
+    /// <summary> Score of each of rootPlys; plys cut short by a win, or
+    ///   never searched, score the minimum.
+    /// </summary>
+    std::vector<int> rootPlyScores;
+  };
+
+  explicit DistributedSearch(const EvalWeights& weights_ = EvalWeights())
+  : weights(weights_), workers(), nextJobId(1)
+  {}
+
+  ~DistributedSearch()
+  {
+    for (size_t workerIdx = 0; workerIdx < workers.size(); ++workerIdx)
+    {
+      close(workers[workerIdx]);
+    }
+  }
+
+  /// <summary> Take a connected worker; false if it cannot be greeted. </summary>
+  bool AddWorker(const int fd)
+  {
+    DistributedProtocol::Bytes hello;
+    hello.push_back(DistributedProtocol::Version);
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      DistributedProtocol::Put(static_cast<uint32_t>(
+        weights.*(EvalWeights::Fields()[fieldIdx].member)), 4, &hello);
+    }
+    if ((fd < 0) || !DistributedProtocol::SendFrame(fd, DistributedProtocol::Msg_Hello, hello))
+    {
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+      return false;
+    }
+    workers.push_back(fd);
+    return true;
+  }
+
+  inline int Workers() const
+  {
+    return static_cast<int>(workers.size());
+  }
+
+  /// <summary> Search the board to the depth, at least 2, in timeLimitSec
+  ///   when that is positive.
+  /// </summary>
+  /// <returns> False when there is no valid move or no worker. </returns>
+  bool Search(const Board& board, const int depth, const double timeLimitSec, Result* result)
+  {
+    assert(result && (depth >= 2));
+    Timer timer;
+    *result = Result();
+    Board::MoveList& plys = result->rootPlys;
+    board.ValidMoves(&plys);
+    if (plys.empty() || workers.empty())
+    {
+      return false;
+    }
+    result->selDepth = 1;
+    // A ply that leaves no reply wins without a search.
+    std::vector<std::pair<int, int> > order(plys.size());
+    const CandidateMasks& masks = board.GetCandidates();
+    for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+    {
+      const int replies = masks.ValidCountAfter(
+        CandidateMasks::CellIndex(plys[plyIdx].location.x, plys[plyIdx].location.y),
+        plys[plyIdx].value);
+      if (0 == replies)
+      {
+        result->move = plys[plyIdx];
+        result->score = std::numeric_limits<int>::max();
+        result->complete = true;
+        result->rootPlys.assign(1, result->move);
+        result->rootPlyScores.assign(1, result->score);
+        return true;
+      }
+      order[plyIdx] = std::make_pair(-replies, static_cast<int>(plyIdx));
+    }
+    std::stable_sort(order.begin(), order.end());
+    {
+      Board::MoveList ordered(plys.size());
+      for (size_t plyIdx = 0; plyIdx < order.size(); ++plyIdx)
+      {
+        ordered[plyIdx] = plys[order[plyIdx].second];
+      }
+      plys.swap(ordered);
+    }
+    result->rootPlyScores.assign(plys.size(), std::numeric_limits<int>::min());
+
+    DistributedJob job;
+    job.depth = depth;
+    job.position.SetPosition(board);
+    // Root plys not yet sent, last first; lost workers return theirs.
+    std::vector<int> unsent;
+    for (int plyIdx = static_cast<int>(plys.size()) - 1; plyIdx >= 0; --plyIdx)
+    {
+      unsent.push_back(plyIdx);
+    }
+    // The ply and job of each worker, or -1 when idle.
+    std::vector<int> busyPly(workers.size(), -1);
+    std::vector<uint32_t> busyJob(workers.size(), 0);
+    std::vector<bool> finished(plys.size(), false);
+    bool won = false;
+    // Set once the busy workers are told to stop, by a win or the clock.
+    bool stopping = false;
+    double stopSec = 0.0;
+    for (;;)
+    {
+      const double now = timer.GetTime();
+      if (!stopping && (timeLimitSec > 0.0) && (now >= timeLimitSec))
+      {
+        StopBusyWorkers(busyPly);
+        stopping = true;
+        stopSec = now;
+      }
+      if (stopping && (now >= stopSec + (0.001 * StopGraceMs)))
+      {
+        for (size_t workerIdx = 0; workerIdx < workers.size(); ++workerIdx)
+        {
+          if (busyPly[workerIdx] >= 0)
+          {
+            HPS_LOG(Log_Warning, "Worker " << workerIdx << " did not stop; dropped it.");
+            DropWorker(workerIdx, &busyPly, &busyJob, &unsent);
+            --workerIdx;
+          }
+        }
+      }
+      // Hand out plys to the idle workers.
+      for (size_t workerIdx = 0; !stopping && (workerIdx < workers.size()); ++workerIdx)
+      {
+        if ((busyPly[workerIdx] >= 0) || unsent.empty())
+        {
+          continue;
+        }
+        job.jobId = nextJobId++;
+        job.ply = plys[unsent.back()];
+        if (!DistributedProtocol::SendFrame(workers[workerIdx], DistributedProtocol::Msg_Search,
+                                            job.Encode()))
+        {
+          DropWorker(workerIdx, &busyPly, &busyJob, &unsent);
+          --workerIdx;
+          continue;
+        }
+        busyPly[workerIdx] = unsent.back();
+        busyJob[workerIdx] = job.jobId;
+        unsent.pop_back();
+      }
+      std::vector<pollfd> polls;
+      for (size_t workerIdx = 0; workerIdx < workers.size(); ++workerIdx)
+      {
+        if (busyPly[workerIdx] >= 0)
+        {
+          pollfd busy;
+          busy.fd = workers[workerIdx];
+          busy.events = POLLIN;
+          busy.revents = 0;
+          polls.push_back(busy);
+        }
+      }
+      if (polls.empty())
+      {
+        break;
+      }
+      // Wake at the time limit, or when the stopped workers run out of grace.
+      double waitSec = -1.0;
+      if (stopping)
+      {
+        waitSec = stopSec + (0.001 * StopGraceMs) - now;
+      }
+      else if (timeLimitSec > 0.0)
+      {
+        waitSec = timeLimitSec - now;
+      }
+      const int waitMs = (waitSec < 0.0) ? -1 : static_cast<int>(1000.0 * waitSec) + 1;
+      if (poll(&polls[0], polls.size(), waitMs) < 0)
+      {
+        if (EINTR == errno)
+        {
+          continue;
+        }
+        break;
+      }
+      for (size_t pollIdx = 0; pollIdx < polls.size(); ++pollIdx)
+      {
+        if (0 == polls[pollIdx].revents)
+        {
+          continue;
+        }
+        const size_t workerIdx = std::find(workers.begin(), workers.end(), polls[pollIdx].fd) -
+                                 workers.begin();
+        int type;
+        DistributedProtocol::Bytes payload;
+        DistributedResult answer;
+        if (!DistributedProtocol::ReceiveFrame(workers[workerIdx], &type, &payload) ||
+            (DistributedProtocol::Msg_Result != type) || !answer.Decode(payload) ||
+            (answer.jobId != busyJob[workerIdx]))
+        {
+          HPS_LOG(Log_Warning, "Lost worker " << workerIdx << ".");
+          DropWorker(workerIdx, &busyPly, &busyJob, &unsent);
+          continue;
+        }
+        const int plyIdx = busyPly[workerIdx];
+        busyPly[workerIdx] = -1;
+        result->nodes += answer.nodes;
+        if (!answer.complete)
+        {
+          continue;
+        }
+        finished[plyIdx] = true;
+        result->rootPlyScores[plyIdx] = answer.score;
+        result->selDepth = std::max(result->selDepth, answer.selDepth);
+        if (!won && (std::numeric_limits<int>::max() == answer.score))
+        {
+          won = true;
+          if (!stopping)
+          {
+            StopBusyWorkers(busyPly);
+            stopping = true;
+            stopSec = timer.GetTime();
+          }
+        }
+      }
+      if (workers.empty())
+      {
+        break;
+      }
+    }
+    // Best of the finished plys, first in order on a tie.
+    int bestPlyIdx = -1;
+    for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+    {
+      if (finished[plyIdx] &&
+          ((-1 == bestPlyIdx) || (result->rootPlyScores[plyIdx] > result->score)))
+      {
+        bestPlyIdx = static_cast<int>(plyIdx);
+        result->score = result->rootPlyScores[plyIdx];
+      }
+    }
+    result->complete = won || (plys.size() == static_cast<size_t>(
+      std::count(finished.begin(), finished.end(), true)));
+    if (-1 == bestPlyIdx)
+    {
+      // No worker finished a ply: any will do.
+      result->move = plys.front();
+      result->score = 0;
+    }
+    else
+    {
+      result->move = plys[bestPlyIdx];
+    }
+    return true;
+  }
+
+private:
+  DistributedSearch(const DistributedSearch&);
+  DistributedSearch& operator=(const DistributedSearch&);
+
+  /// <summary> Send Msg_Stop to every worker with a ply. </summary>
+  void StopBusyWorkers(const std::vector<int>& busyPly) const
+  {
+    for (size_t workerIdx = 0; workerIdx < workers.size(); ++workerIdx)
+    {
+      if (busyPly[workerIdx] >= 0)
+      {
+        DistributedProtocol::SendFrame(workers[workerIdx], DistributedProtocol::Msg_Stop,
+                                       DistributedProtocol::Bytes());
+      }
+    }
+  }
+
+  /// <summary> Close a worker and put its ply back to be sent again. </summary>
+  void DropWorker(const size_t workerIdx,
+                  std::vector<int>* busyPly,
+                  std::vector<uint32_t>* busyJob,
+                  std::vector<int>* unsent)
+  {
+    if ((*busyPly)[workerIdx] >= 0)
+    {
+      unsent->push_back((*busyPly)[workerIdx]);
+    }
+    close(workers[workerIdx]);
+    workers.erase(workers.begin() + workerIdx);
+    busyPly->erase(busyPly->begin() + workerIdx);
+    busyJob->erase(busyJob->begin() + workerIdx);
+  }
+
+  EvalWeights weights;
+  std::vector<int> workers;
+  uint32_t nextJobId;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_DISTRIBUTED_H_
@@ -0,0 +1,288 @@
+#ifndef _HPS_SUDOKILL_DISTRIBUTED_GTEST_H_
+#define _HPS_SUDOKILL_DISTRIBUTED_GTEST_H_
+
+#include "distributed.h"
+#include "sudokill_gtest_util.h"
+#include "gtest/gtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace _hps_sudokill_distributed_gtest_h_
+{
+using namespace hps;
+using namespace hps::sudokill_gtest;
+
+/// <summary> Workers on threads of this process, each behind a socketpair. </summary>
+class LocalWorkers
+{
+public:
+  LocalWorkers(const int numWorkers, DistributedSearch* search)
+  : workers(), fds(), threads()
+  {
+    ThreadPool::Options poolOptions;
+    poolOptions.numThreads = 1;
+    for (int workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+    {
+      int pair[2];
+      EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, pair));
+      workers.push_back(new DistributedWorker(poolOptions));
+      fds.push_back(pair[1]);
+      threads.push_back(std::thread(&DistributedWorker::Serve, workers.back(), pair[1]));
+      EXPECT_TRUE(search->AddWorker(pair[0]));
+    }
+  }
+
+  /// <summary> Hang up on the workers, as if the master had gone. </summary>
+  ~LocalWorkers()
+  {
+    for (size_t workerIdx = 0; workerIdx < workers.size(); ++workerIdx)
+    {
+      shutdown(fds[workerIdx], SHUT_RDWR);
+      threads[workerIdx].join();
+      delete workers[workerIdx];
+    }
+  }
+
+private:
+  std::vector<DistributedWorker*> workers;
+  /// <summary> The worker ends; Serve() closes them. </summary>
+  std::vector<int> fds;
+  std::vector<std::thread> threads;
+};
+
+TEST(Distributed, Messages)
+{
+  DistributedJob job;
+  job.jobId = 0x01020304;
+  job.depth = 9;
+  job.ply = Cell(Point(7, 2), 5);
+  const Board board = Position(20, 3);
+  job.position.SetPosition(board);
+  DistributedJob decodedJob;
+  ASSERT_TRUE(decodedJob.Decode(job.Encode()));
+  EXPECT_EQ(job.jobId, decodedJob.jobId);
+  EXPECT_EQ(job.depth, decodedJob.depth);
+  EXPECT_EQ(job.ply, decodedJob.ply);
+  Board decodedBoard;
+  decodedJob.position.ToBoard(&decodedBoard);
+  EXPECT_EQ(board.GetOccupied().size(), decodedBoard.GetOccupied().size());
+  EXPECT_FALSE(decodedJob.Decode(DistributedProtocol::Bytes(5, 0)));
+  DistributedResult result;
+  result.jobId = 77;
+  result.score = std::numeric_limits<int>::min();
+  result.nodes = 1LL << 40;
+  result.selDepth = 14;
+  result.complete = true;
+  DistributedResult decodedResult;
+  ASSERT_TRUE(decodedResult.Decode(result.Encode()));
+  EXPECT_EQ(result.jobId, decodedResult.jobId);
+  EXPECT_EQ(result.score, decodedResult.score);
+  EXPECT_EQ(result.nodes, decodedResult.nodes);
+  EXPECT_EQ(result.selDepth, decodedResult.selDepth);
+  EXPECT_TRUE(decodedResult.complete);
+}
+
+TEST(Distributed, MatchesLocalPlys)
+{
+  EvalWeights weights;
+  weights.parity = 200;
+  const Board board = Position(40, 7);
+  DistributedSearch::Result result;
+  {
+    DistributedSearch search(weights);
+    LocalWorkers workers(3, &search);
+    ASSERT_EQ(3, search.Workers());
+    ASSERT_TRUE(search.Search(board, 4, 0.0, &result));
+  }
+  EXPECT_TRUE(result.complete);
+  ASSERT_EQ(result.rootPlys.size(), result.rootPlyScores.size());
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = 1;
+  ThreadPool pool(poolOptions);
+  DistributedJob job;
+  job.depth = 4;
+  job.position.SetPosition(board);
+  int best = std::numeric_limits<int>::min();
+  for (size_t plyIdx = 0; plyIdx < result.rootPlys.size(); ++plyIdx)
+  {
+    job.ply = result.rootPlys[plyIdx];
+    AlphaBetaPruning::Params params;
+    DistributedResult local;
+    ASSERT_TRUE(DistributedWorker::SearchPly(weights, job, &pool, NULL, &params, &local));
+    best = std::max(best, local.score);
+    // Plys cut short by a proven win score the minimum.
+    if (std::numeric_limits<int>::min() != result.rootPlyScores[plyIdx])
+    {
+      EXPECT_EQ(local.score, result.rootPlyScores[plyIdx]);
+    }
+  }
+  EXPECT_EQ(best, result.score);
+}
+
+TEST(Distributed, SolvesLikeOneProcess)
+{
+  for (int positionIdx = 0; positionIdx < 4; ++positionIdx)
+  {
+    const Board board = Position(48 + positionIdx, 1 + (2 * positionIdx));
+    Board::MoveList plys;
+    board.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      continue;
+    }
+    // Deep enough that no line reaches the evaluation: both are exact.
+    const int emptyCells = (Board::MaxX * Board::MaxY) -
+                           static_cast<int>(board.GetOccupied().size());
+    const int depth = emptyCells + 2;
+    DistributedSearch::Result result;
+    {
+      DistributedSearch search;
+      LocalWorkers workers(2, &search);
+      ASSERT_TRUE(search.Search(board, depth, 0.0, &result));
+    }
+    EXPECT_TRUE(result.complete);
+    ThreadPool::Options poolOptions;
+    poolOptions.numThreads = 1;
+    ThreadPool pool(poolOptions);
+    AlphaBetaPruning::Params params;
+    params.maxDepth = depth;
+    params.pool = &pool;
+    const WeightedEvaluationFunc f(EvalWeights(), board.GetPlayerMovesCount());
+    Board state = board;
+    Cell ply;
+    EXPECT_EQ(AlphaBetaPruning::Run(&params, &state, &f, &ply), result.score);
+    state = board;
+    EXPECT_TRUE(state.IsValidMove(result.move));
+  }
+}
+
+TEST(Distributed, LostWorker)
+{
+  const Board board = Position(40, 7);
+  DistributedSearch::Result result;
+  DistributedSearch::Result expected;
+  {
+    DistributedSearch search;
+    LocalWorkers workers(2, &search);
+    // A worker that hangs up after the greeting.
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_TRUE(search.AddWorker(fds[0]));
+    close(fds[1]);
+    ASSERT_TRUE(search.Search(board, 4, 0.0, &result));
+    EXPECT_EQ(2, search.Workers());
+    ASSERT_TRUE(search.Search(board, 4, 0.0, &expected));
+  }
+  EXPECT_TRUE(result.complete);
+  EXPECT_EQ(expected.score, result.score);
+  EXPECT_EQ(expected.move, result.move);
+}
+
+/// <summary> A worker that accepts one master on listenFd and serves it. </summary>
+inline void AcceptAndServe(DistributedWorker* worker, const int listenFd)
+{
+  const int fd = DistributedProtocol::Accept(listenFd);
+  if (fd >= 0)
+  {
+    worker->Serve(fd);
+  }
+}
+
+TEST(Distributed, Sockets)
+{
+  // Bad addresses fail without a socket.
+  EXPECT_EQ(-1, DistributedProtocol::Listen("unix:"));
+  EXPECT_EQ(-1, DistributedProtocol::Connect("unix:"));
+  // A bare port listens on every interface.
+  const int anyFd = DistributedProtocol::Listen("0");
+  EXPECT_GE(anyFd, 0);
+  close(anyFd);
+
+  char dir[] = "/tmp/sudokill_dist_gtest_XXXXXX";
+  ASSERT_TRUE(NULL != mkdtemp(dir));
+  const std::string unixAddress = std::string("unix:") + dir + "/worker.sock";
+  const int unixListenFd = DistributedProtocol::Listen(unixAddress);
+  ASSERT_GE(unixListenFd, 0);
+  // Port 0 takes an ephemeral port; ask which.
+  const int tcpListenFd = DistributedProtocol::Listen("127.0.0.1:0");
+  ASSERT_GE(tcpListenFd, 0);
+  int reuse = 0;
+  socklen_t optionSize = sizeof(reuse);
+  ASSERT_EQ(0, getsockopt(tcpListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, &optionSize));
+  EXPECT_NE(0, reuse);
+  sockaddr_in bound;
+  socklen_t boundSize = sizeof(bound);
+  ASSERT_EQ(0, getsockname(tcpListenFd, reinterpret_cast<sockaddr*>(&bound), &boundSize));
+  char tcpAddress[32];
+  snprintf(tcpAddress, sizeof(tcpAddress), "127.0.0.1:%d", ntohs(bound.sin_port));
+
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = 1;
+  DistributedWorker unixWorker(poolOptions);
+  DistributedWorker tcpWorker(poolOptions);
+  std::thread unixThread(&AcceptAndServe, &unixWorker, unixListenFd);
+  std::thread tcpThread(&AcceptAndServe, &tcpWorker, tcpListenFd);
+  const Board board = Position(40, 7);
+  DistributedSearch::Result result;
+  {
+    DistributedSearch search;
+    const int tcpFd = DistributedProtocol::Connect(tcpAddress);
+    ASSERT_GE(tcpFd, 0);
+    int noDelay = 0;
+    optionSize = sizeof(noDelay);
+    ASSERT_EQ(0, getsockopt(tcpFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, &optionSize));
+    EXPECT_NE(0, noDelay);
+    ASSERT_TRUE(search.AddWorker(tcpFd));
+    ASSERT_TRUE(search.AddWorker(DistributedProtocol::Connect(unixAddress)));
+    ASSERT_TRUE(search.Search(board, 4, 0.0, &result));
+    EXPECT_EQ(2, search.Workers());
+  }
+  // The search hung up, so the workers are done.
+  unixThread.join();
+  tcpThread.join();
+  close(unixListenFd);
+  close(tcpListenFd);
+  unlink(unixAddress.c_str() + 5);
+  rmdir(dir);
+
+  DistributedSearch::Result expected;
+  {
+    DistributedSearch search;
+    LocalWorkers workers(2, &search);
+    ASSERT_TRUE(search.Search(board, 4, 0.0, &expected));
+  }
+  EXPECT_TRUE(result.complete);
+  EXPECT_EQ(expected.score, result.score);
+  EXPECT_EQ(expected.move, result.move);
+}
+
+TEST(Distributed, TimeLimit)
+{
+  const Board board = Position(20, 1);
+  DistributedSearch::Result result;
+  {
+    DistributedSearch search;
+    LocalWorkers workers(1, &search);
+    // A worker that takes a ply and never answers.
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ASSERT_TRUE(search.AddWorker(fds[0]));
+    Timer timer;
+    ASSERT_TRUE(search.Search(board, 30, 0.1, &result));
+    const double elapsed = timer.GetTime();
+    EXPECT_GE(elapsed, 0.1 + (0.001 * DistributedSearch::StopGraceMs));
+    EXPECT_LT(elapsed, 1.0 + (0.001 * DistributedSearch::StopGraceMs));
+    EXPECT_EQ(1, search.Workers());
+    close(fds[1]);
+  }
+  EXPECT_FALSE(result.complete);
+  EXPECT_TRUE(board.IsValidMove(result.move));
+}
+
+}
+
+#endif //_HPS_SUDOKILL_DISTRIBUTED_GTEST_H_
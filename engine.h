@@ -0,0 +1,179 @@
+#ifndef _HPS_SUDOKILL_ENGINE_H_
+#define _HPS_SUDOKILL_ENGINE_H_
+#include "sudokill_core.h"
+#include "alphabetapruning.h"
+#include "eval_weights.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include <assert.h>
+#include <atomic>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> A search engine that owns its workers and search state, for
+///   embedding the engine in another program.
+/// </summary>
+/// <remarks>
+///   <para> Unlike the client, which searches on ThreadPool::Search(), every
+///     engine has its own pool, so engines search side by side. One engine
+///     runs one search at a time.
+///   </para>
+/// </remarks>
+class Engine
+{
+public:
+  struct Options
+  {
+    Options() : pool(), weights() {}
+    ThreadPool::Options pool;
+    EvalWeights weights;
+  };
+
+  /// <summary> Bounds of one search; the first bound reached ends it. </summary>
+  struct Limits
+  {
+    Limits() : maxDepth(11), timeLimitSec(0.0) {}
+    int maxDepth;
+    /// <summary> 0 is no limit. Depth 2 always finishes unless stopped. </summary>
+    double timeLimitSec;
+  };
+
+  struct Result
+  {
+    Result() : move(), score(0), depth(0), selDepth(0), nodes(0), seconds(0.0), complete(false) {}
+    Cell move;
+    /// <summary> Minimax from the view of the player to move. </summary>
+    int score;
+    /// <summary> Depth of the iteration that chose the move. </summary>
+    int depth;
+    int selDepth;
+    /// <summary> Nodes over all iterations. </summary>
+    long long nodes;
+    double seconds;
+    /// <summary> False when time or Stop() cut the search short. </summary>
+    bool complete;
+  };
+
+  explicit Engine(const Options& options_ = Options())
+  : options(options_),
+    pool(options_.pool),
+    params(),
+    stop(false)
+  {
+    params.pool = &pool;
+  }
+
+  /// <summary> Search the board for the move of the player to move. </summary>
+  /// <returns> False when there is no valid move. </returns>
+  bool Search(const Board& board, const Limits& limits, Result* result)
+  {
+    assert(result);
+    *result = Result();
+    Timer timer;
+    stop.store(false);
+    Board state = board;
+    Board::MoveList plys;
+    state.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      return false;
+    }
+    const WeightedEvaluationFunc f(options.weights, state.GetPlayerMovesCount());
+    result->complete = true;
+    params.stopSignal = &stop;
+    Iteration iteration(limits, timer, result);
+    AlphaBetaPruning::Deepen(AlphaBetaPruning::DepthCap(state, limits.maxDepth),
+                             &params, &state, &f, &iteration);
+    result->seconds = timer.GetTime();
+    return true;
+  }
+
+  /// <summary> End the running search soon; safe from any thread. </summary>
+  inline void Stop()
+  {
+    stop.store(true);
+  }
+
+  inline void SetWeights(const EvalWeights& weights)
+  {
+    options.weights = weights;
+  }
+
+  inline const EvalWeights& GetWeights() const
+  {
+    return options.weights;
+  }
+
+  inline int Threads() const
+  {
+    return pool.Size();
+  }
+
+private:
+  Engine(const Engine&);
+  Engine& operator=(const Engine&);
+
+  /// <summary> Bounds each iteration by the time left; keeps the result
+  ///   of the last full one.
+  /// </summary>
+  struct Iteration
+  {
+    Iteration(const Limits& limits_, const Timer& timer_, Result* result_)
+    : limits(limits_), timer(timer_), result(result_)
+    {}
+
+    bool BeginIteration(const int depth, AlphaBetaPruning::Params* params)
+    {
+      params->timeLimitSec = 0.0;
+      if ((limits.timeLimitSec > 0.0) && (depth > 2))
+      {
+        params->timeLimitSec = limits.timeLimitSec - timer.GetTime();
+        if (params->timeLimitSec <= 0.0)
+        {
+          result->complete = false;
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool EndIteration(const int depth,
+                      const int minimax,
+                      const Cell& ply,
+                      const AlphaBetaPruning::Params& params)
+    {
+      result->nodes += params.nodes;
+      // Prefer the last full iteration over a partial one.
+      if (params.complete || (2 == depth))
+      {
+        result->move = ply;
+        result->score = minimax;
+        result->depth = depth;
+        result->selDepth = params.selDepth;
+      }
+      result->complete = params.complete;
+      return true;
+    }
+
+    const Limits& limits;
+    const Timer& timer;
+    Result* result;
+  };
+
+  Options options;
+  ThreadPool pool;
+  /// <summary> Kept between searches: the per-thread state, and the root
+  ///   ply order for the next search of the same position.
+  /// </summary>
+  AlphaBetaPruning::Params params;
+  std::atomic<bool> stop;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_ENGINE_H_
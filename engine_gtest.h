@@ -0,0 +1,65 @@
+#ifndef _HPS_SUDOKILL_ENGINE_GTEST_H_
+#define _HPS_SUDOKILL_ENGINE_GTEST_H_
+
+#include "engine.h"
+#include "sudokill_gtest_util.h"
+#include "gtest/gtest.h"
+#include <limits>
+
+namespace _hps_sudokill_engine_gtest_h_
+{
+using namespace hps;
+using namespace hps::sudokill_gtest;
+
+TEST(Engine, MatchesAlphaBeta)
+{
+  Engine::Options options;
+  options.pool.numThreads = 2;
+  Engine engine(options);
+  ASSERT_EQ(2, engine.Threads());
+  Engine::Limits limits;
+  limits.maxDepth = 4;
+  for (int positionIdx = 0; positionIdx < 3; ++positionIdx)
+  {
+    const Board board = Position(36 + positionIdx, 3 + positionIdx);
+    Engine::Result result;
+    ASSERT_TRUE(engine.Search(board, limits, &result));
+    EXPECT_TRUE(result.complete);
+    EXPECT_TRUE(board.IsValidMove(result.move));
+    EXPECT_GT(result.nodes, 0);
+    // The last iteration is a plain search to its depth.
+    AlphaBetaPruning::Params params;
+    params.maxDepth = result.depth;
+    params.pool = NULL;
+    const WeightedEvaluationFunc f(EvalWeights(), board.GetPlayerMovesCount());
+    Board state = board;
+    Cell ply;
+    EXPECT_EQ(AlphaBetaPruning::Run(&params, &state, &f, &ply), result.score);
+    // Searching again, in the root order kept from the last, finds the same.
+    Engine::Result again;
+    ASSERT_TRUE(engine.Search(board, limits, &again));
+    EXPECT_EQ(result.score, again.score);
+  }
+}
+
+TEST(Engine, NoMovesAndStop)
+{
+  Engine::Options options;
+  options.pool.numThreads = 1;
+  Engine engine(options);
+  Engine::Result result;
+  EXPECT_FALSE(engine.Search(Position(81, 1), Engine::Limits(), &result));
+  // A time limit still keeps depth 2.
+  Engine::Limits limits;
+  limits.maxDepth = 30;
+  limits.timeLimitSec = 1e-6;
+  const Board board = Position(20, 1);
+  ASSERT_TRUE(engine.Search(board, limits, &result));
+  EXPECT_FALSE(result.complete);
+  EXPECT_EQ(2, result.depth);
+  EXPECT_TRUE(board.IsValidMove(result.move));
+}
+
+}
+
+#endif //_HPS_SUDOKILL_ENGINE_GTEST_H_
@@ -0,0 +1,208 @@
+#ifndef _HPS_SUDOKILL_EVAL_CACHE_H_
+#define _HPS_SUDOKILL_EVAL_CACHE_H_
+#include "sudokill_core.h"
+#include "evaluation.h"
+#include <stdint.h>
+#include <assert.h>
+#include <atomic>
+#include <vector>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Shared table of leaf scores keyed by Board::Hash(). </summary>
+/// <remarks>
+///   <para> Each entry is one score in a directly mapped slot, so a lookup
+///     is a single cache line. Threads share the table without locks: a slot
+///     stores the data and the key XOR the data, and a torn write between
+///     threads fails the check and reads as a miss (Hyatt's lockless hashing).
+///     A newer score always replaces the old one.
+///   </para>
+///   <para> Hits and misses are counted in per-thread stripes to keep the
+///     counters off each other's cache lines.
+///   </para>
+/// </remarks>
+class EvalCache
+{
+public:
+  enum { MaxCounterStripes = 64, };
+
+  /// <summary> Table of about sizeBytes, rounded down to a power of two of
+  ///   entries (at least one).
+  /// </summary>
+  explicit EvalCache(const size_t sizeBytes)
+  : entries(EntriesFor(sizeBytes)),
+    mask(entries.size() - 1),
+    stripes(MaxCounterStripes)
+  {}
+
+  inline bool Probe(const uint64_t key, int* score) const
+  {
+    assert(score);
+    const Entry& entry = entries[key & mask];
+    const uint64_t data = entry.data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.check.load(std::memory_order_relaxed);
+    CounterStripe& stripe = Stripe();
+    if (((check ^ data) != key) || (0 == (data & ValidBit)))
+    {
+      stripe.misses.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    stripe.hits.fetch_add(1, std::memory_order_relaxed);
+    *score = static_cast<int>(static_cast<int32_t>(static_cast<uint32_t>(data)));
+    return true;
+  }
+
+  inline void Store(const uint64_t key, const int score)
+  {
+    Entry& entry = entries[key & mask];
+    const uint64_t data = ValidBit | static_cast<uint32_t>(static_cast<int32_t>(score));
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+  }
+
+  /// <summary> Forget every score and zero the counters. </summary>
+  void Clear()
+  {
+    for (size_t entryIdx = 0; entryIdx < entries.size(); ++entryIdx)
+    {
+      entries[entryIdx].data.store(0, std::memory_order_relaxed);
+      entries[entryIdx].check.store(0, std::memory_order_relaxed);
+    }
+    for (size_t stripeIdx = 0; stripeIdx < stripes.size(); ++stripeIdx)
+    {
+      stripes[stripeIdx].hits.store(0, std::memory_order_relaxed);
+      stripes[stripeIdx].misses.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  inline size_t Size() const
+  {
+    return entries.size();
+  }
+
+  uint64_t Hits() const
+  {
+    uint64_t hits = 0;
+    for (size_t stripeIdx = 0; stripeIdx < stripes.size(); ++stripeIdx)
+    {
+      hits += stripes[stripeIdx].hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+  }
+
+  uint64_t Misses() const
+  {
+    uint64_t misses = 0;
+    for (size_t stripeIdx = 0; stripeIdx < stripes.size(); ++stripeIdx)
+    {
+      misses += stripes[stripeIdx].misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+  }
+
+private:
+  static const uint64_t ValidBit = 1ULL << 32;
+
+  struct Entry
+  {
+    Entry() : data(0), check(0) {}
+    std::atomic<uint64_t> data;
+    std::atomic<uint64_t> check;
+  };
+
+  struct CounterStripe
+  {
+    CounterStripe() : hits(0), misses(0) {}
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    char pad[64 - (2 * sizeof(std::atomic<uint64_t>))];
+  };
+
+  EvalCache(const EvalCache&);
+  EvalCache& operator=(const EvalCache&);
+
+  static size_t EntriesFor(const size_t sizeBytes)
+  {
+    size_t count = 1;
+    while ((count * 2 * sizeof(Entry)) <= sizeBytes)
+    {
+      count *= 2;
+    }
+    return count;
+  }
+
+  /// <summary> The calling thread's counters; threads take stripes in turn. </summary>
+  inline CounterStripe& Stripe() const
+  {
+    static std::atomic<int> s_nextStripe(0);
+    static thread_local int t_stripe = -1;
+    if (t_stripe < 0)
+    {
+      t_stripe = s_nextStripe.fetch_add(1, std::memory_order_relaxed) % MaxCounterStripes;
+    }
+    return stripes[t_stripe];
+  }
+
+  std::vector<Entry> entries;
+  size_t mask;
+  mutable std::vector<CounterStripe> stripes;
+};
+
+/// <summary> Put an EvalCache in front of a BoardEvaulationFunction. </summary>
+/// <remarks>
+///   <para> Only whole-board scores are cached. Children scored in a batch
+///     by EvaluateChildren() are passed straight through, since deriving a
+///     child from its parent's masks costs less than a probe.
+///   </para>
+/// </remarks>
+template <typename BoardEvaulationFunction,
+          bool Batch = EvaluatesChildren<BoardEvaulationFunction>::value>
+struct CachedEvaluationFunc
+{
+  CachedEvaluationFunc(const BoardEvaulationFunction& evalFunc_, EvalCache* cache_)
+  : evalFunc(evalFunc_),
+    cache(cache_)
+  {
+    assert(cache);
+  }
+
+  inline int operator()(const Board& board) const
+  {
+    const uint64_t key = board.Hash();
+    int score;
+    if (!cache->Probe(key, &score))
+    {
+      score = evalFunc(board);
+      cache->Store(key, score);
+    }
+    return score;
+  }
+
+  BoardEvaulationFunction evalFunc;
+  EvalCache* cache;
+};
+
+template <typename BoardEvaulationFunction>
+struct CachedEvaluationFunc<BoardEvaulationFunction, true>
+  : public CachedEvaluationFunc<BoardEvaulationFunction, false>
+{
+  CachedEvaluationFunc(const BoardEvaulationFunction& evalFunc_, EvalCache* cache_)
+  : CachedEvaluationFunc<BoardEvaulationFunction, false>(evalFunc_, cache_)
+  {}
+
+  void EvaluateChildren(const Board& parent,
+                        const Board::MoveList& plys,
+                        ChildEvaluation* evals) const
+  {
+    this->evalFunc.EvaluateChildren(parent, plys, evals);
+  }
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_EVAL_CACHE_H_
@@ -0,0 +1,96 @@
+#ifndef _HPS_SUDOKILL_EVAL_CACHE_GTEST_H_
+#define _HPS_SUDOKILL_EVAL_CACHE_GTEST_H_
+
+#include "eval_cache.h"
+#include "alphabetapruning.h"
+#include "gtest/gtest.h"
+#include <memory>
+
+namespace _hps_sudokill_eval_cache_gtest_h_
+{
+using namespace hps;
+
+/// <summary> Count calls that reach the wrapped evaluator. </summary>
+struct CountingEvaluationFunc
+{
+  CountingEvaluationFunc() : calls(new std::atomic<int>(0)) {}
+  inline int operator()(const Board& board) const
+  {
+    calls->fetch_add(1);
+    return f(board);
+  }
+  ShrinkPossibleMovesEvaluationFunc f;
+  std::shared_ptr<std::atomic<int> > calls;
+};
+
+TEST(EvalCache, ProbeAndStore)
+{
+  EvalCache cache(1 << 12);
+  EXPECT_EQ(256u, cache.Size());
+  int score = 0;
+  EXPECT_FALSE(cache.Probe(12345, &score));
+  cache.Store(12345, -7);
+  EXPECT_TRUE(cache.Probe(12345, &score));
+  EXPECT_EQ(-7, score);
+  // Same slot, other key.
+  EXPECT_FALSE(cache.Probe(12345 + cache.Size(), &score));
+  cache.Store(12345 + cache.Size(), 3);
+  EXPECT_FALSE(cache.Probe(12345, &score));
+  EXPECT_EQ(1u, cache.Hits());
+  EXPECT_EQ(3u, cache.Misses());
+  // An empty slot never matches, even key 0.
+  EXPECT_FALSE(cache.Probe(0, &score));
+  cache.Clear();
+  EXPECT_EQ(0u, cache.Hits());
+  EXPECT_EQ(0u, cache.Misses());
+}
+
+TEST(EvalCache, CachedEvaluationFunc)
+{
+  EXPECT_FALSE((EvaluatesChildren<CachedEvaluationFunc<CountingEvaluationFunc> >::value));
+  EXPECT_TRUE((EvaluatesChildren<CachedEvaluationFunc<ShrinkPossibleMovesEvaluationFunc> >::value));
+  EvalCache cache(1 << 20);
+  CountingEvaluationFunc counting;
+  CachedEvaluationFunc<CountingEvaluationFunc> cached(counting, &cache);
+  Board board;
+  Board::MoveList moves;
+  for (int i = 0; i < 30; ++i)
+  {
+    board.ValidMoves(&moves);
+    board.PlayMove(moves[(i * 11) % moves.size()]);
+    EXPECT_EQ(counting(board), cached(board));
+    EXPECT_EQ(counting(board), cached(board));
+  }
+  EXPECT_EQ(30u, cache.Hits());
+  EXPECT_EQ(30u, cache.Misses());
+  EXPECT_EQ(30 * 4 - 30, counting.calls->load());
+}
+
+TEST(EvalCache, SearchMatchesUncached)
+{
+  Board board;
+  Board::MoveList moves;
+  for (int i = 0; i < 25; ++i)
+  {
+    board.ValidMoves(&moves);
+    board.PlayMove(moves[(i * 5) % moves.size()]);
+  }
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 4;
+  CountingEvaluationFunc f;
+  Cell ply;
+  const int score = AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  EvalCache cache(1 << 20);
+  CachedEvaluationFunc<CountingEvaluationFunc> cached(f, &cache);
+  Cell cachedPly;
+  EXPECT_EQ(score, AlphaBetaPruning::Run(&params, &board, &cached, &cachedPly));
+  // A second search of the same position finds most leaves in the cache.
+  const uint64_t misses = cache.Misses();
+  const uint64_t hits = cache.Hits();
+  EXPECT_EQ(score, AlphaBetaPruning::Run(&params, &board, &cached, &cachedPly));
+  EXPECT_GT(cache.Hits() - hits, cache.Misses() - misses);
+}
+
+}
+
+#endif //_HPS_SUDOKILL_EVAL_CACHE_GTEST_H_
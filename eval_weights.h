@@ -0,0 +1,239 @@
+#ifndef _HPS_SUDOKILL_EVAL_WEIGHTS_H_
+#define _HPS_SUDOKILL_EVAL_WEIGHTS_H_
+#include "sudokill_core.h"
+#include "evaluation.h"
+#include "propagation.h"
+#include <assert.h>
+#include <string>
+#include <sstream>
+#include <istream>
+#include <ostream>
+#include <fstream>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Tunable evaluation weights and engine thresholds. </summary>
+/// <remarks>
+///   <para> The defaults reproduce ShrinkPossibleMovesEvaluationFunc and the
+///     player's hard-coded opening rule.
+///   </para>
+///   <para> Weights file: one "name value" pair per line, with '#' starting
+///     a comment. Fields that are not listed keep their defaults.
+///   </para>
+/// </remarks>
+struct EvalWeights
+{
+  EvalWeights()
+  : mobility(1),
+    playable(0),
+    deadCells(0),
+    parity(0),
+    randomPlayMoves(55)
+  {}
+
+  /// <summary> Per Sudoku-valid move left on the board. </summary>
+  int mobility;
+  /// <summary> Per move that propagation estimates is left in the game. </summary>
+  int playable;
+  /// <summary> Per empty cell that propagation shows cannot be filled. </summary>
+  int deadCells;
+  /// <summary> Added when the estimated moves left give the root player the
+  ///   last move, otherwise subtracted.
+  /// </summary>
+  int parity;
+  /// <summary> The player moves at random while more Sudoku-valid moves
+  ///   than this remain.
+  /// </summary>
+  int randomPlayMoves;
+
+  /// <summary> A field with its name in the weights file, its allowed range
+  ///   and the perturbation a tuner starts from.
+  /// </summary>
+  struct Field
+  {
+    const char* name;
+    int EvalWeights::* member;
+    int minValue;
+    int maxValue;
+    int step;
+  };
+
+  enum { NumFields = 5, };
+
+  static const Field* Fields()
+  {
+    static const Field s_fields[NumFields] =
+    {
+      { "mobility", &EvalWeights::mobility, 0, 100, 2, },
+      { "playable", &EvalWeights::playable, -1000, 1000, 16, },
+      { "dead_cells", &EvalWeights::deadCells, -1000, 1000, 16, },
+      { "parity", &EvalWeights::parity, -5000, 5000, 64, },
+      { "random_play_moves", &EvalWeights::randomPlayMoves, 0, 729, 8, },
+    };
+    return s_fields;
+  }
+
+  /// <summary> Whether any weight needs constraint propagation. </summary>
+  inline bool UsesPropagation() const
+  {
+    return (0 != playable) || (0 != deadCells) || (0 != parity);
+  }
+
+  inline bool operator==(const EvalWeights& rhs) const
+  {
+    for (int fieldIdx = 0; fieldIdx < NumFields; ++fieldIdx)
+    {
+      const int EvalWeights::* member = Fields()[fieldIdx].member;
+      if (this->*member != rhs.*member)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Read a weights file; on failure the weights are unchanged. </summary>
+  bool Load(std::istream& in)
+  {
+    EvalWeights loaded = *this;
+    std::string line;
+    while (std::getline(in, line))
+    {
+      line = line.substr(0, line.find('#'));
+      std::istringstream fields(line);
+      std::string name;
+      if (!(fields >> name))
+      {
+        continue;
+      }
+      int value;
+      std::string rest;
+      if (!(fields >> value) || (fields >> rest))
+      {
+        return false;
+      }
+      const Field* field = Find(name);
+      if ((NULL == field) || (value < field->minValue) || (value > field->maxValue))
+      {
+        return false;
+      }
+      loaded.*(field->member) = value;
+    }
+    *this = loaded;
+    return true;
+  }
+
+  bool Load(const std::string& path)
+  {
+    std::ifstream in(path.c_str());
+    return in.good() && Load(in);
+  }
+
+  /// <summary> Write every field in the weights file format. </summary>
+  bool Save(std::ostream& out) const
+  {
+    for (int fieldIdx = 0; fieldIdx < NumFields; ++fieldIdx)
+    {
+      const Field& field = Fields()[fieldIdx];
+      out << field.name << " " << this->*(field.member) << "\n";
+    }
+    return out.good();
+  }
+
+  bool Save(const std::string& path) const
+  {
+    std::ofstream out(path.c_str());
+    return out.good() && Save(out);
+  }
+
+private:
+  static const Field* Find(const std::string& name)
+  {
+    for (int fieldIdx = 0; fieldIdx < NumFields; ++fieldIdx)
+    {
+      if (name == Fields()[fieldIdx].name)
+      {
+        return &Fields()[fieldIdx];
+      }
+    }
+    return NULL;
+  }
+};
+
+/// <summary> Linear evaluation over the terms of EvalWeights. </summary>
+/// <remarks>
+///   <para> Scores are from the view of the player to move at the root, whose
+///     move count is given at construction. Propagation runs only when a
+///     weight needs it, so the default weights cost what
+///     ShrinkPossibleMovesEvaluationFunc costs.
+///   </para>
+/// </remarks>
+struct WeightedEvaluationFunc
+{
+  explicit WeightedEvaluationFunc(const EvalWeights& weights_ = EvalWeights(),
+                                  const int rootMovesCount_ = 0)
+  : weights(weights_),
+    rootMovesCount(rootMovesCount_)
+  {}
+
+  inline int operator()(const Board& board) const
+  {
+    int score = weights.mobility * board.GetCandidates().total;
+    if (weights.UsesPropagation())
+    {
+      Propagation propagation;
+      propagation.Run(board);
+      const bool rootToMove = 0 == ((board.GetPlayerMovesCount() - rootMovesCount) & 1);
+      const bool moverLast = 1 == propagation.Parity();
+      score += (weights.playable * propagation.playableMoves) +
+               (weights.deadCells * propagation.deadCells) +
+               ((rootToMove == moverLast) ? weights.parity : -weights.parity);
+    }
+    return score;
+  }
+
+  /// <summary> Score every child, from the parent's candidate masks unless
+  ///   propagation is needed.
+  /// </summary>
+  void EvaluateChildren(const Board& parent,
+                        const Board::MoveList& plys,
+                        ChildEvaluation* evals) const
+  {
+    assert(evals);
+    const CandidateMasks& masks = parent.GetCandidates();
+    Board::MoveList::const_iterator ply = plys.begin();
+    const Board::MoveList::const_iterator plysEnd = plys.end();
+    for (ChildEvaluation* eval = evals; ply != plysEnd; ++ply, ++eval)
+    {
+      const int cellIdx = CandidateMasks::CellIndex(ply->location.x,
+                                                    ply->location.y);
+      const int replies = masks.ValidCountAfter(cellIdx, ply->value);
+      eval->terminal = 0 == replies;
+      eval->singleReply = 1 == replies;
+      eval->score = weights.mobility * masks.SudokuCountAfter(cellIdx, ply->value);
+    }
+    if (weights.UsesPropagation())
+    {
+      // Propagation needs each child's board.
+      Board child = parent;
+      for (ply = plys.begin(); ply != plysEnd; ++ply, ++evals)
+      {
+        child.PlayMove(*ply);
+        evals->score = (*this)(child);
+        child.Undo();
+      }
+    }
+  }
+
+  EvalWeights weights;
+  int rootMovesCount;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_EVAL_WEIGHTS_H_
@@ -0,0 +1,99 @@
+#ifndef _HPS_SUDOKILL_EVAL_WEIGHTS_GTEST_H_
+#define _HPS_SUDOKILL_EVAL_WEIGHTS_GTEST_H_
+
+#include "eval_weights.h"
+#include "gtest/gtest.h"
+#include <sstream>
+#include <vector>
+
+namespace _hps_sudokill_eval_weights_gtest_h_
+{
+using namespace hps;
+
+TEST(EvalWeights, SaveLoad)
+{
+  EvalWeights weights;
+  weights.mobility = 3;
+  weights.playable = -7;
+  weights.deadCells = 11;
+  weights.parity = 400;
+  weights.randomPlayMoves = 40;
+  std::stringstream stream;
+  ASSERT_TRUE(weights.Save(stream));
+  EvalWeights loaded;
+  ASSERT_TRUE(loaded.Load(stream));
+  EXPECT_TRUE(weights == loaded);
+  // Comments, blank lines and missing fields are fine.
+  std::istringstream partial("# tuned\n\nparity 100  # late game\n");
+  EvalWeights defaults;
+  ASSERT_TRUE(defaults.Load(partial));
+  EXPECT_EQ(100, defaults.parity);
+  EXPECT_EQ(EvalWeights().mobility, defaults.mobility);
+  // Bad lines leave the weights alone.
+  const char* bad[] = { "nonsense 1\n", "parity\n", "parity 1 2\n", "mobility -1\n", };
+  for (size_t badIdx = 0; badIdx < sizeof(bad) / sizeof(bad[0]); ++badIdx)
+  {
+    std::istringstream in(std::string("parity 5\n") + bad[badIdx]);
+    EXPECT_FALSE(defaults.Load(in));
+    EXPECT_EQ(100, defaults.parity);
+  }
+}
+
+TEST(EvalWeights, DefaultsMatchShrinkPossibleMoves)
+{
+  Board board;
+  Board::MoveList plys;
+  for (int i = 0; i < 30; ++i)
+  {
+    board.ValidMoves(&plys);
+    ASSERT_FALSE(plys.empty());
+    board.PlayMove(plys[(i * 7) % plys.size()]);
+  }
+  board.ValidMoves(&plys);
+  const WeightedEvaluationFunc weighted;
+  const ShrinkPossibleMovesEvaluationFunc shrink;
+  EXPECT_FALSE(weighted.weights.UsesPropagation());
+  EXPECT_EQ(shrink(board), weighted(board));
+  std::vector<ChildEvaluation> weightedEvals(plys.size());
+  std::vector<ChildEvaluation> shrinkEvals(plys.size());
+  weighted.EvaluateChildren(board, plys, &weightedEvals[0]);
+  shrink.EvaluateChildren(board, plys, &shrinkEvals[0]);
+  for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+  {
+    EXPECT_EQ(shrinkEvals[plyIdx].score, weightedEvals[plyIdx].score);
+    EXPECT_EQ(shrinkEvals[plyIdx].terminal, weightedEvals[plyIdx].terminal);
+  }
+}
+
+TEST(EvalWeights, EvaluateChildrenMatchesMakeUndo)
+{
+  EvalWeights weights;
+  weights.playable = 5;
+  weights.deadCells = -9;
+  weights.parity = 300;
+  Board board;
+  Board::MoveList plys;
+  for (int i = 0; i < 35; ++i)
+  {
+    board.ValidMoves(&plys);
+    ASSERT_FALSE(plys.empty());
+    board.PlayMove(plys[(i * 5) % plys.size()]);
+  }
+  const WeightedEvaluationFunc f(weights, board.GetPlayerMovesCount());
+  board.ValidMoves(&plys);
+  std::vector<ChildEvaluation> evals(plys.size());
+  f.EvaluateChildren(board, plys, &evals[0]);
+  for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+  {
+    board.PlayMove(plys[plyIdx]);
+    EXPECT_EQ(f(board), evals[plyIdx].score);
+    Board::MoveList replies;
+    board.ValidMoves(&replies);
+    EXPECT_EQ(replies.empty(), evals[plyIdx].terminal);
+    board.Undo();
+  }
+}
+
+}
+
+#endif //_HPS_SUDOKILL_EVAL_WEIGHTS_GTEST_H_
@@ -0,0 +1,137 @@
+#ifndef _HPS_SUDOKILL_EVALUATION_H_
+#define _HPS_SUDOKILL_EVALUATION_H_
+#include "sudokill_core.h"
+#include "propagation.h"
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Score of one child of a frontier node. </summary>
+/// <remarks>
+///   <para> A terminal child has no Sudokill-valid moves, so the search
+///     scores it as a win or loss instead of using score.
+///   </para>
+/// </remarks>
+struct ChildEvaluation
+{
+  ChildEvaluation() : score(0), terminal(false), singleReply(false) {}
+  int score;
+  /// <summary> The child has no valid moves. </summary>
+  bool terminal;
+  /// <summary> The child has exactly one valid move. </summary>
+  bool singleReply;
+};
+
+/// <summary> Detect evaluators that can score all children of a node in one
+///   call through
+///   <code>
+///     void EvaluateChildren(const Board& parent,
+///                           const Board::MoveList& plys,
+///                           ChildEvaluation* evals) const;
+///   </code>
+/// </summary>
+template <typename BoardEvaulationFunction>
+struct EvaluatesChildren
+{
+  template <typename T>
+  static char Test(char (*)[sizeof(&T::EvaluateChildren)]);
+  template <typename T>
+  static long Test(...);
+  enum { value = sizeof(Test<BoardEvaulationFunction>(0)) == sizeof(char), };
+};
+
+/// <summary> Try to estimate the number of reachable cells left. </summary>
+struct ShrinkPossibleMovesEvaluationFunc
+{
+  inline int operator()(const Board& board) const
+  {
+    return board.GetCandidates().total;
+  }
+
+  /// <summary> Score every child from the parent's candidate masks. </summary>
+  void EvaluateChildren(const Board& parent,
+                        const Board::MoveList& plys,
+                        ChildEvaluation* evals) const
+  {
+    assert(evals);
+    const CandidateMasks& masks = parent.GetCandidates();
+    Board::MoveList::const_iterator ply = plys.begin();
+    const Board::MoveList::const_iterator plysEnd = plys.end();
+    for (; ply != plysEnd; ++ply, ++evals)
+    {
+      const int cellIdx = CandidateMasks::CellIndex(ply->location.x,
+                                                    ply->location.y);
+      const int replies = masks.ValidCountAfter(cellIdx, ply->value);
+      evals->terminal = 0 == replies;
+      evals->singleReply = 1 == replies;
+      evals->score = masks.SudokuCountAfter(cellIdx, ply->value);
+    }
+  }
+};
+
+/// <summary> Score a position by who is likely to make the last move. </summary>
+/// <remarks>
+///   <para> Constraint propagation estimates the moves left in the game. When
+///     that count is odd the player to move is expected to make the last move
+///     and leave the opponent stuck. The estimate's winner sets the sign of a
+///     large term, and the number of candidate values breaks ties as in
+///     ShrinkPossibleMovesEvaluationFunc.
+///   </para>
+///   <para> Scores are from the view of the player to move at the root, whose
+///     move count is given at construction.
+///   </para>
+/// </remarks>
+struct ParityEvaluationFunc
+{
+  /// <summary> Outweighs any candidate count (at most 9 * 81). </summary>
+  enum { ParityWeight = 1024, };
+
+  explicit ParityEvaluationFunc(const int rootMovesCount_ = 0)
+  : rootMovesCount(rootMovesCount_)
+  {}
+
+  inline int operator()(const Board& board) const
+  {
+    Propagation propagation;
+    propagation.Run(board);
+    const bool rootToMove = 0 == ((board.GetPlayerMovesCount() - rootMovesCount) & 1);
+    const bool moverLast = 1 == propagation.Parity();
+    const int total = board.GetCandidates().total;
+    return (rootToMove == moverLast) ? (ParityWeight + total) : (total - ParityWeight);
+  }
+
+  int rootMovesCount;
+};
+
+/// <summary> Score a position with the network attached to the board. </summary>
+/// <remarks>
+///   <para> The network scores for the player to move; the score is negated
+///     when that is not the player to move at the root, whose move count is
+///     given at construction. The board keeps the first layer current, so
+///     only the output layer runs here.
+///   </para>
+/// </remarks>
+struct NnueEvaluationFunc
+{
+  explicit NnueEvaluationFunc(const int rootMovesCount_ = 0)
+  : rootMovesCount(rootMovesCount_)
+  {}
+
+  inline int operator()(const Board& board) const
+  {
+    assert(board.GetNetwork());
+    const int score = board.GetNetwork()->Evaluate(board.GetAccumulator());
+    const bool rootToMove = 0 == ((board.GetPlayerMovesCount() - rootMovesCount) & 1);
+    return rootToMove ? score : -score;
+  }
+
+  int rootMovesCount;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_EVALUATION_H_
@@ -0,0 +1,103 @@
+#ifndef _HPS_SUDOKILL_EVALUATION_GTEST_H_
+#define _HPS_SUDOKILL_EVALUATION_GTEST_H_
+
+#include "evaluation.h"
+#include "alphabetapruning.h"
+#include "sudokill_gtest_util.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_evaluation_gtest_h_
+{
+using namespace hps;
+using namespace hps::sudokill_gtest;
+
+/// <summary> Hide EvaluateChildren() to force the per-child search. </summary>
+struct PerChildEvaluationFunc
+{
+  inline int operator()(const Board& board) const { return f(board); }
+  ShrinkPossibleMovesEvaluationFunc f;
+};
+
+TEST(Evaluation, EvaluatesChildren)
+{
+  EXPECT_TRUE(EvaluatesChildren<ShrinkPossibleMovesEvaluationFunc>::value);
+  EXPECT_FALSE(EvaluatesChildren<PerChildEvaluationFunc>::value);
+}
+
+TEST(Evaluation, EvaluateChildrenMatchesMakeUndo)
+{
+  ShrinkPossibleMovesEvaluationFunc f;
+  Board::MoveList plys;
+  Board::MoveList childPlys;
+  std::vector<ChildEvaluation> evals;
+  for (int trial = 0; trial < 50; ++trial)
+  {
+    Board board;
+    PlayRandomMoves(RandBound(70), &board);
+    board.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      continue;
+    }
+    evals.resize(plys.size());
+    f.EvaluateChildren(board, plys, &evals[0]);
+    for (size_t plyIdx = 0; plyIdx < plys.size(); ++plyIdx)
+    {
+      board.PlayMove(plys[plyIdx]);
+      board.ValidMoves(&childPlys);
+      EXPECT_EQ(childPlys.empty(), evals[plyIdx].terminal);
+      EXPECT_EQ(1 == childPlys.size(), evals[plyIdx].singleReply);
+      EXPECT_EQ(f(board), evals[plyIdx].score);
+      board.Undo();
+    }
+  }
+}
+
+TEST(Evaluation, BatchedSearchMatchesPerChildSearch)
+{
+  ShrinkPossibleMovesEvaluationFunc batchFunc;
+  PerChildEvaluationFunc perChildFunc;
+  for (int trial = 0; trial < 5; ++trial)
+  {
+    Board board;
+    PlayRandomMoves(40 + RandBound(20), &board);
+    AlphaBetaPruning::Params batchParams;
+    batchParams.maxDepth = 4;
+    AlphaBetaPruning::Params perChildParams = batchParams;
+    Cell batchPly;
+    Cell perChildPly;
+    const int batchScore = AlphaBetaPruning::Run(&batchParams, &board,
+                                                 &batchFunc, &batchPly);
+    const int perChildScore = AlphaBetaPruning::Run(&perChildParams, &board,
+                                                    &perChildFunc, &perChildPly);
+    EXPECT_EQ(perChildScore, batchScore);
+  }
+}
+
+/// <summary> Deep enough for single-reply extensions and late-move
+///   reductions to meet in the batched frontier.
+/// </summary>
+TEST(Evaluation, BatchedSearchMatchesPerChildSearchWithSelectivity)
+{
+  ShrinkPossibleMovesEvaluationFunc batchFunc;
+  PerChildEvaluationFunc perChildFunc;
+  for (int trial = 0; trial < 5; ++trial)
+  {
+    Board board;
+    PlayRandomMoves(40 + RandBound(20), &board);
+    AlphaBetaPruning::Params batchParams;
+    batchParams.maxDepth = 5;
+    AlphaBetaPruning::Params perChildParams = batchParams;
+    Cell batchPly;
+    Cell perChildPly;
+    const int batchScore = AlphaBetaPruning::Run(&batchParams, &board,
+                                                 &batchFunc, &batchPly);
+    const int perChildScore = AlphaBetaPruning::Run(&perChildParams, &board,
+                                                    &perChildFunc, &perChildPly);
+    EXPECT_EQ(perChildScore, batchScore);
+  }
+}
+
+}
+
+#endif //_HPS_SUDOKILL_EVALUATION_GTEST_H_
@@ -0,0 +1,433 @@
+#ifndef _HPS_SUDOKILL_GAME_RECORD_H_
+#define _HPS_SUDOKILL_GAME_RECORD_H_
+#include "sudokill_core.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> One position the client answered, with its move and search. </summary>
+/// <remarks>
+///   <para> The position keeps what decides play: the value in every cell,
+///     the last move and the move count. ToBoard() rebuilds it with every
+///     cell but the last move as a preset.
+///   </para>
+///   <para> On disk a record is RecordBytes little-endian bytes:
+///     <code>
+///        0  cell values, two cells per byte, low nibble first (41 bytes)
+///       41  last move cell, or NoCell
+///       42  move cell, or NoCell; 43 move value
+///       44  search depth; 45 selective depth
+///       46  uint16 game; 48 uint16 round; 50 uint16 move count
+///       52  int32 score
+///       56  uint32 latency in microseconds
+///       60  uint64 nodes
+///       68  uint32 flags
+///     </code>
+///   </para>
+/// </remarks>
+struct GameRecord
+{
+  enum { RecordBytes = 72, };
+  enum { NoCell = 0xFF, };
+  enum
+  {
+    /// <summary> The last search iteration finished. </summary>
+    Flag_Complete = 1 << 0,
+    /// <summary> The move was random; there was no search. </summary>
+    Flag_Random = 1 << 1,
+  };
+
+  GameRecord()
+  : lastMove(NoCell),
+    moveCell(NoCell),
+    moveValue(0),
+    depth(0),
+    selDepth(0),
+    game(0),
+    round(0),
+    playerMoves(0),
+    score(0),
+    latencyUs(0),
+    nodes(0),
+    flags(0)
+  {
+    memset(values, 0, sizeof(values));
+  }
+
+  /// <summary> Record the position of the board. </summary>
+  void SetPosition(const Board& board)
+  {
+    for (int cellIdx = 0; cellIdx < CandidateMasks::NumCells; ++cellIdx)
+    {
+      values[cellIdx] = static_cast<uint8_t>(
+        board.ValueAt(Point(CandidateMasks::CellX(cellIdx), CandidateMasks::CellY(cellIdx))));
+    }
+    playerMoves = static_cast<uint16_t>(board.GetPlayerMovesCount());
+    lastMove = (board.GetPlayerMovesCount() > 0) ?
+               static_cast<uint8_t>(CellIndex(board.GetLastMove().location)) :
+               static_cast<uint8_t>(NoCell);
+  }
+
+  /// <summary> Rebuild the position. Presets stand in for the moves before
+  ///   the last, so the board plays alike but its move count is 0 or 1.
+  /// </summary>
+  void ToBoard(Board* board) const
+  {
+    assert(board);
+    Board::MoveList presets;
+    for (int cellIdx = 0; cellIdx < CandidateMasks::NumCells; ++cellIdx)
+    {
+      if ((0 != values[cellIdx]) && (cellIdx != lastMove))
+      {
+        presets.push_back(CellAt(cellIdx, values[cellIdx]));
+      }
+    }
+    *board = Board(presets);
+    if (NoCell != lastMove)
+    {
+      board->PlayMove(CellAt(lastMove, values[lastMove]));
+    }
+  }
+
+  inline void SetMove(const Cell& move)
+  {
+    moveCell = static_cast<uint8_t>(CellIndex(move.location));
+    moveValue = static_cast<uint8_t>(move.value);
+  }
+
+  inline Cell GetMove() const
+  {
+    return (NoCell != moveCell) ? CellAt(moveCell, moveValue) : Cell();
+  }
+
+  void Encode(unsigned char* bytes) const
+  {
+    assert(bytes);
+    memset(bytes, 0, RecordBytes);
+    for (int cellIdx = 0; cellIdx < CandidateMasks::NumCells; ++cellIdx)
+    {
+      bytes[cellIdx / 2] |= static_cast<unsigned char>(values[cellIdx] << (4 * (cellIdx & 1)));
+    }
+    bytes[41] = lastMove;
+    bytes[42] = moveCell;
+    bytes[43] = moveValue;
+    bytes[44] = depth;
+    bytes[45] = selDepth;
+    Put(game, 2, bytes + 46);
+    Put(round, 2, bytes + 48);
+    Put(playerMoves, 2, bytes + 50);
+    Put(static_cast<uint32_t>(score), 4, bytes + 52);
+    Put(latencyUs, 4, bytes + 56);
+    Put(nodes, 8, bytes + 60);
+    Put(flags, 4, bytes + 68);
+  }
+
+  /// <summary> Decode a record; false when it does not hold a position. </summary>
+  bool Decode(const unsigned char* bytes)
+  {
+    assert(bytes);
+    for (int cellIdx = 0; cellIdx < CandidateMasks::NumCells; ++cellIdx)
+    {
+      values[cellIdx] = static_cast<uint8_t>((bytes[cellIdx / 2] >> (4 * (cellIdx & 1))) & 0xF);
+      if (values[cellIdx] > Board::MaxValue)
+      {
+        return false;
+      }
+    }
+    lastMove = bytes[41];
+    moveCell = bytes[42];
+    moveValue = bytes[43];
+    depth = bytes[44];
+    selDepth = bytes[45];
+    game = static_cast<uint16_t>(Get(bytes + 46, 2));
+    round = static_cast<uint16_t>(Get(bytes + 48, 2));
+    playerMoves = static_cast<uint16_t>(Get(bytes + 50, 2));
+    score = static_cast<int32_t>(static_cast<uint32_t>(Get(bytes + 52, 4)));
+    latencyUs = static_cast<uint32_t>(Get(bytes + 56, 4));
+    nodes = Get(bytes + 60, 8);
+    flags = static_cast<uint32_t>(Get(bytes + 68, 4));
+    return ((NoCell == lastMove) ||
+            ((lastMove < CandidateMasks::NumCells) && (0 != values[lastMove]))) &&
+           ((NoCell == moveCell) || (moveCell < CandidateMasks::NumCells));
+  }
+
+  uint8_t values[CandidateMasks::NumCells];
+  uint8_t lastMove;
+  uint8_t moveCell;
+  uint8_t moveValue;
+  uint8_t depth;
+  uint8_t selDepth;
+  /// <summary> Connection the position came from. </summary>
+  uint16_t game;
+  /// <summary> Turn of the client within its game. </summary>
+  uint16_t round;
+  uint16_t playerMoves;
+  int32_t score;
+  /// <summary> From reading the state to sending the move. </summary>
+  uint32_t latencyUs;
+  uint64_t nodes;
+  uint32_t flags;
+
+private:
+  inline static int CellIndex(const Point& p)
+  {
+    return CandidateMasks::CellIndex(p.x, p.y);
+  }
+
+  inline static Cell CellAt(const int cellIdx, const int value)
+  {
+    return Cell(Point(CandidateMasks::CellX(cellIdx), CandidateMasks::CellY(cellIdx)), value);
+  }
+
+  inline static void Put(uint64_t value, const int numBytes, unsigned char* bytes)
+  {
+    for (int byteIdx = 0; byteIdx < numBytes; ++byteIdx, value >>= 8)
+    {
+      bytes[byteIdx] = static_cast<unsigned char>(value & 0xFF);
+    }
+  }
+
+  inline static uint64_t Get(const unsigned char* bytes, const int numBytes)
+  {
+    uint64_t value = 0;
+    for (int byteIdx = numBytes - 1; byteIdx >= 0; --byteIdx)
+    {
+      value = (value << 8) | bytes[byteIdx];
+    }
+    return value;
+  }
+};
+
+/// <summary> Layout of a game record file: a header, then records. </summary>
+struct GameRecordFormat
+{
+  enum { Magic = 0x52474B53, }; // "SKGR"
+  enum { Version = 1, };
+  enum { HeaderBytes = 16, };
+
+  static void EncodeHeader(unsigned char* bytes)
+  {
+    memset(bytes, 0, HeaderBytes);
+    const uint32_t words[3] = { static_cast<uint32_t>(Magic),
+                                static_cast<uint32_t>(Version),
+                                static_cast<uint32_t>(GameRecord::RecordBytes), };
+    for (int wordIdx = 0; wordIdx < 3; ++wordIdx)
+    {
+      for (int byteIdx = 0; byteIdx < 4; ++byteIdx)
+      {
+        bytes[(4 * wordIdx) + byteIdx] =
+          static_cast<unsigned char>((words[wordIdx] >> (8 * byteIdx)) & 0xFF);
+      }
+    }
+  }
+
+  static bool HeaderMatches(const unsigned char* bytes)
+  {
+    unsigned char expected[HeaderBytes];
+    EncodeHeader(expected);
+    return 0 == memcmp(expected, bytes, HeaderBytes);
+  }
+};
+
+/// <summary> Append records to a game record file. </summary>
+/// <remarks>
+///   <para> Each record is flushed as it is written, so a crash loses at
+///     most the record being written.
+///   </para>
+/// </remarks>
+class GameRecorder
+{
+public:
+  GameRecorder() : file(NULL) {}
+
+  ~GameRecorder()
+  {
+    Close();
+  }
+
+  /// <summary> Open for appending, writing the header to a new file. Fails
+  ///   on a file that is not a game record.
+  /// </summary>
+  bool Open(const std::string& path)
+  {
+    Close();
+    file = fopen(path.c_str(), "a+b");
+    if (NULL == file)
+    {
+      return false;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    unsigned char header[GameRecordFormat::HeaderBytes];
+    bool ok;
+    if (0 == size)
+    {
+      GameRecordFormat::EncodeHeader(header);
+      ok = (1 == fwrite(header, sizeof(header), 1, file)) && (0 == fflush(file));
+    }
+    else
+    {
+      fseek(file, 0, SEEK_SET);
+      ok = (1 == fread(header, sizeof(header), 1, file)) &&
+           GameRecordFormat::HeaderMatches(header) &&
+           (0 == ((size - GameRecordFormat::HeaderBytes) % GameRecord::RecordBytes));
+    }
+    if (!ok)
+    {
+      Close();
+    }
+    return ok;
+  }
+
+  inline bool IsOpen() const
+  {
+    return NULL != file;
+  }
+
+  bool Append(const GameRecord& record)
+  {
+    assert(file);
+    unsigned char bytes[GameRecord::RecordBytes];
+    record.Encode(bytes);
+    return (1 == fwrite(bytes, sizeof(bytes), 1, file)) && (0 == fflush(file));
+  }
+
+  void Close()
+  {
+    if (NULL != file)
+    {
+      fclose(file);
+      file = NULL;
+    }
+  }
+
+private:
+  GameRecorder(const GameRecorder&);
+  GameRecorder& operator=(const GameRecorder&);
+
+  FILE* file;
+};
+
+/// <summary> Read-only view of a game record file. </summary>
+/// <remarks>
+///   <para> On Linux the file is memory-mapped, so a large corpus costs no
+///     reads up front and records decode straight from the page cache.
+///     Elsewhere it is read into memory.
+///   </para>
+/// </remarks>
+class GameRecordFile
+{
+public:
+  GameRecordFile() : data(NULL), size(0), mapped(false), buffer() {}
+
+  ~GameRecordFile()
+  {
+    Close();
+  }
+
+  /// <summary> Open a whole game record file; false if it is not one. </summary>
+  bool Open(const std::string& path)
+  {
+    Close();
+#ifdef __linux__
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return false;
+    }
+    struct stat st;
+    if ((0 == fstat(fd, &st)) && (st.st_size > 0))
+    {
+      void* view = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED != view)
+      {
+        data = static_cast<const unsigned char*>(view);
+        size = static_cast<size_t>(st.st_size);
+        mapped = true;
+      }
+    }
+    close(fd);
+#else
+    FILE* file = fopen(path.c_str(), "rb");
+    if (NULL == file)
+    {
+      return false;
+    }
+    unsigned char chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+      buffer.insert(buffer.end(), chunk, chunk + read);
+    }
+    fclose(file);
+    data = buffer.empty() ? NULL : &buffer[0];
+    size = buffer.size();
+#endif
+    if ((size < GameRecordFormat::HeaderBytes) ||
+        !GameRecordFormat::HeaderMatches(data) ||
+        (0 != ((size - GameRecordFormat::HeaderBytes) % GameRecord::RecordBytes)))
+    {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  /// <summary> Number of records. </summary>
+  inline size_t Size() const
+  {
+    return (NULL != data) ?
+           ((size - GameRecordFormat::HeaderBytes) / GameRecord::RecordBytes) : 0;
+  }
+
+  /// <summary> Decode a record; false when it is corrupt. </summary>
+  inline bool Get(const size_t recordIdx, GameRecord* record) const
+  {
+    assert(record && (recordIdx < Size()));
+    return record->Decode(data + GameRecordFormat::HeaderBytes +
+                          (recordIdx * GameRecord::RecordBytes));
+  }
+
+  void Close()
+  {
+#ifdef __linux__
+    if (mapped)
+    {
+      munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+    data = NULL;
+    size = 0;
+    mapped = false;
+    buffer.clear();
+  }
+
+private:
+  GameRecordFile(const GameRecordFile&);
+  GameRecordFile& operator=(const GameRecordFile&);
+
+  const unsigned char* data;
+  size_t size;
+  bool mapped;
+  std::vector<unsigned char> buffer;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_GAME_RECORD_H_
@@ -0,0 +1,164 @@
+#ifndef _HPS_SUDOKILL_GAME_RECORD_GTEST_H_
+#define _HPS_SUDOKILL_GAME_RECORD_GTEST_H_
+
+#include "game_record.h"
+#include "gtest/gtest.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace _hps_sudokill_game_record_gtest_h_
+{
+using namespace hps;
+
+/// <summary> Play numMoves moves of a fixed game. </summary>
+inline void PlayGame(const int numMoves, Board* board)
+{
+  Board::MoveList plys;
+  for (int moveIdx = 0; moveIdx < numMoves; ++moveIdx)
+  {
+    board->ValidMoves(&plys);
+    ASSERT_FALSE(plys.empty());
+    board->PlayMove(plys[(moveIdx * 11) % plys.size()]);
+  }
+}
+
+/// <summary> Valid moves as sorted cell index and value keys. </summary>
+inline std::vector<int> SortedMoves(const Board& board)
+{
+  Board::MoveList plys;
+  board.ValidMoves(&plys);
+  std::vector<int> moves;
+  for (Board::MoveList::const_iterator ply = plys.begin(); ply != plys.end(); ++ply)
+  {
+    moves.push_back((CandidateMasks::CellIndex(ply->location.x, ply->location.y) * 16) +
+                    ply->value);
+  }
+  std::sort(moves.begin(), moves.end());
+  return moves;
+}
+
+TEST(GameRecord, EncodeDecode)
+{
+  Board board;
+  PlayGame(23, &board);
+  GameRecord record;
+  record.SetPosition(board);
+  record.SetMove(Cell(Point(8, 7), 3));
+  record.depth = 9;
+  record.selDepth = 14;
+  record.game = 3;
+  record.round = 11;
+  record.score = -1234;
+  record.latencyUs = 456789;
+  record.nodes = 0x123456789ULL;
+  record.flags = GameRecord::Flag_Complete;
+  unsigned char bytes[GameRecord::RecordBytes];
+  record.Encode(bytes);
+  GameRecord decoded;
+  ASSERT_TRUE(decoded.Decode(bytes));
+  EXPECT_EQ(0, memcmp(record.values, decoded.values, sizeof(record.values)));
+  EXPECT_EQ(record.lastMove, decoded.lastMove);
+  EXPECT_EQ(record.GetMove(), decoded.GetMove());
+  EXPECT_EQ(record.depth, decoded.depth);
+  EXPECT_EQ(record.selDepth, decoded.selDepth);
+  EXPECT_EQ(record.game, decoded.game);
+  EXPECT_EQ(record.round, decoded.round);
+  EXPECT_EQ(23, decoded.playerMoves);
+  EXPECT_EQ(record.score, decoded.score);
+  EXPECT_EQ(record.latencyUs, decoded.latencyUs);
+  EXPECT_EQ(record.nodes, decoded.nodes);
+  EXPECT_EQ(record.flags, decoded.flags);
+  // A value out of range is corrupt.
+  bytes[5] = 0xF0;
+  EXPECT_FALSE(decoded.Decode(bytes));
+}
+
+TEST(GameRecord, ToBoardPlaysAlike)
+{
+  Board board;
+  GameRecord record;
+  record.SetPosition(board);
+  EXPECT_EQ(GameRecord::NoCell, record.lastMove);
+  Board rebuilt(Board::MoveList(1, Cell(Point(0, 0), 1)));
+  record.ToBoard(&rebuilt);
+  EXPECT_EQ(SortedMoves(board), SortedMoves(rebuilt));
+  for (int step = 0; step < 5; ++step)
+  {
+    PlayGame(7, &board);
+    record.SetPosition(board);
+    record.ToBoard(&rebuilt);
+    EXPECT_EQ(1, rebuilt.GetPlayerMovesCount());
+    EXPECT_EQ(board.GetLastMove(), rebuilt.GetLastMove());
+    EXPECT_EQ(board.Hash(), rebuilt.Hash());
+    EXPECT_EQ(board.GetCandidates().total, rebuilt.GetCandidates().total);
+    EXPECT_EQ(SortedMoves(board), SortedMoves(rebuilt));
+  }
+}
+
+TEST(GameRecord, RecorderFileRoundTrip)
+{
+  const std::string path = "game_record_gtest.skgr";
+  remove(path.c_str());
+  Board board;
+  {
+    GameRecorder recorder;
+    ASSERT_TRUE(recorder.Open(path));
+    for (int recordIdx = 0; recordIdx < 3; ++recordIdx)
+    {
+      PlayGame(5, &board);
+      GameRecord record;
+      record.SetPosition(board);
+      record.round = static_cast<uint16_t>(recordIdx);
+      ASSERT_TRUE(recorder.Append(record));
+    }
+  }
+  {
+    // Reopening appends after the records already there.
+    GameRecorder recorder;
+    ASSERT_TRUE(recorder.Open(path));
+    GameRecord record;
+    record.round = 3;
+    record.flags = GameRecord::Flag_Random;
+    ASSERT_TRUE(recorder.Append(record));
+  }
+  GameRecordFile file;
+  ASSERT_TRUE(file.Open(path));
+  ASSERT_EQ(4U, file.Size());
+  for (size_t recordIdx = 0; recordIdx < file.Size(); ++recordIdx)
+  {
+    GameRecord record;
+    ASSERT_TRUE(file.Get(recordIdx, &record));
+    EXPECT_EQ(recordIdx, record.round);
+  }
+  GameRecord last;
+  ASSERT_TRUE(file.Get(2, &last));
+  EXPECT_EQ(15, last.playerMoves);
+  Board rebuilt;
+  last.ToBoard(&rebuilt);
+  EXPECT_EQ(board.Hash(), rebuilt.Hash());
+  file.Close();
+  remove(path.c_str());
+}
+
+TEST(GameRecord, RejectsOtherFiles)
+{
+  const std::string path = "game_record_gtest.skgr";
+  FILE* other = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(NULL != other);
+  fputs("mobility 1\nparity 0\n", other);
+  fclose(other);
+  GameRecorder recorder;
+  EXPECT_FALSE(recorder.Open(path));
+  EXPECT_FALSE(recorder.IsOpen());
+  GameRecordFile file;
+  EXPECT_FALSE(file.Open(path));
+  EXPECT_EQ(0U, file.Size());
+  remove(path.c_str());
+}
+
+}
+
+#endif //_HPS_SUDOKILL_GAME_RECORD_GTEST_H_
@@ -0,0 +1,253 @@
+#ifndef _HPS_UTIL_LOG_H_
+#define _HPS_UTIL_LOG_H_
+
+#include <stddef.h>
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iostream>
+
+namespace hps
+{
+namespace util
+{
+
+enum LogLevel
+{
+  Log_Debug,
+  Log_Info,
+  Log_Warning,
+  Log_Error,
+  Log_None,
+};
+
+}
+}
+
+/// <summary> Levels below this are compiled out and are the default runtime
+///   level. Debug logs are kept only in debug builds unless defined otherwise.
+/// </summary>
+#ifndef HPS_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define HPS_LOG_MIN_LEVEL ::hps::util::Log_Info
+#else
+#define HPS_LOG_MIN_LEVEL ::hps::util::Log_Debug
+#endif
+#endif
+
+/// <summary> Log a streamed message, e.g.
+///   <code> HPS_LOG(Log_Info, "Played " << rounds << " rounds."); </code>
+///   The message is formatted only when the level is on; the write and flush
+///   happen on the logger's thread.
+/// </summary>
+#define HPS_LOG(level, message) \
+  do \
+  { \
+    if ((::hps::util::level >= HPS_LOG_MIN_LEVEL) && \
+        ::hps::util::Logger::Enabled(::hps::util::level)) \
+    { \
+      std::ostringstream hpsLogStream; \
+      hpsLogStream << message; \
+      ::hps::util::Logger::Get().Push(::hps::util::level, hpsLogStream.str()); \
+    } \
+  } while (0)
+
+namespace hps
+{
+namespace util
+{
+
+/// <summary> Leveled logger that writes on a background thread. </summary>
+/// <remarks>
+///   <para> Messages go through a bounded lock-free queue (Dmitry Vyukov's
+///     MPMC ring) to a writer thread that flushes once per batch, so logging
+///     never waits on the terminal. When the queue is full the message is
+///     dropped and counted rather than blocking the caller.
+///   </para>
+///   <para> The writer starts on the first message and drains the queue when
+///     the process exits. Call Flush() before writing to the sink directly.
+///   </para>
+/// </remarks>
+class Logger
+{
+public:
+  enum { Capacity = 1024, };
+
+  static Logger& Get()
+  {
+    static Logger s_logger;
+    return s_logger;
+  }
+
+  /// <summary> Test the runtime level; see also HPS_LOG_MIN_LEVEL. </summary>
+  inline static bool Enabled(const LogLevel level)
+  {
+    return level >= MinLevel().load(std::memory_order_relaxed);
+  }
+
+  static void SetLevel(const LogLevel level)
+  {
+    MinLevel().store(level, std::memory_order_relaxed);
+  }
+
+  /// <summary> Queue a message. Never blocks. </summary>
+  /// <returns> False when the queue was full and the message dropped. </returns>
+  bool Push(const LogLevel level, const std::string& message)
+  {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Slot& slot = slots[pos & (Capacity - 1)];
+      const size_t seq = slot.seq.load(std::memory_order_acquire);
+      const ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+      if (0 == diff)
+      {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          slot.level = level;
+          slot.message = message;
+          slot.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else
+      {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// <summary> Wait until every message queued so far is written. </summary>
+  void Flush()
+  {
+    const size_t target = enqueuePos.load(std::memory_order_acquire);
+    while (dequeuePos.load(std::memory_order_acquire) < target)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  /// <summary> Redirect output. Flushes first; not for use while logging
+  ///   from other threads.
+  /// </summary>
+  void SetSink(std::ostream* sink_)
+  {
+    assert(sink_);
+    Flush();
+    sink.store(sink_, std::memory_order_release);
+  }
+
+  inline size_t Dropped() const
+  {
+    return dropped.load(std::memory_order_relaxed);
+  }
+
+  static const char* Prefix(const LogLevel level)
+  {
+    switch (level)
+    {
+    case Log_Warning: return "WARNING: ";
+    case Log_Error: return "ERROR: ";
+    default: return "";
+    }
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> seq;
+    LogLevel level;
+    std::string message;
+  };
+
+  Logger()
+  : enqueuePos(0),
+    dequeuePos(0),
+    dropped(0),
+    stop(false),
+    sink(&std::cout),
+    writer()
+  {
+    for (size_t slotIdx = 0; slotIdx < Capacity; ++slotIdx)
+    {
+      slots[slotIdx].seq.store(slotIdx, std::memory_order_relaxed);
+    }
+    writer = std::thread(&Logger::WriterLoop, this);
+  }
+
+  ~Logger()
+  {
+    stop.store(true, std::memory_order_release);
+    writer.join();
+  }
+
+  Logger(const Logger&);
+  Logger& operator=(const Logger&);
+
+  static std::atomic<int>& MinLevel()
+  {
+    static std::atomic<int> s_minLevel(HPS_LOG_MIN_LEVEL);
+    return s_minLevel;
+  }
+
+  /// <summary> Write all queued messages; flush once if any. </summary>
+  bool Drain()
+  {
+    std::ostream& out = *sink.load(std::memory_order_acquire);
+    const size_t begin = dequeuePos.load(std::memory_order_relaxed);
+    size_t pos = begin;
+    for (;; ++pos)
+    {
+      Slot& slot = slots[pos & (Capacity - 1)];
+      if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+      {
+        break;
+      }
+      out << Prefix(slot.level) << slot.message << '\n';
+      slot.message.clear();
+      slot.seq.store(pos + Capacity, std::memory_order_release);
+    }
+    if (pos == begin)
+    {
+      return false;
+    }
+    // Publish after the flush so that Flush() covers it.
+    out.flush();
+    dequeuePos.store(pos, std::memory_order_release);
+    return true;
+  }
+
+  void WriterLoop()
+  {
+    while (!stop.load(std::memory_order_acquire))
+    {
+      if (!Drain())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    Drain();
+  }
+
+  Slot slots[Capacity];
+  std::atomic<size_t> enqueuePos;
+  std::atomic<size_t> dequeuePos;
+  std::atomic<size_t> dropped;
+  std::atomic<bool> stop;
+  std::atomic<std::ostream*> sink;
+  std::thread writer;
+};
+
+}
+using namespace util;
+}
+
+#endif //_HPS_UTIL_LOG_H_
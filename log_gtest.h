@@ -0,0 +1,59 @@
+#ifndef _HPS_UTIL_LOG_GTEST_H_
+#define _HPS_UTIL_LOG_GTEST_H_
+
+#include "log.h"
+#include "gtest/gtest.h"
+#include <omp.h>
+#include <sstream>
+
+namespace _hps_util_log_gtest_h_
+{
+using namespace hps;
+
+TEST(Logger, Levels)
+{
+  std::stringstream ss;
+  Logger& logger = Logger::Get();
+  logger.SetSink(&ss);
+  Logger::SetLevel(Log_Info);
+  int formatted = 0;
+  HPS_LOG(Log_Debug, "hidden " << ++formatted);
+  HPS_LOG(Log_Info, "shown " << ++formatted);
+  HPS_LOG(Log_Warning, "careful");
+  HPS_LOG(Log_Error, "broken");
+  logger.Flush();
+  // Filtered messages are not even formatted.
+  EXPECT_EQ(1, formatted);
+  EXPECT_EQ(std::string("shown 1\nWARNING: careful\nERROR: broken\n"), ss.str());
+  Logger::SetLevel(HPS_LOG_MIN_LEVEL);
+  logger.SetSink(&std::cout);
+}
+
+TEST(Logger, ManyThreads)
+{
+  enum { NumMessages = 512, };
+  std::stringstream ss;
+  Logger& logger = Logger::Get();
+  logger.SetSink(&ss);
+  Logger::SetLevel(Log_Info);
+  const size_t droppedBefore = logger.Dropped();
+#pragma omp parallel for
+  for (int messageIdx = 0; messageIdx < NumMessages; ++messageIdx)
+  {
+    HPS_LOG(Log_Info, "message " << messageIdx);
+  }
+  logger.Flush();
+  const std::string text = ss.str();
+  int lines = 0;
+  for (size_t pos = text.find('\n'); std::string::npos != pos; pos = text.find('\n', pos + 1))
+  {
+    ++lines;
+  }
+  EXPECT_EQ(static_cast<size_t>(NumMessages), lines + (logger.Dropped() - droppedBefore));
+  Logger::SetLevel(HPS_LOG_MIN_LEVEL);
+  logger.SetSink(&std::cout);
+}
+
+}
+
+#endif //_HPS_UTIL_LOG_GTEST_H_
@@ -0,0 +1,351 @@
+#ifndef _HPS_SUDOKILL_NNUE_H_
+#define _HPS_SUDOKILL_NNUE_H_
+#include "candidate_masks.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <fstream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HPS_NNUE_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace hps
+{
+namespace sudokill
+{
+
+namespace detail
+{
+
+inline void NnueAddScalar(const int16_t* row, const int size, int16_t* acc)
+{
+  for (int i = 0; i < size; ++i)
+  {
+    acc[i] = static_cast<int16_t>(acc[i] + row[i]);
+  }
+}
+
+inline void NnueSubScalar(const int16_t* row, const int size, int16_t* acc)
+{
+  for (int i = 0; i < size; ++i)
+  {
+    acc[i] = static_cast<int16_t>(acc[i] - row[i]);
+  }
+}
+
+inline int NnueOutputScalar(const int16_t* acc, const int8_t* weights, const int size)
+{
+  int sum = 0;
+  for (int i = 0; i < size; ++i)
+  {
+    const int clipped = (acc[i] < 0) ? 0 : ((acc[i] > 127) ? 127 : acc[i]);
+    sum += clipped * weights[i];
+  }
+  return sum;
+}
+
+#ifdef HPS_NNUE_SIMD
+__attribute__((target("avx2")))
+inline void NnueAddAvx2(const int16_t* row, const int size, int16_t* acc)
+{
+  for (int i = 0; i < size; i += 16)
+  {
+    __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+    _mm256_storeu_si256(a, _mm256_add_epi16(
+      _mm256_loadu_si256(a), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i))));
+  }
+}
+
+__attribute__((target("avx2")))
+inline void NnueSubAvx2(const int16_t* row, const int size, int16_t* acc)
+{
+  for (int i = 0; i < size; i += 16)
+  {
+    __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+    _mm256_storeu_si256(a, _mm256_sub_epi16(
+      _mm256_loadu_si256(a), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i))));
+  }
+}
+
+__attribute__((target("avx2")))
+inline int NnueOutputAvx2(const int16_t* acc, const int8_t* weights, const int size)
+{
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (int i = 0; i < size; i += 32)
+  {
+    // Saturating packs clip to [0, 255]; the min first makes it [0, 127].
+    const __m256i max = _mm256_set1_epi16(127);
+    const __m256i a0 = _mm256_min_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i)), max);
+    const __m256i a1 = _mm256_min_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i + 16)), max);
+    // Packing works per 128-bit lane, so restore the neuron order afterwards.
+    const __m256i clipped = _mm256_permute4x64_epi64(_mm256_packus_epi16(a0, a1),
+                                                     _MM_SHUFFLE(3, 1, 2, 0));
+    const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+    // Pair sums reach at most 2 * 127 * 128, which fits 16 bits.
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(clipped, w), ones));
+  }
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(half);
+}
+#endif // HPS_NNUE_SIMD
+
+} // end ns detail
+
+/// <summary> Instruction sets with NNUE kernels. </summary>
+enum NnueIsa
+{
+  NnueIsa_Scalar,
+  NnueIsa_Avx2,
+};
+
+/// <summary> Test if the running CPU can execute the given kernels. </summary>
+inline bool NnueIsaSupported(const NnueIsa isa)
+{
+  switch (isa)
+  {
+  case NnueIsa_Scalar:
+    return true;
+#ifdef HPS_NNUE_SIMD
+  case NnueIsa_Avx2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+/// <summary> Best supported instruction set, detected once. </summary>
+inline NnueIsa BestNnueIsa()
+{
+  static const NnueIsa s_isa =
+    NnueIsaSupported(NnueIsa_Avx2) ? NnueIsa_Avx2 : NnueIsa_Scalar;
+  return s_isa;
+}
+
+/// <summary> A small quantized network that scores a position for the
+///   player to move.
+/// </summary>
+/// <remarks>
+///   <para> The inputs are the 729 (cell, value) placements and the cell of
+///     the last move, 810 features in all. The first layer is a sum of int16
+///     weight rows, one per active feature, kept by the board in an
+///     accumulator. Each move adds one placement row and swaps the last-move
+///     row, and Undo() applies the same rows in reverse, so the board never
+///     recomputes the layer during a search. Integer wraparound cancels out,
+///     so the updates are exact.
+///   </para>
+///   <para> The output clips the accumulator to [0, 127] and takes its dot
+///     product with int8 weights, then adds a bias and shifts right by
+///     OutputShift.
+///   </para>
+///   <para> Weights file, little endian: the uint32 Magic, the uint32
+///     HiddenSize, int16 hidden biases, int16 feature rows in feature order,
+///     int8 output weights and an int32 output bias.
+///   </para>
+/// </remarks>
+class NnueNetwork
+{
+public:
+  enum { NumPlacements = CandidateMasks::NumCells * CandidateMasks::Dim, };
+  enum { NumFeatures = NumPlacements + CandidateMasks::NumCells, };
+  // A multiple of the 32 neurons of one AVX2 output step.
+  enum { HiddenSize = 64, };
+  enum { OutputShift = 4, };
+  enum { Magic = 0x314E4B53, }; // "SKN1"
+
+  NnueNetwork()
+  : hiddenBias(HiddenSize, 0),
+    featureWeights(NumFeatures * HiddenSize, 0),
+    outputWeights(HiddenSize, 0),
+    outputBias(0),
+    isa(NnueIsa_Scalar)
+  {
+    SetIsa(BestNnueIsa());
+  }
+
+  inline static int PlacementFeature(const int cellIdx, const int value)
+  {
+    assert(cellIdx >= 0 && cellIdx < CandidateMasks::NumCells);
+    assert(value >= 1 && value <= CandidateMasks::Dim);
+    return (cellIdx * CandidateMasks::Dim) + (value - 1);
+  }
+
+  inline static int LastMoveFeature(const int cellIdx)
+  {
+    assert(cellIdx >= 0 && cellIdx < CandidateMasks::NumCells);
+    return NumPlacements + cellIdx;
+  }
+
+  /// <summary> Use the kernels of the instruction set. It must be supported. </summary>
+  void SetIsa(const NnueIsa isa_)
+  {
+    assert(NnueIsaSupported(isa_));
+    isa = isa_;
+  }
+
+  inline NnueIsa Isa() const
+  {
+    return isa;
+  }
+
+  /// <summary> Compute the accumulator from scratch, from the value of each
+  ///   cell (0 when empty) and the cell of the last move (-1 for none).
+  /// </summary>
+  void Refresh(const unsigned char* values, const int lastMoveIdx, int16_t* acc) const
+  {
+    assert(values && acc);
+    memcpy(acc, &hiddenBias[0], HiddenSize * sizeof(int16_t));
+    for (int cellIdx = 0; cellIdx < CandidateMasks::NumCells; ++cellIdx)
+    {
+      if (0 != values[cellIdx])
+      {
+        Add(PlacementFeature(cellIdx, values[cellIdx]), acc);
+      }
+    }
+    if (lastMoveIdx >= 0)
+    {
+      Add(LastMoveFeature(lastMoveIdx), acc);
+    }
+  }
+
+  /// <summary> Update the accumulator for value placed at cellIdx after a
+  ///   last move at previousIdx (-1 for none).
+  /// </summary>
+  inline void PlayMove(const int previousIdx, const int cellIdx, const int value,
+                       int16_t* acc) const
+  {
+    Add(PlacementFeature(cellIdx, value), acc);
+    Add(LastMoveFeature(cellIdx), acc);
+    if (previousIdx >= 0)
+    {
+      Sub(LastMoveFeature(previousIdx), acc);
+    }
+  }
+
+  /// <summary> Reverse PlayMove() with the same arguments. </summary>
+  inline void Undo(const int previousIdx, const int cellIdx, const int value,
+                   int16_t* acc) const
+  {
+    Sub(PlacementFeature(cellIdx, value), acc);
+    Sub(LastMoveFeature(cellIdx), acc);
+    if (previousIdx >= 0)
+    {
+      Add(LastMoveFeature(previousIdx), acc);
+    }
+  }
+
+  /// <summary> Score of the accumulator for the player to move. </summary>
+  inline int Evaluate(const int16_t* acc) const
+  {
+#ifdef HPS_NNUE_SIMD
+    const int dot = (NnueIsa_Avx2 == isa) ?
+      detail::NnueOutputAvx2(acc, &outputWeights[0], HiddenSize) :
+      detail::NnueOutputScalar(acc, &outputWeights[0], HiddenSize);
+#else
+    const int dot = detail::NnueOutputScalar(acc, &outputWeights[0], HiddenSize);
+#endif
+    return (outputBias + dot) >> OutputShift;
+  }
+
+  /// <summary> Read weights in the file format. </summary>
+  bool Load(std::istream& in)
+  {
+    uint32_t header[2];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        (static_cast<uint32_t>(Magic) != header[0]) ||
+        (static_cast<uint32_t>(HiddenSize) != header[1]))
+    {
+      return false;
+    }
+    NnueNetwork loaded;
+    loaded.isa = isa;
+    if (!in.read(reinterpret_cast<char*>(&loaded.hiddenBias[0]),
+                 loaded.hiddenBias.size() * sizeof(int16_t)) ||
+        !in.read(reinterpret_cast<char*>(&loaded.featureWeights[0]),
+                 loaded.featureWeights.size() * sizeof(int16_t)) ||
+        !in.read(reinterpret_cast<char*>(&loaded.outputWeights[0]),
+                 loaded.outputWeights.size() * sizeof(int8_t)) ||
+        !in.read(reinterpret_cast<char*>(&loaded.outputBias), sizeof(int32_t)))
+    {
+      return false;
+    }
+    *this = loaded;
+    return true;
+  }
+
+  bool Load(const std::string& path)
+  {
+    std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+    return in.good() && Load(in);
+  }
+
+  /// <summary> Write weights in the file format. </summary>
+  bool Save(std::ostream& out) const
+  {
+    const uint32_t header[2] = { static_cast<uint32_t>(Magic),
+                                 static_cast<uint32_t>(HiddenSize), };
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&hiddenBias[0]),
+              hiddenBias.size() * sizeof(int16_t));
+    out.write(reinterpret_cast<const char*>(&featureWeights[0]),
+              featureWeights.size() * sizeof(int16_t));
+    out.write(reinterpret_cast<const char*>(&outputWeights[0]),
+              outputWeights.size() * sizeof(int8_t));
+    out.write(reinterpret_cast<const char*>(&outputBias), sizeof(int32_t));
+    return out.good();
+  }
+
+  /// <summary> Hidden biases, HiddenSize entries. </summary>
+  std::vector<int16_t> hiddenBias;
+  /// <summary> HiddenSize weights per feature, feature by feature. </summary>
+  std::vector<int16_t> featureWeights;
+  /// <summary> Output weights, HiddenSize entries. </summary>
+  std::vector<int8_t> outputWeights;
+  int32_t outputBias;
+
+private:
+  inline void Add(const int feature, int16_t* acc) const
+  {
+    const int16_t* row = &featureWeights[feature * HiddenSize];
+#ifdef HPS_NNUE_SIMD
+    if (NnueIsa_Avx2 == isa)
+    {
+      detail::NnueAddAvx2(row, HiddenSize, acc);
+      return;
+    }
+#endif
+    detail::NnueAddScalar(row, HiddenSize, acc);
+  }
+
+  inline void Sub(const int feature, int16_t* acc) const
+  {
+    const int16_t* row = &featureWeights[feature * HiddenSize];
+#ifdef HPS_NNUE_SIMD
+    if (NnueIsa_Avx2 == isa)
+    {
+      detail::NnueSubAvx2(row, HiddenSize, acc);
+      return;
+    }
+#endif
+    detail::NnueSubScalar(row, HiddenSize, acc);
+  }
+
+  NnueIsa isa;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_NNUE_H_
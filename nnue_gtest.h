@@ -0,0 +1,181 @@
+#ifndef _HPS_SUDOKILL_NNUE_GTEST_H_
+#define _HPS_SUDOKILL_NNUE_GTEST_H_
+
+#include "nnue.h"
+#include "evaluation.h"
+#include "alphabetapruning.h"
+#include "gtest/gtest.h"
+#include <sstream>
+#include <vector>
+
+namespace _hps_sudokill_nnue_gtest_h_
+{
+using namespace hps;
+
+/// <summary> Fill the network with deterministic pseudo-random weights. </summary>
+void Randomize(const unsigned int seed, NnueNetwork* network)
+{
+  unsigned int state = seed;
+  struct Lcg
+  {
+    static int Next(unsigned int* state, const int range)
+    {
+      *state = (*state * 1103515245u) + 12345u;
+      return static_cast<int>((*state >> 8) % (2 * range + 1)) - range;
+    }
+  };
+  for (size_t i = 0; i < network->hiddenBias.size(); ++i)
+  {
+    network->hiddenBias[i] = static_cast<int16_t>(Lcg::Next(&state, 64));
+  }
+  for (size_t i = 0; i < network->featureWeights.size(); ++i)
+  {
+    network->featureWeights[i] = static_cast<int16_t>(Lcg::Next(&state, 16));
+  }
+  for (size_t i = 0; i < network->outputWeights.size(); ++i)
+  {
+    network->outputWeights[i] = static_cast<int8_t>(Lcg::Next(&state, 127));
+  }
+  network->outputBias = Lcg::Next(&state, 1000);
+}
+
+void ExpectAccumulatorsEqual(const Board& lhs, const Board& rhs)
+{
+  for (int i = 0; i < NnueNetwork::HiddenSize; ++i)
+  {
+    ASSERT_EQ(lhs.GetAccumulator()[i], rhs.GetAccumulator()[i]);
+  }
+}
+
+TEST(Nnue, IncrementalMatchesRefresh)
+{
+  NnueNetwork network;
+  Randomize(7, &network);
+  Board board;
+  EXPECT_EQ(NULL, board.GetNetwork());
+  board.AttachNetwork(&network);
+  Board::MoveList moves;
+  for (int step = 0; step < 400; ++step)
+  {
+    board.ValidMoves(&moves);
+    // Take back a move now and then, and always at the end of a game.
+    if (moves.empty() || ((0 == RandBound(4)) && (board.GetPlayerMovesCount() > 0)))
+    {
+      if (0 == board.GetPlayerMovesCount())
+      {
+        break;
+      }
+      board.Undo();
+    }
+    else
+    {
+      board.PlayMove(moves[RandBound(static_cast<int>(moves.size()))]);
+    }
+    Board fresh = board;
+    fresh.AttachNetwork(&network);
+    ExpectAccumulatorsEqual(fresh, board);
+  }
+  while (board.GetPlayerMovesCount() > 0)
+  {
+    board.Undo();
+  }
+  Board empty;
+  empty.AttachNetwork(&network);
+  ExpectAccumulatorsEqual(empty, board);
+  board.AttachNetwork(NULL);
+  EXPECT_EQ(NULL, board.GetNetwork());
+}
+
+TEST(Nnue, KernelsAgree)
+{
+  if (!NnueIsaSupported(NnueIsa_Avx2))
+  {
+    return;
+  }
+  NnueNetwork scalar;
+  Randomize(11, &scalar);
+  scalar.SetIsa(NnueIsa_Scalar);
+  NnueNetwork avx2 = scalar;
+  avx2.SetIsa(NnueIsa_Avx2);
+  std::vector<int16_t> acc(NnueNetwork::HiddenSize);
+  for (int trial = 0; trial < 1000; ++trial)
+  {
+    // Cover the clipping at both ends of [0, 127].
+    for (size_t i = 0; i < acc.size(); ++i)
+    {
+      acc[i] = static_cast<int16_t>(RandBound(512) - 256);
+    }
+    EXPECT_EQ(scalar.Evaluate(&acc[0]), avx2.Evaluate(&acc[0]));
+  }
+  Board board;
+  Board scalarBoard;
+  board.AttachNetwork(&avx2);
+  scalarBoard.AttachNetwork(&scalar);
+  Board::MoveList moves;
+  for (board.ValidMoves(&moves); !moves.empty(); board.ValidMoves(&moves))
+  {
+    const Cell ply = moves[RandBound(static_cast<int>(moves.size()))];
+    board.PlayMove(ply);
+    scalarBoard.PlayMove(ply);
+    ExpectAccumulatorsEqual(scalarBoard, board);
+  }
+}
+
+TEST(Nnue, SaveLoad)
+{
+  NnueNetwork network;
+  Randomize(3, &network);
+  std::stringstream stream;
+  ASSERT_TRUE(network.Save(stream));
+  const std::string saved = stream.str();
+  NnueNetwork loaded;
+  std::istringstream in(saved);
+  ASSERT_TRUE(loaded.Load(in));
+  EXPECT_EQ(network.hiddenBias, loaded.hiddenBias);
+  EXPECT_EQ(network.featureWeights, loaded.featureWeights);
+  EXPECT_EQ(network.outputWeights, loaded.outputWeights);
+  EXPECT_EQ(network.outputBias, loaded.outputBias);
+  // A short or foreign file leaves the network as it was.
+  NnueNetwork untouched;
+  std::istringstream truncated(saved.substr(0, saved.size() - 1));
+  EXPECT_FALSE(untouched.Load(truncated));
+  std::string foreign = saved;
+  foreign[0] = 'X';
+  std::istringstream badMagic(foreign);
+  EXPECT_FALSE(untouched.Load(badMagic));
+  EXPECT_EQ(0, untouched.outputBias);
+  EXPECT_FALSE(untouched.Load(std::string("/nonexistent/sudokill.nnue")));
+}
+
+TEST(Nnue, Evaluation)
+{
+  NnueNetwork network;
+  Randomize(5, &network);
+  Board board;
+  board.AttachNetwork(&network);
+  Board::MoveList moves;
+  for (int i = 0; i < 30; ++i)
+  {
+    board.ValidMoves(&moves);
+    ASSERT_FALSE(moves.empty());
+    board.PlayMove(moves[(i * 7) % moves.size()]);
+  }
+  const int score = network.Evaluate(board.GetAccumulator());
+  EXPECT_EQ(score, NnueEvaluationFunc(board.GetPlayerMovesCount())(board));
+  EXPECT_EQ(-score, NnueEvaluationFunc(board.GetPlayerMovesCount() - 1)(board));
+  // Search copies of the board keep the network.
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 4;
+  const NnueEvaluationFunc f(board.GetPlayerMovesCount());
+  Cell ply;
+  AlphaBetaPruning::Run(&params, &board, &f, &ply);
+  EXPECT_TRUE(params.complete);
+  EXPECT_TRUE(board.IsValidMove(ply));
+  Board fresh = board;
+  fresh.AttachNetwork(&network);
+  ExpectAccumulatorsEqual(fresh, board);
+}
+
+}
+
+#endif //_HPS_SUDOKILL_NNUE_GTEST_H_
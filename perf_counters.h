@@ -0,0 +1,238 @@
+#ifndef _HPS_UTIL_PERF_COUNTERS_H_
+#define _HPS_UTIL_PERF_COUNTERS_H_
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#endif
+#include "timer.h"
+#include <stdint.h>
+#include <assert.h>
+#include <iostream>
+
+namespace hps
+{
+namespace util
+{
+
+/// <summary> Hardware performance counters of the calling thread. </summary>
+/// <remarks>
+///   <para> Uses perf_event_open on Linux. Each counter is opened on its own
+///     so that one the machine lacks (LLC misses in many VMs) does not take
+///     down the rest; a counter that failed to open reads as not valid. On
+///     other systems, or when perf_event_paranoid forbids it, none are
+///     available and only the time is measured.
+///   </para>
+///   <para> Counts cover the calling thread and threads it creates after
+///     construction. OpenMP and the search ThreadPool reuse their threads,
+///     so construct the counters before the first parallel region or search
+///     to include the workers.
+///   </para>
+/// </remarks>
+class PerfCounters
+{
+public:
+  enum Counter
+  {
+    Counter_Cycles,
+    Counter_Instructions,
+    Counter_L1DMisses,
+    Counter_LLCMisses,
+    Counter_BranchMisses,
+    Counter_Count,
+  };
+
+  /// <summary> Counts between a Start() and a Stop(). </summary>
+  struct Sample
+  {
+    Sample() : seconds(0.0)
+    {
+      for (int counter = 0; counter < Counter_Count; ++counter)
+      {
+        valid[counter] = false;
+        values[counter] = 0;
+      }
+    }
+    bool valid[Counter_Count];
+    uint64_t values[Counter_Count];
+    double seconds;
+  };
+
+  PerfCounters() : timer()
+  {
+    for (int counter = 0; counter < Counter_Count; ++counter)
+    {
+      fds[counter] = Open(static_cast<Counter>(counter));
+    }
+  }
+
+  ~PerfCounters()
+  {
+#ifdef __linux__
+    for (int counter = 0; counter < Counter_Count; ++counter)
+    {
+      if (fds[counter] >= 0)
+      {
+        close(fds[counter]);
+      }
+    }
+#endif
+  }
+
+  /// <summary> Test if any hardware counter could be opened. </summary>
+  bool Available() const
+  {
+    for (int counter = 0; counter < Counter_Count; ++counter)
+    {
+      if (fds[counter] >= 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// <summary> Zero and start all counters. </summary>
+  void Start()
+  {
+#ifdef __linux__
+    for (int counter = 0; counter < Counter_Count; ++counter)
+    {
+      if (fds[counter] >= 0)
+      {
+        ioctl(fds[counter], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[counter], PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+    timer.Reset();
+  }
+
+  /// <summary> Stop all counters and read them. </summary>
+  void Stop(Sample* sample)
+  {
+    assert(sample);
+    sample->seconds = timer.GetTime();
+    for (int counter = 0; counter < Counter_Count; ++counter)
+    {
+      sample->valid[counter] = false;
+      sample->values[counter] = 0;
+#ifdef __linux__
+      if (fds[counter] >= 0)
+      {
+        ioctl(fds[counter], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (sizeof(value) == read(fds[counter], &value, sizeof(value)))
+        {
+          sample->valid[counter] = true;
+          sample->values[counter] = value;
+        }
+      }
+#endif
+    }
+  }
+
+  static const char* Name(const Counter counter)
+  {
+    static const char* s_names[] = { "cycles",
+                                     "instructions",
+                                     "L1D misses",
+                                     "LLC misses",
+                                     "branch misses", };
+    assert((counter >= 0) && (counter < Counter_Count));
+    return s_names[counter];
+  }
+
+  /// <summary> Print the counts of a sample per unit of work, e.g. per node. </summary>
+  static void Print(const Sample& sample,
+                    const uint64_t units,
+                    const char* unitName,
+                    std::ostream& out)
+  {
+    const double perUnit = (units > 0) ? (1.0 / static_cast<double>(units)) : 0.0;
+    out << "time: " << sample.seconds << " s ("
+        << (sample.seconds * 1.0e9 * perUnit) << " ns/" << unitName << ")\n";
+    for (int counter = 0; counter < Counter_Count; ++counter)
+    {
+      out << Name(static_cast<Counter>(counter)) << ": ";
+      if (sample.valid[counter])
+      {
+        out << sample.values[counter] << " ("
+            << (static_cast<double>(sample.values[counter]) * perUnit) << "/"
+            << unitName << ")\n";
+      }
+      else
+      {
+        out << "n/a\n";
+      }
+    }
+    if (sample.valid[Counter_Cycles] && sample.valid[Counter_Instructions] &&
+        (sample.values[Counter_Cycles] > 0))
+    {
+      out << "IPC: " << (static_cast<double>(sample.values[Counter_Instructions]) /
+                         static_cast<double>(sample.values[Counter_Cycles])) << "\n";
+    }
+  }
+
+private:
+  PerfCounters(const PerfCounters&);
+  PerfCounters& operator=(const PerfCounters&);
+
+  /// <returns> The counter's descriptor, or -1. </returns>
+  static int Open(const Counter counter)
+  {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    switch (counter)
+    {
+    case Counter_Cycles:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case Counter_Instructions:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case Counter_L1DMisses:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_L1D |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case Counter_LLCMisses:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case Counter_BranchMisses:
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    default:
+      assert(false && "Should not reach here.");
+      return -1;
+    }
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+    (void)counter;
+    return -1;
+#endif
+  }
+
+  int fds[Counter_Count];
+  Timer timer;
+};
+
+}
+using namespace util;
+}
+
+#endif //_HPS_UTIL_PERF_COUNTERS_H_
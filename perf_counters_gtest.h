@@ -0,0 +1,58 @@
+#ifndef _HPS_UTIL_PERF_COUNTERS_GTEST_H_
+#define _HPS_UTIL_PERF_COUNTERS_GTEST_H_
+
+#include "perf_counters.h"
+#include "gtest/gtest.h"
+#include <sstream>
+
+namespace _hps_util_perf_counters_gtest_h_
+{
+using namespace hps;
+
+TEST(PerfCounters, MeasureLoop)
+{
+  enum { Iterations = 1000000, };
+  PerfCounters counters;
+  PerfCounters::Sample sample;
+  counters.Start();
+  volatile unsigned int sum = 0;
+  for (unsigned int i = 0; i < Iterations; ++i)
+  {
+    sum += i;
+  }
+  counters.Stop(&sample);
+  EXPECT_GT(sample.seconds, 0.0);
+  // Counters are often unavailable in containers and VMs.
+  if (sample.valid[PerfCounters::Counter_Instructions])
+  {
+    EXPECT_GT(sample.values[PerfCounters::Counter_Instructions],
+              static_cast<uint64_t>(Iterations));
+  }
+  if (!counters.Available())
+  {
+    for (int counter = 0; counter < PerfCounters::Counter_Count; ++counter)
+    {
+      EXPECT_FALSE(sample.valid[counter]);
+    }
+  }
+  std::stringstream ss;
+  PerfCounters::Print(sample, Iterations, "iteration", ss);
+  EXPECT_NE(std::string::npos, ss.str().find("branch misses: "));
+}
+
+TEST(Timer, Monotonic)
+{
+  Timer timer;
+  double last = timer.GetTime();
+  EXPECT_GE(last, 0.0);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double now = timer.GetTime();
+    EXPECT_GE(now, last);
+    last = now;
+  }
+}
+
+}
+
+#endif //_HPS_UTIL_PERF_COUNTERS_GTEST_H_
@@ -0,0 +1,105 @@
+#ifndef _HPS_SUDOKILL_PERFT_H_
+#define _HPS_SUDOKILL_PERFT_H_
+#include "sudokill_core.h"
+#include <vector>
+#include <stdint.h>
+#include <omp.h>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Count the nodes of the Sudokill move tree. </summary>
+/// <remarks>
+///   <para> Perft(depth) is the number of positions reached by exactly depth
+///     valid moves, so positions with no moves before the depth count 0.
+///     Counts depend only on move generation, which makes them an oracle for
+///     any change to ValidMoves and a measure of its throughput.
+///   </para>
+/// </remarks>
+struct Perft
+{
+  /// <summary> Node count below one root ply. </summary>
+  struct DivideEntry
+  {
+    DivideEntry() : ply(), nodes(0) {}
+    Cell ply;
+    uint64_t nodes;
+  };
+
+  /// <summary> Count positions at the depth. The board is restored. </summary>
+  static uint64_t Count(Board* board, const int depth)
+  {
+    assert(board && (depth >= 0));
+    std::vector<Board::MoveList> buffers(depth + 1);
+    return CountHelper(board, depth, &buffers);
+  }
+
+  /// <summary> Count positions at the depth per root ply, running the root
+  ///   plys on numThreads threads (all when 0).
+  /// </summary>
+  static uint64_t Divide(const Board& board,
+                         const int depth,
+                         const int numThreads,
+                         std::vector<DivideEntry>* entries)
+  {
+    assert(entries && (depth >= 1));
+    Board::MoveList plys;
+    board.ValidMoves(&plys);
+    entries->resize(plys.size());
+    const int threads = (numThreads > 0) ? numThreads : omp_get_num_procs();
+#pragma omp parallel num_threads(threads)
+    {
+      Board state = board;
+      std::vector<Board::MoveList> buffers(depth);
+#pragma omp for schedule(dynamic, 1)
+      for (int plyIdx = 0; plyIdx < static_cast<int>(plys.size()); ++plyIdx)
+      {
+        DivideEntry& entry = (*entries)[plyIdx];
+        entry.ply = plys[plyIdx];
+        state.PlayMove(entry.ply);
+        entry.nodes = CountHelper(&state, depth - 1, &buffers);
+        state.Undo();
+      }
+    }
+    uint64_t total = 0;
+    for (size_t entryIdx = 0; entryIdx < entries->size(); ++entryIdx)
+    {
+      total += (*entries)[entryIdx].nodes;
+    }
+    return total;
+  }
+
+private:
+  static uint64_t CountHelper(Board* board,
+                              const int depth,
+                              std::vector<Board::MoveList>* buffers)
+  {
+    if (0 == depth)
+    {
+      return 1;
+    }
+    Board::MoveList& plys = (*buffers)[depth];
+    board->ValidMoves(&plys);
+    // Children at depth 0 count 1 each, so skip playing them.
+    if (1 == depth)
+    {
+      return plys.size();
+    }
+    uint64_t nodes = 0;
+    for (Board::MoveList::const_iterator ply = plys.begin(); ply != plys.end(); ++ply)
+    {
+      board->PlayMove(*ply);
+      nodes += CountHelper(board, depth - 1, buffers);
+      board->Undo();
+    }
+    return nodes;
+  }
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_PERFT_H_
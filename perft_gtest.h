@@ -0,0 +1,78 @@
+#ifndef _HPS_SUDOKILL_PERFT_GTEST_H_
+#define _HPS_SUDOKILL_PERFT_GTEST_H_
+
+#include "perft.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_perft_gtest_h_
+{
+using namespace hps;
+
+/// <summary> Perft by testing IsValidMove on every (cell, value). </summary>
+uint64_t ReferencePerft(Board* board, const int depth)
+{
+  if (0 == depth)
+  {
+    return 1;
+  }
+  uint64_t nodes = 0;
+  for (int x = 0; x < Board::MaxX; ++x)
+  {
+    for (int y = 0; y < Board::MaxY; ++y)
+    {
+      for (int v = Board::MinValue; v <= Board::MaxValue; ++v)
+      {
+        if (board->IsValidMove(Point(x, y), v))
+        {
+          board->PlayMove(Point(x, y), v);
+          nodes += ReferencePerft(board, depth - 1);
+          board->Undo();
+        }
+      }
+    }
+  }
+  return nodes;
+}
+
+TEST(Perft, EmptyBoard)
+{
+  Board board;
+  EXPECT_EQ(1u, Perft::Count(&board, 0));
+  EXPECT_EQ(729u, Perft::Count(&board, 1));
+  // Each first move leaves 8 cells with 8 values in its row and column.
+  EXPECT_EQ(729u * 128u, Perft::Count(&board, 2));
+  std::vector<Perft::DivideEntry> entries;
+  EXPECT_EQ(729u * 128u, Perft::Divide(board, 2, 0, &entries));
+  EXPECT_EQ(729u, entries.size());
+  EXPECT_EQ(128u, entries[0].nodes);
+}
+
+TEST(Perft, MatchesReference)
+{
+  Board::MoveList moves;
+  for (int trial = 0; trial < 10; ++trial)
+  {
+    Board board;
+    const int numMoves = 30 + RandBound(40);
+    for (int i = 0; i < numMoves; ++i)
+    {
+      board.ValidMoves(&moves);
+      if (moves.empty())
+      {
+        break;
+      }
+      board.PlayMove(moves[RandBound(static_cast<int>(moves.size()))]);
+    }
+    for (int depth = 1; depth <= 3; ++depth)
+    {
+      std::vector<Perft::DivideEntry> entries;
+      const uint64_t expected = ReferencePerft(&board, depth);
+      EXPECT_EQ(expected, Perft::Count(&board, depth));
+      EXPECT_EQ(expected, Perft::Divide(board, depth, 0, &entries));
+    }
+  }
+}
+
+}
+
+#endif //_HPS_SUDOKILL_PERFT_GTEST_H_
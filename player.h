@@ -2,6 +2,10 @@
 #define _SUDOKILL_PLAYER_H
 #include "rand_bound.h"
 #include "alphabetapruning.h"
+#include "evaluation.h"
+#include "eval_weights.h"
+#include "time_manager.h"
+#include "log.h"
 
 namespace hps 
 {
@@ -10,6 +14,9 @@ namespace sudokill
 
 struct RandomPlayer
 {
+  /// <summary> Draw from the generator, or the calling thread's when NULL. </summary>
+  explicit RandomPlayer(Rng* rng_ = NULL) : rng(rng_) {}
+
   void NextMove(const Board& board, Cell* move)
   {
     Board::MoveList moves;
@@ -21,33 +28,53 @@ struct RandomPlayer
     }
     else
     {
-      *move = moves[math::RandBound(moves.size())];
+      *move = moves[math::RandBound((NULL != rng) ? *rng : ThreadRng(),
+                                    static_cast<int>(moves.size()))];
     }
   }
+
+  Rng* rng;
 };
 
 /// <summary> Player using alpha-beta pruning. </summary>
 class AlphaBetaPlayer
 {
-  /// <summary> Try to estimate the number of reachable cells left. </summary>
-  struct ShrinkPossibleMovesEvaluationFunc
+public:
+  /// <summary> What the last NextMove() did. </summary>
+  struct MoveSummary
   {
-    inline int operator()(const Board& board) const
-    {
-      Board::MoveList moves;
-      board.SudokuValidMoves(&moves);
-      return static_cast<int>(moves.size());
-    }
+    MoveSummary() : random(true), complete(false), depth(0), selDepth(0), score(0), nodes(0) {}
+    /// <summary> The move was random; there was no search. </summary>
+    bool random;
+    /// <summary> The iteration that chose the move finished. </summary>
+    bool complete;
+    int depth;
+    int selDepth;
+    int score;
+    /// <summary> Nodes over all iterations. </summary>
+    long long nodes;
   };
-public:
+
   /// <summary> Return the next move for the player. </summary>
+  /// <remarks>
+  ///   <para> Searches with iterative deepening up to the depth cap while the
+  ///     time manager predicts the next iteration fits in the move budget.
+  ///   </para>
+  /// </remarks>
   void NextMove(const Board& board, Cell* move)
   {
     // Pick a random spot if it's early in the game.
     Board::MoveList sudokuMoves;
     board.SudokuValidMoves(&sudokuMoves);
-    std::cout << "There are " << sudokuMoves.size() << " sudoku valid moves remaining." << std::endl;
-    if(sudokuMoves.size() > 55)
+    HPS_LOG(Log_Debug, "There are " << sudokuMoves.size() << " sudoku valid moves remaining.");
+    const int emptyCells = (Board::MaxX * Board::MaxY) -
+                           static_cast<int>(board.GetOccupied().size());
+    Board::MoveList rootPlys;
+    board.ValidMoves(&rootPlys);
+    timeManager.BeginMove(emptyCells, static_cast<int>(rootPlys.size()));
+    summary = MoveSummary();
+    if((static_cast<int>(sudokuMoves.size()) > weights.randomPlayMoves) ||
+       timeManager.Emergency())
     {
       RandomPlayer rand;
       rand.NextMove(board, move);
@@ -55,18 +82,103 @@ public:
     {
 
       #ifdef NDEBUG
-      params.maxDepth = 11;
+      const int maxDepth = 11;
       #else
-      std::cout << "In Debug mode." << std::endl;
-      params.maxDepth = 5;
+      HPS_LOG(Log_Debug, "In Debug mode.");
+      const int maxDepth = 5;
       #endif
-      ShrinkPossibleMovesEvaluationFunc f;
-      AlphaBetaPruning::Run(&params, &const_cast<Board&>(board), &f, move);
+      const WeightedEvaluationFunc f(weights, board.GetPlayerMovesCount());
+      Iteration iteration(this, move);
+      AlphaBetaPruning::Deepen(AlphaBetaPruning::DepthCap(board, maxDepth),
+                               &params, &const_cast<Board&>(board), &f, &iteration);
+      HPS_LOG(Log_Info, "Searched to depth " << params.maxDepth << " (selective "
+                        << params.selDepth << ") in "
+                        << timeManager.Elapsed() << " s (soft "
+                        << timeManager.SoftDeadline() << " s, hard "
+                        << timeManager.HardDeadline() << " s).");
     }
+    timeManager.EndMove();
+  }
+
+  /// <summary> The clock for this player's game. </summary>
+  inline TimeManager* GetTimeManager()
+  {
+    return &timeManager;
+  }
+
+  inline const MoveSummary& GetMoveSummary() const
+  {
+    return summary;
+  }
+
+  /// <summary> Evaluation weights and thresholds, e.g. from sudokill_tune. </summary>
+  inline void SetWeights(const EvalWeights& weights_)
+  {
+    weights = weights_;
+  }
+
+  inline const EvalWeights& GetWeights() const
+  {
+    return weights;
   }
 
 private:
+  /// <summary> Bounds each iteration by the time manager's deadlines and
+  ///   asks it whether to start the next.
+  /// </summary>
+  struct Iteration
+  {
+    Iteration(AlphaBetaPlayer* self_, Cell* move_) : self(self_), move(move_) {}
+
+    bool BeginIteration(const int, AlphaBetaPruning::Params* params)
+    {
+      const TimeManager& timeManager = self->timeManager;
+      params->timeLimitSec = std::max(timeManager.HardDeadline() - timeManager.Elapsed(),
+                                      timeManager.GetParams().minMoveTimeSec);
+      params->stopSignal = timeManager.StopSignal();
+      return true;
+    }
+
+    bool EndIteration(const int depth,
+                      const int minimax,
+                      const Cell& ply,
+                      const AlphaBetaPruning::Params& params)
+    {
+      self->summary.random = false;
+      self->summary.nodes += params.nodes;
+      // Prefer the last full iteration over a partial one.
+      if (!params.complete)
+      {
+        if (2 == depth)
+        {
+          *move = ply;
+          self->Summarize(minimax);
+        }
+        return false;
+      }
+      *move = ply;
+      self->Summarize(minimax);
+      self->timeManager.IterationComplete(minimax);
+      return self->timeManager.StartNextIteration();
+    }
+
+    AlphaBetaPlayer* self;
+    Cell* move;
+  };
+
+  /// <summary> Note the iteration that chose the move. </summary>
+  inline void Summarize(const int minimax)
+  {
+    summary.complete = params.complete;
+    summary.depth = params.maxDepth;
+    summary.selDepth = params.selDepth;
+    summary.score = minimax;
+  }
+
   AlphaBetaPruning::Params params;
+  TimeManager timeManager;
+  EvalWeights weights;
+  MoveSummary summary;
 };
 
 }
@@ -0,0 +1,211 @@
+#ifndef _HPS_SUDOKILL_PROPAGATION_H_
+#define _HPS_SUDOKILL_PROPAGATION_H_
+#include "sudokill_core.h"
+#include "candidate_masks.h"
+#include <assert.h>
+#include <string.h>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Sudoku constraint propagation over a snapshot of a board's
+///   candidate masks.
+/// </summary>
+/// <remarks>
+///   <para> Naked singles (a cell with one candidate) and hidden singles (a
+///     value with one place left in a unit) are filled in virtually until
+///     neither rule applies. Each fill removes the value from the cell's
+///     peers, which can leave other empty cells with no candidate. Those
+///     cells are dead: no player can ever fill them.
+///   </para>
+///   <para> The empty cells that are not dead estimate how many moves remain
+///     in the game, and its parity who is likely to make the last move. It
+///     is only an estimate: later moves may kill more cells, and a player may
+///     fill a hidden single's cell with another value.
+///   </para>
+/// </remarks>
+struct Propagation
+{
+  typedef CandidateMasks::Mask Mask;
+
+  Propagation()
+  : emptyCells(0),
+    deadCells(0),
+    forcedCells(0),
+    playableMoves(0)
+  {
+    memset(unitCandidates, 0, sizeof(unitCandidates));
+    memset(unitPlayable, 0, sizeof(unitPlayable));
+  }
+
+  /// <summary> Propagate from the board's current candidates. </summary>
+  inline void Run(const Board& board)
+  {
+    Run(board.GetCandidates());
+  }
+
+  /// <summary> Propagate from candidates filled by Compute() or Play(). </summary>
+  void Run(const CandidateMasks& masks)
+  {
+    typedef CandidateMasks CM;
+    const detail::CandidateTables& tables = detail::GetCandidateTables();
+    memcpy(cells, masks.cells, sizeof(cells));
+    memset(filled, 0, sizeof(filled));
+    emptyCells = 0;
+    forcedCells = 0;
+    for (int cellIdx = 0; cellIdx < CM::NumCells; ++cellIdx)
+    {
+      filled[cellIdx] = masks.Occupied(cellIdx);
+      emptyCells += filled[cellIdx] ? 0 : 1;
+    }
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (int cellIdx = 0; cellIdx < CM::NumCells; ++cellIdx)
+      {
+        const Mask cell = cells[cellIdx];
+        if (!filled[cellIdx] && (0 != cell) && (0 == (cell & (cell - 1))))
+        {
+          Fill(cellIdx, cell);
+          changed = true;
+        }
+      }
+      for (int unitIdx = 0; unitIdx < CM::NumUnits; ++unitIdx)
+      {
+        changed = FillHiddenSingles(unitIdx) || changed;
+      }
+    }
+    // Count what is left per unit; a cell belongs to one row, column and box.
+    memset(unitCandidates, 0, sizeof(unitCandidates));
+    memset(unitPlayable, 0, sizeof(unitPlayable));
+    deadCells = 0;
+    for (int cellIdx = 0; cellIdx < CM::NumCells; ++cellIdx)
+    {
+      if (masks.Occupied(cellIdx))
+      {
+        continue;
+      }
+      const bool dead = !filled[cellIdx] && (0 == cells[cellIdx]);
+      deadCells += dead ? 1 : 0;
+      // A virtually filled cell keeps its value as its one candidate.
+      const int candidates = detail::PopCount9(cells[cellIdx]);
+      const int units[] = { tables.row[cellIdx], tables.column[cellIdx], tables.box[cellIdx], };
+      for (int i = 0; i < 3; ++i)
+      {
+        unitCandidates[units[i]] += candidates;
+        unitPlayable[units[i]] += dead ? 0 : 1;
+      }
+    }
+    playableMoves = emptyCells - deadCells;
+  }
+
+  /// <summary> 1 when an odd number of moves is estimated to remain. </summary>
+  inline int Parity() const
+  {
+    return playableMoves & 1;
+  }
+
+  /// <summary> Empty cells in the snapshot. </summary>
+  int emptyCells;
+  /// <summary> Empty cells left without a candidate after propagation. </summary>
+  int deadCells;
+  /// <summary> Empty cells filled by a naked or hidden single. </summary>
+  int forcedCells;
+  /// <summary> Estimate of the moves left in the game: emptyCells - deadCells. </summary>
+  int playableMoves;
+  /// <summary> Candidate values of the empty cells of each unit, in the
+  ///   CandidateMasks unit order.
+  /// </summary>
+  int unitCandidates[CandidateMasks::NumUnits];
+  /// <summary> Empty cells of each unit that are not dead. </summary>
+  int unitPlayable[CandidateMasks::NumUnits];
+
+private:
+  /// <summary> Fill the cell with its single candidate bit. </summary>
+  inline void Fill(const int cellIdx, const Mask bit)
+  {
+    const int* peers = detail::GetCandidateTables().peers[cellIdx];
+    for (int peerIdx = 0; peerIdx < detail::CandidateTables::NumPeers; ++peerIdx)
+    {
+      const int peerCellIdx = peers[peerIdx];
+      if (!filled[peerCellIdx])
+      {
+        cells[peerCellIdx] = static_cast<Mask>(cells[peerCellIdx] & ~bit);
+      }
+    }
+    cells[cellIdx] = bit;
+    filled[cellIdx] = true;
+    ++forcedCells;
+  }
+
+  /// <summary> Fill every value that has one open cell left in the unit. </summary>
+  bool FillHiddenSingles(const int unitIdx)
+  {
+    typedef CandidateMasks CM;
+    int unitCells[CM::Dim];
+    UnitCells(unitIdx, unitCells);
+    // Values seen once and values seen twice or more among the open cells.
+    unsigned int once = 0;
+    unsigned int twice = 0;
+    for (int i = 0; i < CM::Dim; ++i)
+    {
+      const int cellIdx = unitCells[i];
+      if (!filled[cellIdx])
+      {
+        twice |= once & cells[cellIdx];
+        once |= cells[cellIdx];
+      }
+    }
+    bool changed = false;
+    for (unsigned int hidden = once & ~twice; hidden; hidden &= hidden - 1)
+    {
+      const Mask bit = static_cast<Mask>(hidden & (0u - hidden));
+      for (int i = 0; i < CM::Dim; ++i)
+      {
+        const int cellIdx = unitCells[i];
+        // An earlier fill in this loop may have taken the cell or the value.
+        if (!filled[cellIdx] && (cells[cellIdx] & bit))
+        {
+          Fill(cellIdx, bit);
+          changed = true;
+          break;
+        }
+      }
+    }
+    return changed;
+  }
+
+  static void UnitCells(const int unitIdx, int* unitCells)
+  {
+    typedef CandidateMasks CM;
+    for (int i = 0; i < CM::Dim; ++i)
+    {
+      if (unitIdx < CM::ColumnUnit)
+      {
+        unitCells[i] = CM::CellIndex(i, unitIdx - CM::RowUnit);
+      }
+      else if (unitIdx < CM::BoxUnit)
+      {
+        unitCells[i] = CM::CellIndex(unitIdx - CM::ColumnUnit, i);
+      }
+      else
+      {
+        const int box = unitIdx - CM::BoxUnit;
+        unitCells[i] = CM::CellIndex(((box % 3) * 3) + (i % 3),
+                                     ((box / 3) * 3) + (i / 3));
+      }
+    }
+  }
+
+  Mask cells[CandidateMasks::NumCells];
+  bool filled[CandidateMasks::NumCells];
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_PROPAGATION_H_
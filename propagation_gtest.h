@@ -0,0 +1,148 @@
+#ifndef _HPS_SUDOKILL_PROPAGATION_GTEST_H_
+#define _HPS_SUDOKILL_PROPAGATION_GTEST_H_
+
+#include "propagation.h"
+#include "evaluation.h"
+#include "alphabetapruning.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_propagation_gtest_h_
+{
+using namespace hps;
+
+TEST(Propagation, EmptyBoard)
+{
+  Board board;
+  Propagation propagation;
+  propagation.Run(board);
+  EXPECT_EQ(81, propagation.emptyCells);
+  EXPECT_EQ(0, propagation.deadCells);
+  EXPECT_EQ(0, propagation.forcedCells);
+  EXPECT_EQ(81, propagation.playableMoves);
+  EXPECT_EQ(1, propagation.Parity());
+  for (int unitIdx = 0; unitIdx < CandidateMasks::NumUnits; ++unitIdx)
+  {
+    EXPECT_EQ(81, propagation.unitCandidates[unitIdx]);
+    EXPECT_EQ(9, propagation.unitPlayable[unitIdx]);
+  }
+}
+
+TEST(Propagation, NakedSingleKillsPeer)
+{
+  typedef CandidateMasks CM;
+  CandidateMasks masks;
+  masks.Clear();
+  // Row 0 holds 1..7, leaving 8 and 9 for its last two cells. Both columns
+  // already have a 9, so both cells need the 8 and one of them is dead.
+  for (int x = 0; x < 7; ++x)
+  {
+    masks.Place(CM::CellIndex(x, 0), x + 1);
+  }
+  masks.Place(CM::CellIndex(8, 5), 9);
+  masks.Place(CM::CellIndex(7, 6), 9);
+  masks.Compute();
+  EXPECT_EQ(0, masks.deadCells);
+  Propagation propagation;
+  propagation.Run(masks);
+  EXPECT_EQ(81 - 9, propagation.emptyCells);
+  EXPECT_EQ(1, propagation.deadCells);
+  EXPECT_GE(propagation.forcedCells, 1);
+  EXPECT_EQ(propagation.emptyCells - 1, propagation.playableMoves);
+  EXPECT_EQ(1, propagation.unitPlayable[CM::RowUnit + 0]);
+  EXPECT_EQ(1, propagation.unitCandidates[CM::RowUnit + 0]);
+}
+
+TEST(Propagation, HiddenSingle)
+{
+  typedef CandidateMasks CM;
+  CandidateMasks masks;
+  masks.Clear();
+  // 1s in rows 1 and 2 and columns 1 and 2 leave (0, 0) as the only place
+  // for a 1 in the top left box, although the cell has all nine candidates.
+  masks.Place(CM::CellIndex(3, 1), 1);
+  masks.Place(CM::CellIndex(6, 2), 1);
+  masks.Place(CM::CellIndex(1, 3), 1);
+  masks.Compute();
+  Propagation propagation;
+  propagation.Run(masks);
+  EXPECT_EQ(0, propagation.forcedCells);
+  masks.Clear();
+  masks.Place(CM::CellIndex(3, 1), 1);
+  masks.Place(CM::CellIndex(6, 2), 1);
+  masks.Place(CM::CellIndex(1, 3), 1);
+  masks.Place(CM::CellIndex(2, 6), 1);
+  masks.Compute();
+  EXPECT_EQ(9, masks.counts[CM::CellIndex(0, 0)]);
+  propagation.Run(masks);
+  EXPECT_GE(propagation.forcedCells, 1);
+  EXPECT_EQ(0, propagation.deadCells);
+  // Forcing the 1 drops the other eight candidates of (0, 0).
+  int boxCandidates = 0;
+  for (int cellIdx = 0; cellIdx < CM::NumCells; ++cellIdx)
+  {
+    boxCandidates += (0 == CM::CellBox(cellIdx)) ? masks.counts[cellIdx] : 0;
+  }
+  EXPECT_EQ(boxCandidates - 8, propagation.unitCandidates[CM::BoxUnit + 0]);
+}
+
+/// <summary> Propagation only removes candidates from the snapshot. </summary>
+TEST(Propagation, RandomGames)
+{
+  for (int game = 0; game < 20; ++game)
+  {
+    Board board;
+    Board::MoveList moves;
+    for (;;)
+    {
+      const CandidateMasks& masks = board.GetCandidates();
+      Propagation propagation;
+      propagation.Run(board);
+      EXPECT_EQ(81 - static_cast<int>(board.GetOccupied().size()), propagation.emptyCells);
+      EXPECT_GE(propagation.deadCells, masks.deadCells);
+      EXPECT_LE(propagation.playableMoves, propagation.emptyCells - masks.deadCells);
+      EXPECT_LE(propagation.forcedCells, propagation.playableMoves);
+      for (int unitIdx = 0; unitIdx < CandidateMasks::NumUnits; ++unitIdx)
+      {
+        EXPECT_LE(propagation.unitPlayable[unitIdx], propagation.unitCandidates[unitIdx]);
+      }
+      board.ValidMoves(&moves);
+      if (moves.empty())
+      {
+        break;
+      }
+      board.PlayMove(moves[RandBound(static_cast<int>(moves.size()))]);
+    }
+  }
+}
+
+TEST(Propagation, ParityEvaluation)
+{
+  Board board;
+  Board::MoveList moves;
+  for (int i = 0; i < 40; ++i)
+  {
+    board.ValidMoves(&moves);
+    ASSERT_FALSE(moves.empty());
+    board.PlayMove(moves[(i * 7) % moves.size()]);
+  }
+  Propagation propagation;
+  propagation.Run(board);
+  const int total = board.GetCandidates().total;
+  // The parity term flips with the side the scores are for.
+  const ParityEvaluationFunc rootToMove(board.GetPlayerMovesCount());
+  const ParityEvaluationFunc rootMoved(board.GetPlayerMovesCount() - 1);
+  const int sign = (1 == propagation.Parity()) ? 1 : -1;
+  EXPECT_EQ(total + (sign * ParityEvaluationFunc::ParityWeight), rootToMove(board));
+  EXPECT_EQ(total - (sign * ParityEvaluationFunc::ParityWeight), rootMoved(board));
+  // The search runs on it through the per-child path.
+  AlphaBetaPruning::Params params;
+  params.maxDepth = 3;
+  Cell ply;
+  AlphaBetaPruning::Run(&params, &board, &rootToMove, &ply);
+  EXPECT_TRUE(params.complete);
+  EXPECT_TRUE(board.IsValidMove(ply));
+}
+
+}
+
+#endif //_HPS_SUDOKILL_PROPAGATION_GTEST_H_
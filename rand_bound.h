@@ -1,28 +1,172 @@
 #ifndef _MATH_RAND_BOUND_GENERATOR_H_
 #define _MATH_RAND_BOUND_GENERATOR_H_
 #include <math.h>
-#include <cstdlib>
+#include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
+#include <atomic>
 
 namespace hps
 {
 namespace math
 {
 
+/// <summary> The xoshiro256** pseudo-random generator. </summary>
+/// <remarks>
+///   <para> Small, fast and statistically strong; unlike rand() it holds no
+///     global state, so each thread can own one. Algorithm by David Blackman
+///     and Sebastiano Vigna (2018), http://prng.di.unimi.it/.
+///   </para>
+/// </remarks>
+class Rng
+{
+public:
+  enum { DefaultSeed = 0x5D0C111, };
+
+  explicit Rng(const uint64_t seed = DefaultSeed)
+  {
+    Seed(seed);
+  }
+
+  /// <summary> Reset the state from a 64-bit seed. </summary>
+  inline void Seed(const uint64_t seed)
+  {
+    // Expand the seed with splitmix64 so that nearby seeds diverge.
+    uint64_t x = seed;
+    for (int i = 0; i < 4; ++i)
+    {
+      uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      s[i] = z ^ (z >> 31);
+    }
+  }
+
+  /// <summary> Next 64 random bits. </summary>
+  inline uint64_t operator()()
+  {
+    const uint64_t result = Rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = Rotl(s[3], 45);
+    return result;
+  }
+
+  /// <summary> Unbiased integer in [0, bound - 1]. </summary>
+  /// <remarks>
+  ///   <para> Lemire's multiply-shift with rejection of the short interval,
+  ///     which needs a division only on the rare rejection path.
+  ///   </para>
+  /// </remarks>
+  inline uint32_t Bound(const uint32_t bound)
+  {
+    assert(bound > 0);
+    uint64_t m = static_cast<uint64_t>(Next32()) * bound;
+    uint32_t low = static_cast<uint32_t>(m);
+    if (low < bound)
+    {
+      const uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+      while (low < threshold)
+      {
+        m = static_cast<uint64_t>(Next32()) * bound;
+        low = static_cast<uint32_t>(m);
+      }
+    }
+    return static_cast<uint32_t>(m >> 32);
+  }
+
+  /// <summary> Uniform double in the open interval (0, 1). </summary>
+  inline double Uniform()
+  {
+    return (static_cast<double>((*this)() >> 11) + 0.5) *
+           (1.0 / 9007199254740992.0);
+  }
+
+  /// <summary> Advance 2^128 steps to start a non-overlapping stream. </summary>
+  void Jump()
+  {
+    static const uint64_t s_jump[] = { 0x180EC6D33CFD0ABAULL,
+                                       0xD5A61266F0C9392CULL,
+                                       0xA9582618E03FC9AAULL,
+                                       0x39ABDC4529B1661CULL, };
+    uint64_t t[4] = { 0, 0, 0, 0, };
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int b = 0; b < 64; ++b)
+      {
+        if (s_jump[i] & (1ULL << b))
+        {
+          for (int j = 0; j < 4; ++j)
+          {
+            t[j] ^= s[j];
+          }
+        }
+        (*this)();
+      }
+    }
+    for (int j = 0; j < 4; ++j)
+    {
+      s[j] = t[j];
+    }
+  }
+
+private:
+  inline uint32_t Next32()
+  {
+    return static_cast<uint32_t>((*this)() >> 32);
+  }
+
+  inline static uint64_t Rotl(const uint64_t x, const int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t s[4];
+};
+
+/// <summary> The calling thread's generator. </summary>
+/// <remarks>
+///   <para> Each thread starts from DefaultSeed mixed with the order in which
+///     threads first draw, so threads draw different streams. That order
+///     varies from run to run; a thread that must repeat calls SeedRng().
+///   </para>
+/// </remarks>
+inline Rng& ThreadRng()
+{
+  static std::atomic<int> s_threadOrdinal(0);
+  static thread_local bool t_seeded = false;
+  static thread_local Rng t_rng;
+  if (!t_seeded)
+  {
+    const int ordinal = s_threadOrdinal.fetch_add(1);
+    t_rng.Seed(Rng::DefaultSeed + static_cast<uint64_t>(ordinal));
+    t_seeded = true;
+  }
+  return t_rng;
+}
+
+/// <summary> Seed the calling thread's generator. </summary>
+inline void SeedRng(const uint64_t seed)
+{
+  ThreadRng().Seed(seed);
+}
+
 /// <summary> Partition consecutive intervals of size bound mapped to the
 ///   numbers [0, bound - 1].
 /// </summary>
-int RandBound(const int bound)
+inline int RandBound(Rng& rng, const int bound)
 {
-  assert(bound <= RAND_MAX);
-  int factor = ((RAND_MAX - bound) / bound) + 1;
-  int limit = factor * bound;
-  int r;
-  do
-  {
-    r = rand();
-  } while (r >= limit);
-  return r / factor;
+  assert(bound > 0);
+  return static_cast<int>(rng.Bound(static_cast<uint32_t>(bound)));
+}
+
+inline int RandBound(const int bound)
+{
+  return RandBound(ThreadRng(), bound);
 }
 
 /// <summary> Partition consecutive intervals of size bound mapped to the
@@ -30,35 +174,33 @@ int RandBound(const int bound)
 /// </summary>
 struct RandBoundGenerator
 {
-  RandBoundGenerator(const int bound_)
+  /// <summary> Draw from the generator, or the calling thread's when NULL. </summary>
+  RandBoundGenerator(const int bound_, Rng* rng_ = NULL)
   : bound(bound_),
-    factor(((RAND_MAX - bound) / bound) + 1),
-    limit(factor * bound)
+    rng(rng_)
   {
-    assert(bound <= RAND_MAX);
+    assert(bound > 0);
   }
 
   inline int operator()() const
   {
-    int r;
-    do
-    {
-      r = rand();
-    } while (r >= limit);
-    return r / factor;
+    return RandBound((NULL != rng) ? *rng : ThreadRng(), bound);
   }
 
   int bound;
-  int factor;
-  int limit;
+  Rng* rng;
 };
 
+template <typename NumericType>
+inline NumericType RandUniform(Rng& rng)
+{
+  return static_cast<NumericType>(rng.Uniform());
+}
+
 template <typename NumericType>
 inline NumericType RandUniform()
 {
-  static RandBoundGenerator s_rand(RAND_MAX);
-  return static_cast<NumericType>(s_rand()) /
-         static_cast<NumericType>(RAND_MAX - 1);
+  return RandUniform<NumericType>(ThreadRng());
 }
 
 /// <summary> Generate values from a normal distribution using ratio of uniforms. </summary>
@@ -71,7 +213,7 @@ inline NumericType RandUniform()
 ///       NY, USA.
 ///   </para>
 /// </remarks>
-double RatioOfUniforms(const double mu, const double sig)
+inline double RatioOfUniforms(Rng& rng, const double mu, const double sig)
 {
   // Uses a squeeze on the cartesion plot of standard distribution region
   // to reject efficiently (u,v) not in the allowed region. Since (u,v) is
@@ -80,9 +222,9 @@ double RatioOfUniforms(const double mu, const double sig)
   double u, v, x, y, q;
   do
   {
-    u = RandUniform<double>();
+    u = RandUniform<double>(rng);
     {
-      v = 1.7156 * (RandUniform<double>() - 0.5);
+      v = 1.7156 * (RandUniform<double>(rng) - 0.5);
     }
     x = u - 0.449871;
     y = fabs(v) + 0.386596;
@@ -92,6 +234,11 @@ double RatioOfUniforms(const double mu, const double sig)
   return mu + (sig * (v / u));
 }
 
+inline double RatioOfUniforms(const double mu, const double sig)
+{
+  return RatioOfUniforms(ThreadRng(), mu, sig);
+}
+
 }
 using namespace math;
 }
@@ -2,6 +2,10 @@
 #define _HPS_AMBULANCE_RAND_BOUND_GTEST_H_
 #include "rand_bound.h"
 #include "gtest/gtest.h"
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
 
 namespace _hps_ambulance_rand_bound_gtest_h_
 {
@@ -29,6 +33,53 @@ TEST(RandBound, RatioOfUniforms)
   }
 }
 
+TEST(RandBound, Deterministic)
+{
+  Rng a(1234);
+  Rng b(1234);
+  Rng c(1235);
+  bool differs = false;
+  for (int i = 0; i < 100; ++i)
+  {
+    const uint64_t drawA = a();
+    EXPECT_EQ(drawA, b());
+    differs |= drawA != c();
+  }
+  EXPECT_TRUE(differs);
+  // A jumped stream does not repeat the original.
+  Rng jumped(1234);
+  jumped.Jump();
+  a.Seed(1234);
+  EXPECT_NE(a(), jumped());
+}
+
+TEST(RandBound, Bounds)
+{
+  Rng rng(42);
+  enum { Bound = 7, };
+  enum { Draws = 70000, };
+  std::vector<int> hist(Bound, 0);
+  for (int i = 0; i < Draws; ++i)
+  {
+    const int r = RandBound(rng, Bound);
+    ASSERT_GE(r, 0);
+    ASSERT_LT(r, static_cast<int>(Bound));
+    ++hist[r];
+  }
+  // Each bin expects 10000 draws; 5 sigma is about 460.
+  for (int i = 0; i < Bound; ++i)
+  {
+    EXPECT_NEAR(Draws / Bound, hist[i], 460);
+  }
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double u = RandUniform<double>(rng);
+    ASSERT_GT(u, 0.0);
+    ASSERT_LT(u, 1.0);
+  }
+  EXPECT_EQ(0, RandBoundGenerator(1, &rng)());
+}
+
 }
 
 #endif //_HPS_AMBULANCE_RAND_BOUND_GTEST_H_
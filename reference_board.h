@@ -0,0 +1,196 @@
+#ifndef _HPS_SUDOKILL_REFERENCE_BOARD_H_
+#define _HPS_SUDOKILL_REFERENCE_BOARD_H_
+#include "sudokill_core.h"
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> The original board that scans the list of occupied cells for
+///   every query.
+/// </summary>
+/// <remarks>
+///   <para> It is slow and obviously correct, so it is the oracle that the
+///     optimized Board is tested against. Keep it simple: do not optimize it.
+///   </para>
+/// </remarks>
+class ReferenceBoard
+{
+public:
+  enum { MaxX = Board::MaxX, };
+  enum { MaxY = Board::MaxY, };
+  enum { Empty = Board::Empty, };
+  enum { MinValue = Board::MinValue, };
+  enum { MaxValue = Board::MaxValue, };
+
+  typedef Board::MoveList MoveList;
+
+  ReferenceBoard() : positions(), playerMoveCount(0) {}
+  /// <summary> Initialize with a list of preset cells. </summary>
+  explicit ReferenceBoard(const MoveList& preset)
+  : positions(preset),
+    playerMoveCount(0)
+  {}
+
+  inline bool Occupied(const Point& p) const
+  {
+    return Empty != ValueAt(p);
+  }
+
+  inline void PlayMove(const Cell& c)
+  {
+    assert(IsValidMove(c));
+    positions.push_back(c);
+    ++playerMoveCount;
+  }
+
+  inline void Undo()
+  {
+    assert(playerMoveCount > 0);
+    positions.pop_back();
+    --playerMoveCount;
+  }
+
+  int ValueAt(const Point& p) const
+  {
+    for (MoveList::const_iterator pos = positions.begin(); pos != positions.end(); ++pos)
+    {
+      if (pos->location == p)
+      {
+        return pos->value;
+      }
+    }
+    return Empty;
+  }
+
+  /// <summary> Check if the move is valid by the Sudokill rules. </summary>
+  bool IsValidMove(const Cell& cell) const
+  {
+    const Point& p = cell.location;
+    if (!IsSudokuValidMove(p, cell.value))
+    {
+      return false;
+    }
+    if (playerMoveCount > 0)
+    {
+      const Point& lastPlay = positions.back().location;
+      return (lastPlay.x == p.x) || (lastPlay.y == p.y) || LastLinesFull();
+    }
+    return true;
+  }
+
+  /// <summary> Test if the row and column of the last move are full, so
+  ///   that any Sudoku-valid move goes.
+  /// </summary>
+  bool LastLinesFull() const
+  {
+    assert(playerMoveCount > 0);
+    const Point& lastPlay = positions.back().location;
+    for (int i = 0; i < MaxX; ++i)
+    {
+      if (!Occupied(Point(i, lastPlay.y)) || !Occupied(Point(lastPlay.x, i)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Check if the move is valid by Sudoku rules. </summary>
+  bool IsSudokuValidMove(const Point& p, const int value) const
+  {
+    if ((p.x < 0) || (p.x >= MaxX) || (p.y < 0) || (p.y >= MaxY) ||
+        (value < MinValue) || (value > MaxValue) || Occupied(p))
+    {
+      return false;
+    }
+    for (MoveList::const_iterator pos = positions.begin(); pos != positions.end(); ++pos)
+    {
+      const Point& q = pos->location;
+      if ((pos->value == value) &&
+          ((q.x == p.x) || (q.y == p.y) ||
+           (((q.x / 3) == (p.x / 3)) && ((q.y / 3) == (p.y / 3)))))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// <summary> Sudokill-valid moves, in no particular order. </summary>
+  void ValidMoves(MoveList* moveBuffer) const
+  {
+    assert(moveBuffer);
+    SudokuValidMoves(moveBuffer);
+    if ((0 == playerMoveCount) || LastLinesFull())
+    {
+      return;
+    }
+    const Point& lastPlay = positions.back().location;
+    MoveList::iterator keep = moveBuffer->begin();
+    for (MoveList::const_iterator move = moveBuffer->begin(); move != moveBuffer->end(); ++move)
+    {
+      if ((move->location.x == lastPlay.x) || (move->location.y == lastPlay.y))
+      {
+        *keep++ = *move;
+      }
+    }
+    moveBuffer->erase(keep, moveBuffer->end());
+  }
+
+  /// <summary> Sudoku-valid moves, in no particular order. </summary>
+  void SudokuValidMoves(MoveList* moveBuffer) const
+  {
+    assert(moveBuffer);
+    moveBuffer->clear();
+    for (int x = 0; x < MaxX; ++x)
+    {
+      for (int y = 0; y < MaxY; ++y)
+      {
+        // One scan finds the values seen by the cell, as IsSudokuValidMove.
+        bool seen[MaxValue + 1] = {};
+        bool occupied = false;
+        for (MoveList::const_iterator pos = positions.begin(); pos != positions.end(); ++pos)
+        {
+          const Point& q = pos->location;
+          occupied = occupied || ((q.x == x) && (q.y == y));
+          seen[pos->value] = seen[pos->value] || (q.x == x) || (q.y == y) ||
+                             (((q.x / 3) == (x / 3)) && ((q.y / 3) == (y / 3)));
+        }
+        for (int v = MinValue; !occupied && (v <= MaxValue); ++v)
+        {
+          if (!seen[v])
+          {
+            moveBuffer->push_back(Cell(Point(x, y), v));
+          }
+        }
+      }
+    }
+  }
+
+  inline int GetPlayerMovesCount() const
+  {
+    return playerMoveCount;
+  }
+
+  inline const MoveList& GetOccupied() const
+  {
+    return positions;
+  }
+
+private:
+  /// <summary> List of occupied board cells. </summary>
+  MoveList positions;
+  /// <summary> Number of moves made by players. </summary>
+  int playerMoveCount;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_REFERENCE_BOARD_H_
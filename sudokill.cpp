@@ -1,6 +1,11 @@
 #include "sudokill_core.h"
 #include "board_parser.h"
 #include "player.h"
+#include "trace.h"
+#include "log.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include "game_record.h"
 #ifdef WIN32
 #include <winsock.h>
 #else
@@ -12,9 +17,16 @@
 #include <netinet/in.h>
 #include <netdb.h> 
 #endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <errno.h>
+#endif
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
 
 using namespace hps;
 
@@ -81,6 +93,13 @@ int Read(const int sockfd, const int timeoutMs, std::string* data)
   return numRead;
 }
 
+/// <summary> Block for the next server message; the time is idle. </summary>
+inline int WaitRead(const int sockfd, std::string* data)
+{
+  TraceSpan waitSpan("wait");
+  return Read(sockfd, -1, data);
+}
+
 /// <summary> Sudokill command line arguments. </summary>
 struct CommandLineArgs
 {
@@ -90,19 +109,28 @@ struct CommandLineArgs
     Argv_Hostname,
     Argv_Port,
     Argv_PlayerName,
+    Argv_NumGames,
     Argv_Count,
   };
-  CommandLineArgs() : application(), hostname(), port(), playerName() {}
+  CommandLineArgs()
+  : application(), hostname(), port(), playerName(), numGames(1), weights(), recorder(NULL)
+  {}
   std::string application;
   std::string hostname;
   short port;
   std::string playerName;
+  int numGames;
+  /// <summary> Player weights, from SUDOKILL_WEIGHTS when set. </summary>
+  EvalWeights weights;
+  /// <summary> Where turns are recorded, from SUDOKILL_RECORD when set. </summary>
+  GameRecorder* recorder;
 };
 
 inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
 {
   assert(args);
-  if (argc != CommandLineArgs::Argv_Count) { return false; }
+  if ((argc != CommandLineArgs::Argv_NumGames) &&
+      (argc != CommandLineArgs::Argv_Count)) { return false; }
   args->application = argv[CommandLineArgs::Argv_Application];
   args->hostname = argv[CommandLineArgs::Argv_Hostname];
   args->playerName = argv[CommandLineArgs::Argv_PlayerName];
@@ -112,38 +140,31 @@ inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
   ssPort >> port;
   if (0 == port) { return false; }
   args->port = port;
+  if (CommandLineArgs::Argv_Count == argc)
+  {
+    args->numGames = atoi(argv[CommandLineArgs::Argv_NumGames]);
+    if (args->numGames < 1) { return false; }
+  }
   return true;
 }
 
-int main(int argc, char *argv[])
+/// <summary> Open a connection to the server and say hello. </summary>
+/// <returns> The socket, or -1 after printing the error. </returns>
+int Connect(const CommandLineArgs& args)
 {
-#ifdef WIN32
-  WORD wsaRqdVersion = MAKEWORD(2, 0);
-  WSADATA wsaData;
-  WSAStartup(wsaRqdVersion, &wsaData);
-#endif
-
-  // Check args.
-  CommandLineArgs args;
-  if (!ExtractArgs(argc, argv, &args))
-  {
-    std::cerr << "Usage: " << argv[0] << " HOSTNAME PORT PLAYER NAME" << std::endl;
-    return 1;
-  }
-
   // Open port and start connection (server should be listening).
   const short portno = static_cast<short>(args.port);
   const int sockfd = socket(AF_INET, SOCK_STREAM, 0);
   if (sockfd < 0) 
   {
     std::cerr << "ERROR: failed opening socket." << std::endl;
-    return 1;
+    return -1;
   }
   const struct hostent* server = gethostbyname(args.hostname.c_str());
   if (NULL == server)
   {
     std::cerr << "ERROR: no such host." << std::endl;
-    return 1;
+    return -1;
   }
   struct sockaddr_in serv_addr;
   memset(&serv_addr, 0, sizeof(serv_addr));
@@ -153,56 +174,339 @@ int main(int argc, char *argv[])
   if (connect(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) 
   {
     std::cerr << "ERROR: failed connecting to server." << std::endl;
-    return 1;
+    return -1;
   }
 
   // Write hello string as per API documentation.
   {
     const std::string helloStr = std::string("SUDOKILL_PLAYER\n") +
                                  args.playerName + std::string("\n");
-    std::cout << "Write():\n" << helloStr << std::endl;
+    HPS_LOG(Log_Debug, "Write():\n" << helloStr);
     Write(sockfd, helloStr);
   }
+  return sockfd;
+}
 
-  // Read the first state.
+inline void Disconnect(const int sockfd)
+{
+#ifdef WIN32
+  closesocket(sockfd);
+#else
+  close(sockfd);
+#endif
+}
+
+/// <summary> One match: the connection, the state and the player. </summary>
+struct Game
+{
+  Game()
+  : sockfd(-1), board(), player(), stateString(), pending(false), waitTimer(), roundsPlayed(0),
+    index(0), recorder(NULL)
+  {}
+  int sockfd;
+  Board board;
+  AlphaBetaPlayer player;
+  /// <summary> The last state read from the server. </summary>
   std::string stateString;
-  if (Read(sockfd, -1, &stateString) > 0)
-  {
-    std::cout << "stateString:\n" << stateString << std::endl;
-    // Initialize the player and state.
-    Board board;
-    int roundsPlayed = 0;
-    Parser::Parse(stateString, &board);
-    AlphaBetaPlayer player;
+  /// <summary> Set when stateString awaits a move. </summary>
+  bool pending;
+  /// <summary> Time since stateString arrived. </summary>
+  Timer waitTimer;
+  int roundsPlayed;
+  /// <summary> Connection number, for the game record. </summary>
+  int index;
+  GameRecorder* recorder;
+};
+
+/// <summary> Append the turn just played to the game record. </summary>
+void RecordTurn(const Game& game, const Cell& move, const double latencySec)
+{
+  const AlphaBetaPlayer::MoveSummary& summary = game.player.GetMoveSummary();
+  GameRecord record;
+  record.SetPosition(game.board);
+  record.SetMove(move);
+  record.depth = static_cast<uint8_t>(summary.depth);
+  record.selDepth = static_cast<uint8_t>(summary.selDepth);
+  record.game = static_cast<uint16_t>(game.index);
+  record.round = static_cast<uint16_t>(game.roundsPlayed);
+  record.score = summary.score;
+  record.latencyUs = static_cast<uint32_t>(latencySec * 1e6);
+  record.nodes = static_cast<uint64_t>(summary.nodes);
+  record.flags = (summary.complete ? GameRecord::Flag_Complete : 0) |
+                 (summary.random ? GameRecord::Flag_Random : 0);
+  if (!game.recorder->Append(record))
+  {
+    HPS_LOG(Log_Warning, "Failed recording round " << game.roundsPlayed << ".");
+  }
+}
+
+/// <summary> Answer the game's last state with a move. </summary>
+void PlayTurn(Game* game)
+{
+  assert(game);
+  Timer turnTimer;
+  {
+    TraceSpan parseSpan("parse", game->roundsPlayed);
+    Parser::Parse(game->stateString, &game->board);
+  }
+  Cell move;
+  {
+    TraceSpan searchSpan("search", game->roundsPlayed);
+    game->player.NextMove(game->board, &move);
+  }
+  std::stringstream ssMove;
+  ssMove << move.location.x << " " << move.location.y << " " << move.value
+	 << "\n";
+    //<< "\nMOVE END\n";
+  {
+    TraceSpan writeSpan("write", game->roundsPlayed);
+    Write(game->sockfd, ssMove.str());
+  }
+  // Log and record only after the move is sent.
+  HPS_LOG(Log_Debug, game->board << "ssMove.sr(): " << ssMove.str());
+  if (NULL != game->recorder)
+  {
+    RecordTurn(*game, move, turnTimer.GetTime());
+  }
+  ++game->roundsPlayed;
+}
+
+/// <summary> Play one game until the server disconnects. </summary>
+int PlayGame(const CommandLineArgs& args)
+{
+  Game game;
+  game.player.SetWeights(args.weights);
+  game.recorder = args.recorder;
+  game.sockfd = Connect(args);
+  if (game.sockfd < 0)
+  {
+    return 1;
+  }
+
+  // Read the first state.
+  if (WaitRead(game.sockfd, &game.stateString) > 0)
+  {
+    HPS_LOG(Log_Debug, "stateString:\n" << game.stateString);
     // Play until the server disconnects.
     do
     {
-      Parser::Parse(stateString, &board);
-      Cell move;
-      player.NextMove(board, &move);
-      std::stringstream ssMove;
-      board.PrintBoard();
-      ssMove << move.location.x << " " << move.location.y << " " << move.value
-	     << "\n";
-	//<< "\nMOVE END\n";
-      std::cout << "ssMove.sr(): " << ssMove.str() <<std::endl; 
-      Write(sockfd, ssMove.str());
-      ++roundsPlayed;
-      
-    } while (Read(sockfd, -1, &stateString) > 0);
-    std::cout << "Played " << roundsPlayed << " rounds." << std::endl;
+      PlayTurn(&game);
+    } while (WaitRead(game.sockfd, &game.stateString) > 0);
+    HPS_LOG(Log_Info, "Played " << game.roundsPlayed << " rounds.");
   }
 
   // Wait for primmadonna server to end.
-  Read(sockfd, -1, &stateString);
+  Read(game.sockfd, -1, &game.stateString);
+  Disconnect(game.sockfd);
+  return 0;
+}
+
+#ifdef __linux__
+/// <summary> Play numGames games at once from one epoll loop. </summary>
+/// <remarks>
+///   <para> One search runs at a time on the whole search pool, so games do
+///     not oversubscribe the cores. Among the games waiting for a move the
+///     one with the least clock to spare goes first, and the time a game
+///     waited is charged to its clock.
+///   </para>
+/// </remarks>
+int PlayGames(const CommandLineArgs& args)
+{
+  const int epollfd = epoll_create1(0);
+  if (epollfd < 0)
+  {
+    std::cerr << "ERROR: failed creating epoll instance." << std::endl;
+    return 1;
+  }
+  std::vector<Game*> games;
+  int result = 0;
+  for (int gameIdx = 0; gameIdx < args.numGames; ++gameIdx)
+  {
+    const int sockfd = Connect(args);
+    if (sockfd < 0)
+    {
+      result = 1;
+      break;
+    }
+    Game* game = new Game;
+    game->sockfd = sockfd;
+    game->player.SetWeights(args.weights);
+    game->index = gameIdx;
+    game->recorder = args.recorder;
+    games.push_back(game);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = game;
+    epoll_ctl(epollfd, EPOLL_CTL_ADD, sockfd, &event);
+  }
+
+  int live = (0 == result) ? static_cast<int>(games.size()) : 0;
+  std::vector<epoll_event> events(games.size() + 1);
+  while (live > 0)
+  {
+    // Only block when no game awaits a move.
+    bool anyPending = false;
+    for (size_t gameIdx = 0; gameIdx < games.size(); ++gameIdx)
+    {
+      anyPending = anyPending || games[gameIdx]->pending;
+    }
+    int numReady;
+    {
+      TraceSpan waitSpan("wait", anyPending ? 0 : 1);
+      numReady = epoll_wait(epollfd, &events[0], static_cast<int>(events.size()),
+                            anyPending ? 0 : -1);
+    }
+    if ((numReady < 0) && (EINTR != errno))
+    {
+      std::cerr << "ERROR: epoll_wait failed." << std::endl;
+      result = 1;
+      break;
+    }
+    for (int eventIdx = 0; eventIdx < numReady; ++eventIdx)
+    {
+      Game* game = static_cast<Game*>(events[eventIdx].data.ptr);
+      std::string data;
+      if (Read(game->sockfd, 0, &data) > 0)
+      {
+        game->stateString = data;
+        if (!game->pending)
+        {
+          game->pending = true;
+          game->waitTimer.Reset();
+        }
+      }
+      else
+      {
+        // The server ended this game.
+        epoll_ctl(epollfd, EPOLL_CTL_DEL, game->sockfd, NULL);
+        Disconnect(game->sockfd);
+        game->sockfd = -1;
+        game->pending = false;
+        --live;
+        HPS_LOG(Log_Info, "Game " << (std::find(games.begin(), games.end(), game) - games.begin())
+                          << " played " << game->roundsPlayed << " rounds.");
+      }
+    }
+
+    // Search the waiting game with the least clock to spare.
+    Game* next = NULL;
+    double nextSlack = 0.0;
+    int numPending = 0;
+    for (size_t gameIdx = 0; gameIdx < games.size(); ++gameIdx)
+    {
+      Game* game = games[gameIdx];
+      if (!game->pending)
+      {
+        continue;
+      }
+      ++numPending;
+      const double slack = game->player.GetTimeManager()->Remaining() -
+                           game->waitTimer.GetTime();
+      if ((NULL == next) || (slack < nextSlack))
+      {
+        next = game;
+        nextSlack = slack;
+      }
+    }
+    if (NULL != next)
+    {
+      next->player.GetTimeManager()->ChargeWait(next->waitTimer.GetTime());
+      // The other waiting games are searched after this one.
+      next->player.GetTimeManager()->ShareEngine(numPending);
+      next->pending = false;
+      PlayTurn(next);
+    }
+  }
+
+  for (size_t gameIdx = 0; gameIdx < games.size(); ++gameIdx)
+  {
+    if (games[gameIdx]->sockfd >= 0)
+    {
+      Disconnect(games[gameIdx]->sockfd);
+    }
+    delete games[gameIdx];
+  }
+  close(epollfd);
+  return result;
+}
+#else
+int PlayGames(const CommandLineArgs&)
+{
+  std::cerr << "ERROR: NUM_GAMES above 1 needs epoll (Linux)." << std::endl;
+  return 1;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+#ifdef WIN32
+  WORD wsaRqdVersion = MAKEWORD(2, 0);
+  WSADATA wsaData;
+  WSAStartup(wsaRqdVersion, &wsaData);
+#endif
+
+  // Check args.
+  CommandLineArgs args;
+  if (!ExtractArgs(argc, argv, &args))
+  {
+    std::cerr << "Usage: " << argv[0] << " HOSTNAME PORT PLAYER NAME [NUM_GAMES]" << std::endl
+              << "  NUM_GAMES connections are played at once, sharing the"
+              << " search threads." << std::endl
+              << "  Set SUDOKILL_TRACE=FILE to write a Chrome trace of the"
+              << " game to FILE." << std::endl
+              << "  Set SUDOKILL_THREADS=N for N search threads, SUDOKILL_PIN=1"
+              << " to pin them to CPUs and SUDOKILL_NO_SMT=1 to use one"
+              << " thread per core." << std::endl
+              << "  Set SUDOKILL_WEIGHTS=FILE to play with weights written by"
+              << " sudokill_tune." << std::endl
+              << "  Set SUDOKILL_RECORD=FILE to append every turn to the game"
+              << " record FILE (see sudokill_replay)." << std::endl;
+    return 1;
+  }
+  const char* weightsPath = getenv("SUDOKILL_WEIGHTS");
+  if ((NULL != weightsPath) && !args.weights.Load(std::string(weightsPath)))
+  {
+    std::cerr << "ERROR: cannot load weights " << weightsPath << "." << std::endl;
+    return 1;
+  }
+  ThreadPool::Options poolOptions;
+  if (NULL != getenv("SUDOKILL_THREADS"))
+  {
+    poolOptions.numThreads = atoi(getenv("SUDOKILL_THREADS"));
+  }
+  poolOptions.pin = (NULL != getenv("SUDOKILL_PIN")) &&
+                    (0 != atoi(getenv("SUDOKILL_PIN")));
+  poolOptions.avoidSmt = (NULL != getenv("SUDOKILL_NO_SMT")) &&
+                         (0 != atoi(getenv("SUDOKILL_NO_SMT")));
+  ThreadPool::ConfigureSearch(poolOptions);
+  GameRecorder recorder;
+  const char* recordPath = getenv("SUDOKILL_RECORD");
+  if (NULL != recordPath)
+  {
+    if (!recorder.Open(std::string(recordPath)))
+    {
+      std::cerr << "ERROR: cannot open game record " << recordPath << "." << std::endl;
+      return 1;
+    }
+    args.recorder = &recorder;
+  }
+  const char* tracePath = getenv("SUDOKILL_TRACE");
+  if (NULL != tracePath)
+  {
+    Trace::Enable();
+  }
+
+  const int result = (1 == args.numGames) ? PlayGame(args) : PlayGames(args);
 
-  // Disconnect.
 #ifdef WIN32
-  closesocket(sockfd);
   WSACleanup();
-#else
-  close(sockfd);
 #endif
 
-  return 0;
+  if ((NULL != tracePath) && !Trace::Write(std::string(tracePath)))
+  {
+    std::cerr << "ERROR: failed writing trace to " << tracePath << "." << std::endl;
+  }
+
+  return result;
 }
@@ -0,0 +1,185 @@
+#include "sudokill_core.h"
+#include "analysis.h"
+#include "board_parser.h"
+#include "eval_weights.h"
+#include "log.h"
+#include "timer.h"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace hps;
+
+/// <summary> sudokill_analyze command line arguments. </summary>
+struct CommandLineArgs
+{
+  CommandLineArgs() : options(), weightsFile(), inputFiles() {}
+  Analyzer::Options options;
+  std::string weightsFile;
+  /// <summary> Read in order; stdin when empty. </summary>
+  std::vector<std::string> inputFiles;
+};
+
+inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
+{
+  assert(args);
+  for (int argIdx = 1; argIdx < argc; ++argIdx)
+  {
+    const std::string arg(argv[argIdx]);
+    if (("--depth" == arg) && (argIdx + 1 < argc))
+    {
+      args->options.maxDepth = atoi(argv[++argIdx]);
+      if (args->options.maxDepth < 2) { return false; }
+    }
+    else if (("--time" == arg) && (argIdx + 1 < argc))
+    {
+      args->options.timeLimitSec = atof(argv[++argIdx]);
+      if (args->options.timeLimitSec < 0.0) { return false; }
+    }
+    else if (("--multipv" == arg) && (argIdx + 1 < argc))
+    {
+      args->options.multiPv = atoi(argv[++argIdx]);
+      if (args->options.multiPv < 1) { return false; }
+    }
+    else if (("--jobs" == arg) && (argIdx + 1 < argc))
+    {
+      args->options.numJobs = atoi(argv[++argIdx]);
+    }
+    else if (("--threads" == arg) && (argIdx + 1 < argc))
+    {
+      args->options.numThreads = atoi(argv[++argIdx]);
+      if (args->options.numThreads < 1) { return false; }
+    }
+    else if (("--weights" == arg) && (argIdx + 1 < argc))
+    {
+      args->weightsFile = argv[++argIdx];
+    }
+    else if ((0 == arg.compare(0, 2, "--")) && ("--" != arg))
+    {
+      return false;
+    }
+    else
+    {
+      args->inputFiles.push_back(arg);
+    }
+  }
+  return true;
+}
+
+/// <summary> One summary line per position, then one line per root ply. </summary>
+inline void PrintAnalysis(std::ostream& out, const size_t positionIdx, const Analysis& analysis)
+{
+  out << "position " << positionIdx << " depth " << analysis.depth
+      << " seldepth " << analysis.selDepth << " nodes " << analysis.nodes
+      << " time " << analysis.seconds
+      << (analysis.complete ? "" : " partial") << "\n";
+  for (size_t lineIdx = 0; lineIdx < analysis.lines.size(); ++lineIdx)
+  {
+    const AnalysisLine& line = analysis.lines[lineIdx];
+    out << "position " << positionIdx << " multipv " << (lineIdx + 1) << " score ";
+    Parser::PrintScore(out, line.score);
+    out << " pv";
+    for (Board::MoveList::const_iterator ply = line.pv.begin(); ply != line.pv.end(); ++ply)
+    {
+      out << " " << ply->location.x << " " << ply->location.y << " " << ply->value;
+    }
+    out << "\n";
+  }
+}
+
+int main(int argc, char** argv)
+{
+  // Stdout is one parseable line per result; the search logs elsewhere.
+  Logger::Get().SetSink(&std::cerr);
+  CommandLineArgs args;
+  if (!ExtractArgs(argc, argv, &args))
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " [FILE...] [--depth D] [--time S] [--multipv K] [--jobs N]"
+              << " [--threads N] [--weights FILE]" << std::endl
+              << "  Reads game states between " << Parser::StateStringBegin()
+              << " and " << Parser::StateStringEnd()
+              << " from the files, or stdin, and prints the best root plys of each"
+              << " with their scores and principal variations." << std::endl
+              << "  --depth D caps the search depth (default 11)." << std::endl
+              << "  --time S spends at most about S seconds on a position, variations"
+              << " included (default none)." << std::endl
+              << "  --multipv K prints the best K root plys (default 3)." << std::endl
+              << "  --jobs N analyzes N positions at once (default one per CPU);"
+              << " positions typed at a terminal are analyzed one by one." << std::endl
+              << "  --threads N searches each position on N threads (default 1)."
+              << std::endl
+              << "  --weights FILE evaluates with the weights in FILE." << std::endl;
+    return 1;
+  }
+  if (!args.weightsFile.empty() && !args.options.weights.Load(args.weightsFile))
+  {
+    std::cerr << "ERROR: cannot load weights " << args.weightsFile << "." << std::endl;
+    return 1;
+  }
+  if (args.inputFiles.empty())
+  {
+    args.inputFiles.push_back("-");
+  }
+
+  Analyzer analyzer(args.options);
+  std::vector<Board> boards;
+  std::vector<Analysis> analyses;
+  size_t positions = 0;
+  long long nodes = 0;
+  Timer timer;
+  for (size_t fileIdx = 0; fileIdx < args.inputFiles.size(); ++fileIdx)
+  {
+    const std::string& path = args.inputFiles[fileIdx];
+    std::ifstream file;
+    if ("-" != path)
+    {
+      file.open(path.c_str());
+      if (!file.good())
+      {
+        std::cerr << "ERROR: cannot read " << path << "." << std::endl;
+        return 1;
+      }
+    }
+    std::istream& in = ("-" != path) ? file : std::cin;
+    // Analyze in batches so that results stream out of a long input; a
+    // terminal on stdin is interactive, so answer each of its positions at once.
+    const bool interactive = ("-" == path) && isatty(STDIN_FILENO);
+    const size_t batchSize = interactive ? 1 : 16 * static_cast<size_t>(analyzer.Jobs());
+    bool more = true;
+    while (more)
+    {
+      boards.clear();
+      std::string stateString;
+      while ((boards.size() < batchSize) &&
+             (more = Parser::ReadStateString(in, &stateString)))
+      {
+        boards.push_back(Board());
+        if (!Parser::Parse(stateString, &boards.back()))
+        {
+          std::cerr << "ERROR: bad state in " << path << " at position "
+                    << (positions + boards.size() - 1) << "." << std::endl;
+          return 1;
+        }
+        stateString.clear();
+      }
+      analyzer.AnalyzeAll(boards, &analyses);
+      for (size_t boardIdx = 0; boardIdx < analyses.size(); ++boardIdx)
+      {
+        PrintAnalysis(std::cout, positions + boardIdx, analyses[boardIdx]);
+        nodes += analyses[boardIdx].nodes;
+      }
+      std::cout.flush();
+      positions += boards.size();
+    }
+  }
+  const double seconds = timer.GetTime();
+  std::cerr << "Analyzed " << positions << " positions in " << seconds << " s ("
+            << ((seconds > 0.0) ? (positions / seconds) : 0.0) << " positions/sec, "
+            << ((seconds > 0.0) ? (nodes / seconds) : 0.0) << " nodes/sec) on "
+            << analyzer.Jobs() << " jobs." << std::endl;
+  return 0;
+}
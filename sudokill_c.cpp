@@ -0,0 +1,378 @@
+#include "sudokill_c.h"
+#include "sudokill_core.h"
+#include "board_parser.h"
+#include "engine.h"
+#include "log.h"
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <iostream>
+#include <new>
+
+using namespace hps;
+
+struct sudokill_board
+{
+  Board board;
+};
+
+struct sudokill_engine
+{
+  explicit sudokill_engine(const Engine::Options& options) : engine(options) {}
+  Engine engine;
+};
+
+namespace
+{
+
+/// <summary> Set once the host picks a log level; until then the first
+///   engine silences the library.
+/// </summary>
+std::atomic<bool> s_logLevelSet(false);
+
+inline Cell ToCell(const sudokill_move& move)
+{
+  return Cell(Point(move.x, move.y), move.value);
+}
+
+inline sudokill_move ToMove(const Cell& cell)
+{
+  sudokill_move move;
+  move.x = cell.location.x;
+  move.y = cell.location.y;
+  move.value = cell.value;
+  return move;
+}
+
+/// <summary> Test that no two presets share a cell or break a Sudoku unit. </summary>
+bool PresetsAgree(const Board& board)
+{
+  const Board::MoveList& occupied = board.GetOccupied();
+  const size_t numPresets = occupied.size() - static_cast<size_t>(board.GetPlayerMovesCount());
+  for (size_t lhsIdx = 0; lhsIdx < numPresets; ++lhsIdx)
+  {
+    const Cell& lhs = occupied[lhsIdx];
+    for (size_t rhsIdx = lhsIdx + 1; rhsIdx < numPresets; ++rhsIdx)
+    {
+      const Cell& rhs = occupied[rhsIdx];
+      const bool sameRow = lhs.location.y == rhs.location.y;
+      const bool sameColumn = lhs.location.x == rhs.location.x;
+      const bool sameBox = ((lhs.location.x / 3) == (rhs.location.x / 3)) &&
+                           ((lhs.location.y / 3) == (rhs.location.y / 3));
+      if ((sameRow && sameColumn) ||
+          ((lhs.value == rhs.value) && (sameRow || sameColumn || sameBox)))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}
+
+extern "C" {
+
+const char* sudokill_status_string(const sudokill_status status)
+{
+  switch (status)
+  {
+  case SUDOKILL_OK: return "ok";
+  case SUDOKILL_INVALID_ARGUMENT: return "invalid argument";
+  case SUDOKILL_INVALID_MOVE: return "invalid move";
+  case SUDOKILL_PARSE_ERROR: return "parse error";
+  case SUDOKILL_NO_MOVES: return "no valid moves";
+  case SUDOKILL_OUT_OF_MEMORY: return "out of memory";
+  }
+  return "unknown status";
+}
+
+sudokill_status sudokill_set_log_level(const sudokill_log_level level)
+{
+  if ((level < SUDOKILL_LOG_DEBUG) || (level > SUDOKILL_LOG_NONE))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  s_logLevelSet.store(true);
+  if (SUDOKILL_LOG_NONE != level)
+  {
+    Logger::Get().SetSink(&std::cerr);
+  }
+  Logger::SetLevel(static_cast<LogLevel>(level));
+  return SUDOKILL_OK;
+}
+
+sudokill_status sudokill_board_create(const sudokill_move* presets,
+                                      const int num_presets,
+                                      const sudokill_move* moves,
+                                      const int num_moves,
+                                      sudokill_board** board)
+{
+  if ((NULL == board) ||
+      (num_presets < 0) || ((num_presets > 0) && (NULL == presets)) ||
+      (num_moves < 0) || ((num_moves > 0) && (NULL == moves)))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  *board = NULL;
+  Board::MoveList presetCells;
+  for (int presetIdx = 0; presetIdx < num_presets; ++presetIdx)
+  {
+    const Cell cell = ToCell(presets[presetIdx]);
+    if (!Parser::IsOnBoard(cell))
+    {
+      return SUDOKILL_INVALID_MOVE;
+    }
+    presetCells.push_back(cell);
+  }
+  sudokill_board* created = new (std::nothrow) sudokill_board;
+  if (NULL == created)
+  {
+    return SUDOKILL_OUT_OF_MEMORY;
+  }
+  created->board = Board(presetCells);
+  if (!PresetsAgree(created->board))
+  {
+    delete created;
+    return SUDOKILL_INVALID_MOVE;
+  }
+  for (int moveIdx = 0; moveIdx < num_moves; ++moveIdx)
+  {
+    const Cell cell = ToCell(moves[moveIdx]);
+    if (!created->board.IsValidMove(cell))
+    {
+      delete created;
+      return SUDOKILL_INVALID_MOVE;
+    }
+    created->board.PlayMove(cell);
+  }
+  *board = created;
+  return SUDOKILL_OK;
+}
+
+sudokill_status sudokill_board_parse(const char* state_string, sudokill_board** board)
+{
+  if ((NULL == state_string) || (NULL == board))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  *board = NULL;
+  // Parse() expects the state to start at StateStringBegin().
+  std::stringstream ssState(state_string);
+  std::string line;
+  if (!Parser::ReadNextLineNonEmpty(ssState, &line) || (Parser::StateStringBegin() != line))
+  {
+    return SUDOKILL_PARSE_ERROR;
+  }
+  sudokill_board* parsed = new (std::nothrow) sudokill_board;
+  if (NULL == parsed)
+  {
+    return SUDOKILL_OUT_OF_MEMORY;
+  }
+  if (!Parser::Parse(state_string, &parsed->board) || !PresetsAgree(parsed->board))
+  {
+    delete parsed;
+    return SUDOKILL_PARSE_ERROR;
+  }
+  *board = parsed;
+  return SUDOKILL_OK;
+}
+
+sudokill_status sudokill_board_clone(const sudokill_board* board, sudokill_board** clone)
+{
+  if ((NULL == board) || (NULL == clone))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  *clone = new (std::nothrow) sudokill_board(*board);
+  return (NULL != *clone) ? SUDOKILL_OK : SUDOKILL_OUT_OF_MEMORY;
+}
+
+void sudokill_board_destroy(sudokill_board* board)
+{
+  delete board;
+}
+
+sudokill_status sudokill_board_play(sudokill_board* board, const sudokill_move move)
+{
+  if (NULL == board)
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  const Cell cell = ToCell(move);
+  if (!board->board.IsValidMove(cell))
+  {
+    return SUDOKILL_INVALID_MOVE;
+  }
+  board->board.PlayMove(cell);
+  return SUDOKILL_OK;
+}
+
+sudokill_status sudokill_board_undo(sudokill_board* board)
+{
+  if ((NULL == board) || (0 == board->board.GetPlayerMovesCount()))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  board->board.Undo();
+  return SUDOKILL_OK;
+}
+
+int sudokill_board_valid_moves(const sudokill_board* board,
+                               sudokill_move* moves,
+                               const int capacity)
+{
+  if ((NULL == board) || ((capacity > 0) && (NULL == moves)))
+  {
+    return -1;
+  }
+  Board::MoveList plys;
+  board->board.ValidMoves(&plys);
+  const int numPlys = static_cast<int>(plys.size());
+  for (int plyIdx = 0; (plyIdx < numPlys) && (plyIdx < capacity); ++plyIdx)
+  {
+    moves[plyIdx] = ToMove(plys[plyIdx]);
+  }
+  return numPlys;
+}
+
+int sudokill_board_value_at(const sudokill_board* board, const int x, const int y)
+{
+  if ((NULL == board) || (x < 0) || (x >= Board::MaxX) || (y < 0) || (y >= Board::MaxY))
+  {
+    return -1;
+  }
+  return board->board.ValueAt(Point(x, y));
+}
+
+int sudokill_board_moves_played(const sudokill_board* board)
+{
+  return (NULL != board) ? board->board.GetPlayerMovesCount() : -1;
+}
+
+uint64_t sudokill_board_hash(const sudokill_board* board)
+{
+  return (NULL != board) ? board->board.Hash() : 0;
+}
+
+void sudokill_engine_options_init(sudokill_engine_options* options)
+{
+  if (NULL != options)
+  {
+    const Engine::Options defaults;
+    options->num_threads = defaults.pool.numThreads;
+    options->pin_threads = defaults.pool.pin ? 1 : 0;
+  }
+}
+
+void sudokill_search_limits_init(sudokill_search_limits* limits)
+{
+  if (NULL != limits)
+  {
+    const Engine::Limits defaults;
+    limits->max_depth = defaults.maxDepth;
+    limits->time_limit_sec = defaults.timeLimitSec;
+  }
+}
+
+sudokill_status sudokill_engine_create(const sudokill_engine_options* options,
+                                       sudokill_engine** engine)
+{
+  if (NULL == engine)
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  *engine = NULL;
+  Engine::Options engineOptions;
+  if (NULL != options)
+  {
+    if (options->num_threads < 0)
+    {
+      return SUDOKILL_INVALID_ARGUMENT;
+    }
+    engineOptions.pool.numThreads = options->num_threads;
+    engineOptions.pool.pin = 0 != options->pin_threads;
+  }
+  if (!s_logLevelSet.exchange(true))
+  {
+    Logger::SetLevel(Log_None);
+  }
+  // Threads and tables may fail to allocate; no exception leaves the API.
+  try
+  {
+    *engine = new sudokill_engine(engineOptions);
+  }
+  catch (...)
+  {
+    return SUDOKILL_OUT_OF_MEMORY;
+  }
+  return SUDOKILL_OK;
+}
+
+void sudokill_engine_destroy(sudokill_engine* engine)
+{
+  delete engine;
+}
+
+sudokill_status sudokill_engine_load_weights(sudokill_engine* engine, const char* path)
+{
+  if ((NULL == engine) || (NULL == path))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  EvalWeights weights;
+  if (!weights.Load(std::string(path)))
+  {
+    return SUDOKILL_PARSE_ERROR;
+  }
+  engine->engine.SetWeights(weights);
+  return SUDOKILL_OK;
+}
+
+sudokill_status sudokill_engine_search(sudokill_engine* engine,
+                                       const sudokill_board* board,
+                                       const sudokill_search_limits* limits,
+                                       sudokill_search_result* result)
+{
+  if ((NULL == engine) || (NULL == board) || (NULL == result) ||
+      ((NULL != limits) && ((limits->max_depth < 2) || (limits->time_limit_sec < 0.0))))
+  {
+    return SUDOKILL_INVALID_ARGUMENT;
+  }
+  Engine::Limits engineLimits;
+  if (NULL != limits)
+  {
+    engineLimits.maxDepth = limits->max_depth;
+    engineLimits.timeLimitSec = limits->time_limit_sec;
+  }
+  Engine::Result engineResult;
+  try
+  {
+    if (!engine->engine.Search(board->board, engineLimits, &engineResult))
+    {
+      return SUDOKILL_NO_MOVES;
+    }
+  }
+  catch (...)
+  {
+    return SUDOKILL_OUT_OF_MEMORY;
+  }
+  result->move = ToMove(engineResult.move);
+  result->score = engineResult.score;
+  result->depth = engineResult.depth;
+  result->sel_depth = engineResult.selDepth;
+  result->nodes = engineResult.nodes;
+  result->seconds = engineResult.seconds;
+  result->complete = engineResult.complete ? 1 : 0;
+  return SUDOKILL_OK;
+}
+
+void sudokill_engine_stop(sudokill_engine* engine)
+{
+  if (NULL != engine)
+  {
+    engine->engine.Stop();
+  }
+}
+
+}
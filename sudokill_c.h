@@ -0,0 +1,183 @@
+#ifndef _HPS_SUDOKILL_C_H_
+#define _HPS_SUDOKILL_C_H_
+#include <stddef.h>
+#include <stdint.h>
+
+/// <summary> C API of the engine library, libsudokill. </summary>
+/// <remarks>
+///   <para> Boards and engines are opaque handles, created and destroyed
+///     through this API. Calls on different handles may run on different
+///     threads at once; one handle is used by one thread at a time, except
+///     for sudokill_engine_stop().
+///   </para>
+///   <para> Calls that can fail return a sudokill_status. Creating an engine
+///     and searching catch C++ exceptions, so none crosses the API.
+///   </para>
+///   <para> The library writes nothing to the host's streams unless the host
+///     turns logging on with sudokill_set_log_level().
+///   </para>
+/// </remarks>
+
+#if defined(_WIN32) && (defined(SUDOKILL_SHARED) || defined(sudokill_lib_EXPORTS))
+#  ifdef sudokill_lib_EXPORTS
+#    define SUDOKILL_API __declspec(dllexport)
+#  else
+#    define SUDOKILL_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define SUDOKILL_API __attribute__((visibility("default")))
+#else
+#  define SUDOKILL_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum sudokill_status
+{
+  SUDOKILL_OK = 0,
+  /// <summary> A NULL handle or an argument out of range. </summary>
+  SUDOKILL_INVALID_ARGUMENT = 1,
+  /// <summary> The move breaks the Sudokill rules. </summary>
+  SUDOKILL_INVALID_MOVE = 2,
+  /// <summary> The state string is not a game state. </summary>
+  SUDOKILL_PARSE_ERROR = 3,
+  /// <summary> The player to move has no valid move. </summary>
+  SUDOKILL_NO_MOVES = 4,
+  SUDOKILL_OUT_OF_MEMORY = 5
+} sudokill_status;
+
+/// <summary> Least severe messages that the library logs. </summary>
+typedef enum sudokill_log_level
+{
+  SUDOKILL_LOG_DEBUG = 0,
+  SUDOKILL_LOG_INFO = 1,
+  SUDOKILL_LOG_WARNING = 2,
+  SUDOKILL_LOG_ERROR = 3,
+  /// <summary> The default. </summary>
+  SUDOKILL_LOG_NONE = 4
+} sudokill_log_level;
+
+/// <summary> A cell and value; x and y in [0, 8], value in [1, 9]. </summary>
+typedef struct sudokill_move
+{
+  int x;
+  int y;
+  int value;
+} sudokill_move;
+
+typedef struct sudokill_board sudokill_board;
+typedef struct sudokill_engine sudokill_engine;
+
+typedef struct sudokill_engine_options
+{
+  /// <summary> Search threads; 0 is one per CPU. </summary>
+  int num_threads;
+  /// <summary> Bind each search thread to one CPU. </summary>
+  int pin_threads;
+} sudokill_engine_options;
+
+typedef struct sudokill_search_limits
+{
+  /// <summary> At least 2. </summary>
+  int max_depth;
+  /// <summary> 0 is no limit. Depth 2 always finishes unless stopped. </summary>
+  double time_limit_sec;
+} sudokill_search_limits;
+
+typedef struct sudokill_search_result
+{
+  sudokill_move move;
+  /// <summary> Minimax from the view of the player to move; INT_MAX is a
+  ///   proven win and INT_MIN a proven loss.
+  /// </summary>
+  int score;
+  int depth;
+  int sel_depth;
+  long long nodes;
+  double seconds;
+  /// <summary> 0 when time or sudokill_engine_stop() cut the search short. </summary>
+  int complete;
+} sudokill_search_result;
+
+SUDOKILL_API const char* sudokill_status_string(sudokill_status status);
+
+/// <summary> Log messages at the level and above to stderr. Affects every
+///   engine in the process; debug messages need a debug build.
+/// </summary>
+SUDOKILL_API sudokill_status sudokill_set_log_level(sudokill_log_level level);
+
+/// <summary> A board with the presets, then the moves played in turn. Either
+///   list may be empty. On failure *board is NULL.
+/// </summary>
+SUDOKILL_API sudokill_status sudokill_board_create(const sudokill_move* presets,
+                                                   int num_presets,
+                                                   const sudokill_move* moves,
+                                                   int num_moves,
+                                                   sudokill_board** board);
+
+/// <summary> A board from a state string of the game server, from
+///   MOVE START to MOVE END.
+/// </summary>
+SUDOKILL_API sudokill_status sudokill_board_parse(const char* state_string,
+                                                  sudokill_board** board);
+
+SUDOKILL_API sudokill_status sudokill_board_clone(const sudokill_board* board,
+                                                  sudokill_board** clone);
+
+SUDOKILL_API void sudokill_board_destroy(sudokill_board* board);
+
+SUDOKILL_API sudokill_status sudokill_board_play(sudokill_board* board, sudokill_move move);
+
+/// <summary> Take back the last move; presets stay. </summary>
+SUDOKILL_API sudokill_status sudokill_board_undo(sudokill_board* board);
+
+/// <summary> Write up to capacity valid moves; returns how many there are,
+///   which may be more than capacity, or -1 for a NULL board.
+/// </summary>
+SUDOKILL_API int sudokill_board_valid_moves(const sudokill_board* board,
+                                            sudokill_move* moves,
+                                            int capacity);
+
+/// <summary> The value at x, y; 0 when empty, -1 when out of range. </summary>
+SUDOKILL_API int sudokill_board_value_at(const sudokill_board* board, int x, int y);
+
+/// <summary> Moves played after the presets. </summary>
+SUDOKILL_API int sudokill_board_moves_played(const sudokill_board* board);
+
+/// <summary> Zobrist key of the cells and the last move. </summary>
+SUDOKILL_API uint64_t sudokill_board_hash(const sudokill_board* board);
+
+SUDOKILL_API void sudokill_engine_options_init(sudokill_engine_options* options);
+
+SUDOKILL_API void sudokill_search_limits_init(sudokill_search_limits* limits);
+
+/// <summary> An engine with its own search threads; NULL options
+///   are the defaults. On failure *engine is NULL.
+/// </summary>
+SUDOKILL_API sudokill_status sudokill_engine_create(const sudokill_engine_options* options,
+                                                    sudokill_engine** engine);
+
+SUDOKILL_API void sudokill_engine_destroy(sudokill_engine* engine);
+
+/// <summary> Evaluate with a weights file written by sudokill_tune. </summary>
+SUDOKILL_API sudokill_status sudokill_engine_load_weights(sudokill_engine* engine,
+                                                          const char* path);
+
+/// <summary> Search for the move of the player to move; NULL limits are the
+///   defaults.
+/// </summary>
+SUDOKILL_API sudokill_status sudokill_engine_search(sudokill_engine* engine,
+                                                    const sudokill_board* board,
+                                                    const sudokill_search_limits* limits,
+                                                    sudokill_search_result* result);
+
+/// <summary> End the engine's running search soon; safe from any thread. </summary>
+SUDOKILL_API void sudokill_engine_stop(sudokill_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_HPS_SUDOKILL_C_H_
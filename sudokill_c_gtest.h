@@ -0,0 +1,121 @@
+#ifndef _HPS_SUDOKILL_C_GTEST_H_
+#define _HPS_SUDOKILL_C_GTEST_H_
+
+#include "sudokill_c.h"
+#include "log.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+namespace _hps_sudokill_c_gtest_h_
+{
+
+TEST(SudokillC, Board)
+{
+  const sudokill_move presets[] = { { 0, 0, 5, }, { 0, 3, 4, }, };
+  const sudokill_move moves[] = { { 4, 3, 8, }, };
+  sudokill_board* board = NULL;
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_create(presets, 2, moves, 1, &board));
+  EXPECT_EQ(5, sudokill_board_value_at(board, 0, 0));
+  EXPECT_EQ(8, sudokill_board_value_at(board, 4, 3));
+  EXPECT_EQ(0, sudokill_board_value_at(board, 4, 4));
+  EXPECT_EQ(-1, sudokill_board_value_at(board, 9, 0));
+  EXPECT_EQ(1, sudokill_board_moves_played(board));
+  // The same game from a state string.
+  const char* stateString =
+    "MOVE START\n"
+    "0 0 5\n"
+    "0 3 4\n"
+    "-1 -1 -1\n"
+    "4 3 8\n"
+    "MOVE END\n";
+  sudokill_board* parsed = NULL;
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_parse(stateString, &parsed));
+  EXPECT_EQ(sudokill_board_hash(board), sudokill_board_hash(parsed));
+  const int numMoves = sudokill_board_valid_moves(board, NULL, 0);
+  ASSERT_GT(numMoves, 0);
+  std::vector<sudokill_move> valid(numMoves);
+  EXPECT_EQ(numMoves, sudokill_board_valid_moves(board, &valid[0], numMoves));
+  // Valid moves follow the last move's row or column.
+  for (int moveIdx = 0; moveIdx < numMoves; ++moveIdx)
+  {
+    EXPECT_TRUE((4 == valid[moveIdx].x) || (3 == valid[moveIdx].y));
+  }
+  sudokill_board* clone = NULL;
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_clone(board, &clone));
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_play(clone, valid[0]));
+  EXPECT_EQ(2, sudokill_board_moves_played(clone));
+  EXPECT_EQ(1, sudokill_board_moves_played(board));
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_undo(clone));
+  EXPECT_EQ(sudokill_board_hash(board), sudokill_board_hash(clone));
+  sudokill_board_destroy(clone);
+  sudokill_board_destroy(parsed);
+  sudokill_board_destroy(board);
+}
+
+TEST(SudokillC, Errors)
+{
+  sudokill_board* board = NULL;
+  EXPECT_EQ(SUDOKILL_INVALID_ARGUMENT, sudokill_board_create(NULL, 1, NULL, 0, &board));
+  const sudokill_move clash[] = { { 0, 0, 5, }, { 1, 1, 5, }, };
+  EXPECT_EQ(SUDOKILL_INVALID_MOVE, sudokill_board_create(clash, 2, NULL, 0, &board));
+  EXPECT_TRUE(NULL == board);
+  const sudokill_move offBoard[] = { { 9, 0, 5, }, };
+  EXPECT_EQ(SUDOKILL_INVALID_MOVE, sudokill_board_create(offBoard, 1, NULL, 0, &board));
+  EXPECT_EQ(SUDOKILL_PARSE_ERROR, sudokill_board_parse("0 0 5\n", &board));
+  EXPECT_EQ(SUDOKILL_PARSE_ERROR,
+            sudokill_board_parse("MOVE START\n-1 -1 -1\n0 0 12\nMOVE END\n", &board));
+  // The second move is off the first move's row and column.
+  EXPECT_EQ(SUDOKILL_PARSE_ERROR,
+            sudokill_board_parse("MOVE START\n-1 -1 -1\n0 0 1\n5 5 1\nMOVE END\n", &board));
+  EXPECT_TRUE(NULL == board);
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_create(NULL, 0, NULL, 0, &board));
+  EXPECT_EQ(SUDOKILL_INVALID_ARGUMENT, sudokill_board_undo(board));
+  const sudokill_move first = { 2, 2, 3, };
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_play(board, first));
+  // Off the last move's row and column.
+  const sudokill_move far = { 5, 5, 1, };
+  EXPECT_EQ(SUDOKILL_INVALID_MOVE, sudokill_board_play(board, far));
+  sudokill_board_destroy(board);
+  EXPECT_EQ(SUDOKILL_INVALID_ARGUMENT, sudokill_engine_search(NULL, NULL, NULL, NULL));
+  EXPECT_STREQ("invalid move", sudokill_status_string(SUDOKILL_INVALID_MOVE));
+  EXPECT_EQ(SUDOKILL_INVALID_ARGUMENT,
+            sudokill_set_log_level(static_cast<sudokill_log_level>(SUDOKILL_LOG_NONE + 1)));
+}
+
+TEST(SudokillC, Search)
+{
+  sudokill_engine_options options;
+  sudokill_engine_options_init(&options);
+  options.num_threads = 2;
+  sudokill_engine* engine = NULL;
+  ASSERT_EQ(SUDOKILL_OK, sudokill_engine_create(&options, &engine));
+  // The host never set a level, so the engine logs nothing.
+  EXPECT_FALSE(hps::Logger::Enabled(hps::Log_Error));
+  sudokill_board* board = NULL;
+  ASSERT_EQ(SUDOKILL_OK, sudokill_board_create(NULL, 0, NULL, 0, &board));
+  // Play the engine against itself to the end.
+  sudokill_search_limits limits;
+  sudokill_search_limits_init(&limits);
+  limits.max_depth = 3;
+  sudokill_search_result result;
+  int moves = 0;
+  sudokill_status status;
+  while (SUDOKILL_OK == (status = sudokill_engine_search(engine, board, &limits, &result)))
+  {
+    EXPECT_GE(result.depth, 2);
+    ASSERT_EQ(SUDOKILL_OK, sudokill_board_play(board, result.move));
+    ++moves;
+  }
+  EXPECT_EQ(SUDOKILL_NO_MOVES, status);
+  EXPECT_EQ(moves, sudokill_board_moves_played(board));
+  EXPECT_EQ(0, sudokill_board_valid_moves(board, NULL, 0));
+  limits.max_depth = 1;
+  EXPECT_EQ(SUDOKILL_INVALID_ARGUMENT, sudokill_engine_search(engine, board, &limits, &result));
+  sudokill_engine_stop(engine);
+  sudokill_board_destroy(board);
+  sudokill_engine_destroy(engine);
+}
+
+}
+
+#endif //_HPS_SUDOKILL_C_GTEST_H_
@@ -5,8 +5,11 @@
 #include <algorithm>
 #include <functional>
 #include <assert.h>
+#include <stdint.h>
 #include <iostream>
 #include "rand_bound.h"
+#include "candidate_masks.h"
+#include "nnue.h"
 
 namespace hps 
 {
@@ -76,12 +79,29 @@ public:
 
   typedef std::vector<Cell> MoveList;
 
-  GenericBoard() : positions(), playerMoveCount(0) {}
+  GenericBoard()
+  : positions(),
+    playerMoveCount(0),
+    cellsHash(0),
+    candidates(),
+    history(),
+    network(NULL),
+    accumulator()
+  {
+    Rebuild();
+  }
   /// <summary> Initialize with a list of preset cells. </summary>
   explicit GenericBoard(const MoveList& preset)
   : positions(preset),
-    playerMoveCount(0)
-  {}
+    playerMoveCount(0),
+    cellsHash(0),
+    candidates(),
+    history(),
+    network(NULL),
+    accumulator()
+  {
+    Rebuild();
+  }
   
   /// <summary> Predicate to test that a move is at a given point. </summary>
   struct MoveMatchesPoint
@@ -94,9 +114,7 @@ public:
   /// <summary> Test if the given board location is occupied. </summary>
   inline bool Occupied(const Point& p) const
   {
-    return positions.end() != std::find_if(positions.begin(),
-                                           positions.end(),
-                                           MoveMatchesPoint(&p));
+    return candidates.Occupied(CellIndex(p));
   }
   
   /// <summary> This function puts the value at a point</summary>
@@ -110,9 +128,18 @@ public:
     //assert if position occupied.
     assert(!Occupied(p));
     
+    const int previousIdx = LastMoveIndex();
     //position is set by creating an object of type Cell.
     positions.push_back(Cell(p,value));
     ++playerMoveCount;
+    // Only the peers of p lose a candidate.
+    history.push_back(candidates.Play(CellIndex(p), value));
+    values[CellIndex(p)] = static_cast<unsigned char>(value);
+    cellsHash ^= Zobrist().cells[CellIndex(p)][value];
+    if(network)
+    {
+      network->PlayMove(previousIdx, CellIndex(p), value, &accumulator[0]);
+    }
   }
 
   inline void PlayMove(const Cell& c)
@@ -127,8 +154,36 @@ public:
   {
     assert(!positions.empty());
     // the last value played is put at the back.
-    positions.pop_back();
+    const Cell& last = positions.back();
+    const int cellIdx = CellIndex(last.location);
+    const int value = last.value;
+    values[cellIdx] = Empty;
+    cellsHash ^= Zobrist().cells[cellIdx][value];
+    const bool incremental = !history.empty();
+    if(incremental)
+    {
+      candidates.Unplay(cellIdx, value, history.back());
+      history.pop_back();
+      positions.pop_back();
+    }
+    // Taking back a preset has no delta to restore from.
+    else
+    {
+      positions.pop_back();
+      Rebuild();
+    }
     --playerMoveCount;
+    if(network)
+    {
+      if(incremental)
+      {
+        network->Undo(LastMoveIndex(), cellIdx, value, &accumulator[0]);
+      }
+      else
+      {
+        RefreshAccumulator();
+      }
+    }
   }
   
   /// <summary> This function returns the value at a point</summary>
@@ -138,20 +193,7 @@ public:
   {
     assert(p.x >= 0 && p.x < MaxX);
     assert(p.y >= 0 && p.y < MaxY);
-    
-    typedef typename MoveList::const_iterator ConstPosition;
-    const ConstPosition positionsEnd = positions.end();
-    ConstPosition pos = std::find_if(positions.begin(),
-                                     positionsEnd,
-                                     MoveMatchesPoint(&p));
-    if(pos != positionsEnd)
-    {
-      return (*pos).value;
-    }
-    else
-    {
-      return Empty;
-    }
+    return values[CellIndex(p)];
   }
   
   /// <summary> Check if the move is valid by the Sudokill rules. </summary>
@@ -217,6 +259,7 @@ public:
     assert(moveBuffer);
     moveBuffer->clear();
 
+    const CandidateMasks& masks = candidates;
     if(playerMoveCount > 0)
     {
       int unoccupiedFound = 0;
@@ -227,16 +270,11 @@ public:
       for(int x = 0; x < MaxX; x++)
       {
         testPoint.x = x;
-        if(!Occupied(testPoint))
+        const int cellIdx = CandidateMasks::CellIndex(x, testPoint.y);
+        if(!masks.Occupied(cellIdx))
         {
           ++unoccupiedFound;
-          for(int value = 1; value <= MaxValue; value++)
-          {
-            if(IsSudokuValidMove(testPoint, value))
-            {
-              moveBuffer->push_back(Cell(testPoint,value));
-            }
-          }
+          PushCandidates(testPoint, masks.cells[cellIdx], moveBuffer);
         }
       }
 
@@ -244,16 +282,11 @@ public:
       for(int y = 0; y < MaxY; y++)
       {
         testPoint.y = y;
-        if(!Occupied(testPoint))
+        const int cellIdx = CandidateMasks::CellIndex(testPoint.x, y);
+        if(!masks.Occupied(cellIdx))
         {
           ++unoccupiedFound;
-          for(int value = 1; value <= MaxValue; value++)
-          {
-            if(IsSudokuValidMove(testPoint, value))
-            {
-              moveBuffer->push_back(Cell(testPoint,value));
-            }
-          }
+          PushCandidates(testPoint, masks.cells[cellIdx], moveBuffer);
         }
       }
       // When there are unoccupied spaces that are not Sudoku-valid, then we
@@ -265,7 +298,7 @@ public:
     }
     if(moveBuffer->empty())
     {
-      SudokuValidMoves(moveBuffer);
+      SudokuValidMoves(masks, moveBuffer);
     }
   }
 
@@ -278,35 +311,13 @@ public:
   /// <summary> Verify that the row conforms to Sudoku rules. </sumary>
   bool IsValidRow(const Point& p, int value) const
   {
-    typename MoveList::const_iterator pos = positions.begin();
-    const MoveList::const_iterator positionsEnd = positions.end();
-    for(; pos != positionsEnd; ++pos)
-    {
-      if((*pos).location.y == p.y && (*pos).value == value)
-      {
-        //std::cout << "isValidRow returned false" << std::endl;
-        return false;
-      }
-    }
-    //std::cout << "isValidRow returned true" <<std::endl;
-    return true;
+    return !UnitHasValue(CandidateMasks::RowUnit + p.y, value);
   }
   
   /// <summary> Verify that the column conforms to Sudoku rules. </sumary>
   bool IsValidColumn(const Point& p, int value) const
   {
-    typename MoveList::const_iterator pos = positions.begin();
-    const MoveList::const_iterator positionsEnd = positions.end();
-    for(; pos != positionsEnd; ++pos)
-    {
-      if((*pos).location.x == p.x && (*pos).value == value)
-      {
-        //std::cout << "isValidColumn returned false" <<std::endl;
-        return false;
-      }
-    }
-    //std::cout << "isValidColumn returned true" <<std::endl;
-    return true;
+    return !UnitHasValue(CandidateMasks::ColumnUnit + p.x, value);
   }
 
   /// <summary> Verify that the point is within the bounding box. </summary>
@@ -370,23 +381,7 @@ public:
   {
     assert(p.x >=0 && p.x < MaxX);
     assert(p.y >=0 && p.y < MaxY);
-    //std::cout << "value: " << value <<std::endl;
-    const int boxNumber = BoxNumber(p);
-    //std::cout << "box Number: " << boxNumber <<std::endl;
-    Point pNW;
-    Point pSE;
-    GetBoundingBox(boxNumber,&pNW,&pSE);
-
-    typename MoveList::const_iterator pos = positions.begin();
-    const MoveList::const_iterator positionsEnd = positions.end();
-    for(; pos != positionsEnd; ++pos)
-    {
-      if(IsWithinBox(pNW, pSE, pos->location) && pos->value == value )
-      {
-        return false;
-      }
-    }
-    return true;
+    return !UnitHasValue(CandidateMasks::BoxUnit + BoxNumber(p) - 1, value);
   }
 
   /// <summary> Get Sudoku 3x3 box index. </summary>
@@ -397,27 +392,57 @@ public:
     return (y*3 + x + 1);
   }
 
+  /// <summary> Sudoku candidates of every cell, kept current by PlayMove
+  ///   and Undo.
+  /// </summary>
+  inline const CandidateMasks& GetCandidates() const
+  {
+    return candidates;
+  }
+
+  /// <summary> Compute the Sudoku candidates of every cell from scratch. </summary>
+  void ComputeCandidates(CandidateMasks* masks) const
+  {
+    assert(masks);
+    assert((static_cast<int>(MaxX) == CandidateMasks::Dim) &&
+           (static_cast<int>(MaxY) == CandidateMasks::Dim));
+    masks->Clear();
+    typename MoveList::const_iterator pos = positions.begin();
+    const typename MoveList::const_iterator positionsEnd = positions.end();
+    for(; pos != positionsEnd; ++pos)
+    {
+      masks->Place(CandidateMasks::CellIndex(pos->location.x, pos->location.y),
+                   pos->value);
+    }
+    masks->Compute();
+  }
+
   /// <summary> Get the list of valid Sudoku moves from the
   ///   current state.
   /// </summary>
   void SudokuValidMoves(MoveList* moveBuffer) const
+  {
+    SudokuValidMoves(candidates, moveBuffer);
+  }
+
+  /// <summary> Get the list of valid Sudoku moves from precomputed
+  ///   candidates.
+  /// </summary>
+  void SudokuValidMoves(const CandidateMasks& masks, MoveList* moveBuffer) const
   {
     assert(moveBuffer);
-    // This is the dumbest code I've ever written.
-    // Memoizing it would bring a pretty big performance benefit
-    // Cachebust on PlayMove and Undo
-    // RJS 5/12
+    if(0 == masks.total)
+    {
+      return;
+    }
     for(int i = 0; i < MaxX; i++)
     {
       for(int j = 0; j < MaxY; j++)
       {
-        Point p(i,j);
-        for(int v = MinValue; v <= MaxValue; v++)
+        const CandidateMasks::Mask cell = masks.cells[CandidateMasks::CellIndex(i, j)];
+        if(cell)
         {
-          if(IsSudokuValidMove(p, v))
-          {
-            moveBuffer->push_back(Cell(p,v));
-          }
+          PushCandidates(Point(i,j), cell, moveBuffer);
         }
       }
     }
@@ -443,22 +468,23 @@ public:
     }
   }
 
-  void PrintBoard() const
+  /// <summary> Draw the grid, one row per line. </summary>
+  void PrintBoard(std::ostream& out = std::cout) const
   {
-    std::cout << "  012 345 678  " << std::endl;
-    std::cout << "  ____________ " << std::endl;
-    std::cout << "0|" << ValueAt(Point(0,0)) << ValueAt(Point(1,0)) << ValueAt(Point(2,0))<<"|" << ValueAt(Point(3,0)) << ValueAt(Point(4,0)) << ValueAt(Point(5,0)) <<"|"<< ValueAt(Point(6,0)) << ValueAt(Point(7,0)) << ValueAt(Point(8,0)) << "|" << std::endl;
-    std::cout << "1|" << ValueAt(Point(0,1)) << ValueAt(Point(1,1)) << ValueAt(Point(2,1))<<"|" << ValueAt(Point(3,1)) << ValueAt(Point(4,1)) << ValueAt(Point(5,1)) <<"|"<< ValueAt(Point(6,1)) << ValueAt(Point(7,1)) << ValueAt(Point(8,1)) << "|" << std::endl;
-    std::cout << "2|" << ValueAt(Point(0,2)) << ValueAt(Point(1,2)) << ValueAt(Point(2,2))<<"|" << ValueAt(Point(3,2)) << ValueAt(Point(4,2)) << ValueAt(Point(5,2)) <<"|"<< ValueAt(Point(6,2)) << ValueAt(Point(7,2)) << ValueAt(Point(8,2)) << "|" << std::endl;
-    std::cout << " |---|---|---| " << std::endl;
-    std::cout << "3|" << ValueAt(Point(0,3)) << ValueAt(Point(1,3)) << ValueAt(Point(2,3))<<"|" << ValueAt(Point(3,3)) << ValueAt(Point(4,3)) << ValueAt(Point(5,3)) <<"|"<< ValueAt(Point(6,3)) << ValueAt(Point(7,3)) << ValueAt(Point(8,3)) << "|" << std::endl;
-    std::cout << "4|" << ValueAt(Point(0,4)) << ValueAt(Point(1,4)) << ValueAt(Point(2,4))<<"|" << ValueAt(Point(3,4)) << ValueAt(Point(4,4)) << ValueAt(Point(5,4)) <<"|"<< ValueAt(Point(6,4)) << ValueAt(Point(7,4)) << ValueAt(Point(8,4)) << "|" << std::endl;
-    std::cout << "5|" << ValueAt(Point(0,5)) << ValueAt(Point(1,5)) << ValueAt(Point(2,5))<<"|" << ValueAt(Point(3,5)) << ValueAt(Point(4,5)) << ValueAt(Point(5,5)) <<"|"<< ValueAt(Point(6,5)) << ValueAt(Point(7,5)) << ValueAt(Point(8,5)) << "|" << std::endl;
-    std::cout << " |---|---|---| " << std::endl;
-    std::cout << "6|" << ValueAt(Point(0,6)) << ValueAt(Point(1,6)) << ValueAt(Point(2,6))<<"|" << ValueAt(Point(3,6)) << ValueAt(Point(4,6)) << ValueAt(Point(5,6)) <<"|"<< ValueAt(Point(6,6)) << ValueAt(Point(7,6)) << ValueAt(Point(8,6)) << "|" << std::endl;
-    std::cout << "7|" << ValueAt(Point(0,7)) << ValueAt(Point(1,7)) << ValueAt(Point(2,7))<<"|" << ValueAt(Point(3,7)) << ValueAt(Point(4,7)) << ValueAt(Point(5,7)) <<"|"<< ValueAt(Point(6,7)) << ValueAt(Point(7,7)) << ValueAt(Point(8,7)) << "|" << std::endl;
-    std::cout << "8|" << ValueAt(Point(0,8)) << ValueAt(Point(1,8)) << ValueAt(Point(2,8))<<"|" << ValueAt(Point(3,8)) << ValueAt(Point(4,8)) << ValueAt(Point(5,8)) <<"|"<< ValueAt(Point(6,8)) << ValueAt(Point(7,8)) << ValueAt(Point(8,8)) << "|" << std::endl;
-    std::cout << " |---|---|---  " << std::endl;
+    out << "  012 345 678  " << "\n";
+    out << "  ____________ " << "\n";
+    out << "0|" << ValueAt(Point(0,0)) << ValueAt(Point(1,0)) << ValueAt(Point(2,0))<<"|" << ValueAt(Point(3,0)) << ValueAt(Point(4,0)) << ValueAt(Point(5,0)) <<"|"<< ValueAt(Point(6,0)) << ValueAt(Point(7,0)) << ValueAt(Point(8,0)) << "|" << "\n";
+    out << "1|" << ValueAt(Point(0,1)) << ValueAt(Point(1,1)) << ValueAt(Point(2,1))<<"|" << ValueAt(Point(3,1)) << ValueAt(Point(4,1)) << ValueAt(Point(5,1)) <<"|"<< ValueAt(Point(6,1)) << ValueAt(Point(7,1)) << ValueAt(Point(8,1)) << "|" << "\n";
+    out << "2|" << ValueAt(Point(0,2)) << ValueAt(Point(1,2)) << ValueAt(Point(2,2))<<"|" << ValueAt(Point(3,2)) << ValueAt(Point(4,2)) << ValueAt(Point(5,2)) <<"|"<< ValueAt(Point(6,2)) << ValueAt(Point(7,2)) << ValueAt(Point(8,2)) << "|" << "\n";
+    out << " |---|---|---| " << "\n";
+    out << "3|" << ValueAt(Point(0,3)) << ValueAt(Point(1,3)) << ValueAt(Point(2,3))<<"|" << ValueAt(Point(3,3)) << ValueAt(Point(4,3)) << ValueAt(Point(5,3)) <<"|"<< ValueAt(Point(6,3)) << ValueAt(Point(7,3)) << ValueAt(Point(8,3)) << "|" << "\n";
+    out << "4|" << ValueAt(Point(0,4)) << ValueAt(Point(1,4)) << ValueAt(Point(2,4))<<"|" << ValueAt(Point(3,4)) << ValueAt(Point(4,4)) << ValueAt(Point(5,4)) <<"|"<< ValueAt(Point(6,4)) << ValueAt(Point(7,4)) << ValueAt(Point(8,4)) << "|" << "\n";
+    out << "5|" << ValueAt(Point(0,5)) << ValueAt(Point(1,5)) << ValueAt(Point(2,5))<<"|" << ValueAt(Point(3,5)) << ValueAt(Point(4,5)) << ValueAt(Point(5,5)) <<"|"<< ValueAt(Point(6,5)) << ValueAt(Point(7,5)) << ValueAt(Point(8,5)) << "|" << "\n";
+    out << " |---|---|---| " << "\n";
+    out << "6|" << ValueAt(Point(0,6)) << ValueAt(Point(1,6)) << ValueAt(Point(2,6))<<"|" << ValueAt(Point(3,6)) << ValueAt(Point(4,6)) << ValueAt(Point(5,6)) <<"|"<< ValueAt(Point(6,6)) << ValueAt(Point(7,6)) << ValueAt(Point(8,6)) << "|" << "\n";
+    out << "7|" << ValueAt(Point(0,7)) << ValueAt(Point(1,7)) << ValueAt(Point(2,7))<<"|" << ValueAt(Point(3,7)) << ValueAt(Point(4,7)) << ValueAt(Point(5,7)) <<"|"<< ValueAt(Point(6,7)) << ValueAt(Point(7,7)) << ValueAt(Point(8,7)) << "|" << "\n";
+    out << "8|" << ValueAt(Point(0,8)) << ValueAt(Point(1,8)) << ValueAt(Point(2,8))<<"|" << ValueAt(Point(3,8)) << ValueAt(Point(4,8)) << ValueAt(Point(5,8)) <<"|"<< ValueAt(Point(6,8)) << ValueAt(Point(7,8)) << ValueAt(Point(8,8)) << "|" << "\n";
+    out << " |---|---|---  " << "\n";
   }
 
   /// <summary> Query number of moves made by players. </summary>
@@ -480,13 +506,161 @@ public:
     return positions.back();
   }
 
+  /// <summary> Keep the first layer of the network current through
+  ///   PlayMove and Undo, or stop with NULL. The network must outlive the
+  ///   board and its copies.
+  /// </summary>
+  void AttachNetwork(const NnueNetwork* network_)
+  {
+    network = network_;
+    accumulator.clear();
+    RefreshAccumulator();
+  }
+
+  inline const NnueNetwork* GetNetwork() const
+  {
+    return network;
+  }
+
+  /// <summary> First layer of the attached network for this position. </summary>
+  inline const int16_t* GetAccumulator() const
+  {
+    assert(network);
+    return &accumulator[0];
+  }
+
+  /// <summary> 64-bit Zobrist hash of the cells and of the last move, which
+  ///   decides the valid moves. Kept current by PlayMove and Undo.
+  /// </summary>
+  inline uint64_t Hash() const
+  {
+    return (playerMoveCount > 0) ?
+           (cellsHash ^ Zobrist().lastMove[CellIndex(positions.back().location)]) :
+           cellsHash;
+  }
+
 private:
+  /// <summary> Random keys for each value in each cell and for the last move. </summary>
+  struct ZobristKeys
+  {
+    ZobristKeys()
+    {
+      // splitmix64 from a fixed seed, so hashes agree between runs.
+      uint64_t state = 0x5D0C111ULL;
+      for(int cellIdx = 0; cellIdx < MaxX * MaxY; cellIdx++)
+      {
+        for(int v = 0; v <= MaxValue; v++)
+        {
+          cells[cellIdx][v] = Next(&state);
+        }
+        lastMove[cellIdx] = Next(&state);
+      }
+    }
+
+    inline static uint64_t Next(uint64_t* state)
+    {
+      uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+
+    uint64_t cells[MaxX * MaxY][MaxValue + 1];
+    uint64_t lastMove[MaxX * MaxY];
+  };
+
+  inline static const ZobristKeys& Zobrist()
+  {
+    static const ZobristKeys s_keys;
+    return s_keys;
+  }
+
+  inline static int CellIndex(const Point& p)
+  {
+    return CandidateMasks::CellIndex(p.x, p.y);
+  }
+
+  /// <summary> Test if a row, column or box already holds the value. </summary>
+  inline bool UnitHasValue(const int unit, const int value) const
+  {
+    return IsValidValue(value) &&
+           (0 != (candidates.units[unit] & CandidateMasks::ValueBit(value)));
+  }
+
+  /// <summary> Recompute the grid and candidates from positions. </summary>
+  void Rebuild()
+  {
+    assert((static_cast<int>(MaxX) == CandidateMasks::Dim) &&
+           (static_cast<int>(MaxY) == CandidateMasks::Dim));
+    history.clear();
+    memset(values, Empty, sizeof(values));
+    cellsHash = 0;
+    typename MoveList::const_iterator pos = positions.begin();
+    const typename MoveList::const_iterator positionsEnd = positions.end();
+    for(; pos != positionsEnd; ++pos)
+    {
+      values[CellIndex(pos->location)] = static_cast<unsigned char>(pos->value);
+      cellsHash ^= Zobrist().cells[CellIndex(pos->location)][pos->value];
+    }
+    ComputeCandidates(&candidates);
+    RefreshAccumulator();
+  }
+
+  /// <summary> Cell index of the last move, or -1 before the first. </summary>
+  inline int LastMoveIndex() const
+  {
+    return (playerMoveCount > 0) ? CellIndex(positions.back().location) : -1;
+  }
+
+  /// <summary> Recompute the network's first layer from the cells. </summary>
+  void RefreshAccumulator()
+  {
+    if(network)
+    {
+      accumulator.resize(NnueNetwork::HiddenSize);
+      network->Refresh(values, LastMoveIndex(), &accumulator[0]);
+    }
+  }
+
+  /// <summary> Append a move for each value in the candidate mask. </summary>
+  inline static void PushCandidates(const Point& p,
+                                    const CandidateMasks::Mask candidates,
+                                    MoveList* moveBuffer)
+  {
+    for(int v = MinValue; v <= MaxValue; v++)
+    {
+      if(candidates & CandidateMasks::ValueBit(v))
+      {
+        moveBuffer->push_back(Cell(p,v));
+      }
+    }
+  }
+
   /// <summary> List of occupied board cells. </summary>
   MoveList positions;
   /// <summary> Number of moves made by players. </summary>
   int playerMoveCount;
+  /// <summary> Value in each cell, indexed like CandidateMasks. </summary>
+  unsigned char values[MaxX * MaxY];
+  /// <summary> Zobrist hash of the cells alone. </summary>
+  uint64_t cellsHash;
+  /// <summary> Live Sudoku candidates of every cell. </summary>
+  CandidateMasks candidates;
+  /// <summary> Undo information for each PlayMove. </summary>
+  std::vector<CandidateMasks::Delta> history;
+  /// <summary> Network whose first layer is kept in accumulator, or NULL. </summary>
+  const NnueNetwork* network;
+  /// <summary> First layer of network for this position. </summary>
+  std::vector<int16_t> accumulator;
 };
 
+template<int MaxX_, int MaxY_>
+inline std::ostream& operator<<(std::ostream& out, const GenericBoard<MaxX_, MaxY_>& board)
+{
+  board.PrintBoard(out);
+  return out;
+}
+
 typedef sudokill::GenericBoard<9, 9> Board;
 
 inline void AnyPlyWillDo(const Board* board, Cell* cell)
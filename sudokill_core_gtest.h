@@ -186,6 +186,89 @@ TEST(GenericBoard, IsValidMove)
   board.PlayMove(Point(0,8),9); // No moves left in column 0 and row 8.
   EXPECT_TRUE(board.IsValidMove(Point(2,2),9));
 }
+
+TEST(GenericBoard, IncrementalCandidates)
+{
+  Board::MoveList moves;
+  for (int trial = 0; trial < 20; ++trial)
+  {
+    Board board;
+    int played = 0;
+    for (int step = 0; step < 200; ++step)
+    {
+      // Mostly play, sometimes take back.
+      board.ValidMoves(&moves);
+      if ((played > 0) && (moves.empty() || (0 == RandBound(4))))
+      {
+        board.Undo();
+        --played;
+      }
+      else if (!moves.empty())
+      {
+        board.PlayMove(moves[RandBound(static_cast<int>(moves.size()))]);
+        ++played;
+      }
+      CandidateMasks expected;
+      board.ComputeCandidates(&expected);
+      const CandidateMasks& actual = board.GetCandidates();
+      ASSERT_EQ(expected.total, actual.total);
+      ASSERT_EQ(expected.deadCells, actual.deadCells);
+      for (int cellIdx = 0; cellIdx < CandidateMasks::NumCells; ++cellIdx)
+      {
+        ASSERT_EQ(expected.cells[cellIdx], actual.cells[cellIdx]);
+        ASSERT_EQ(expected.counts[cellIdx], actual.counts[cellIdx]);
+        ASSERT_EQ(expected.Occupied(cellIdx), actual.Occupied(cellIdx));
+      }
+    }
+  }
+}
+
+TEST(GenericBoard, UndoPreset)
+{
+  Board::MoveList presets;
+  presets.push_back(Cell(Point(0, 0), 5));
+  presets.push_back(Cell(Point(4, 4), 3));
+  Board board(presets);
+  EXPECT_EQ(5, board.ValueAt(Point(0, 0)));
+  board.Undo();
+  EXPECT_EQ(static_cast<int>(Board::Empty), board.ValueAt(Point(4, 4)));
+  EXPECT_TRUE(board.IsSudokuValidMove(Point(4, 5), 3));
+  EXPECT_FALSE(board.IsSudokuValidMove(Point(0, 5), 5));
+}
+
+TEST(GenericBoard, Hash)
+{
+  Board a;
+  const uint64_t empty = a.Hash();
+  a.PlayMove(Point(0, 0), 1);
+  a.PlayMove(Point(0, 5), 2);
+  Board b;
+  b.PlayMove(Point(0, 5), 2);
+  b.PlayMove(Point(0, 0), 1);
+  // Same cells, but the last move decides the valid moves.
+  EXPECT_NE(a.Hash(), b.Hash());
+  a.PlayMove(Point(0, 3), 4);
+  b.PlayMove(Point(0, 3), 4);
+  EXPECT_EQ(a.Hash(), b.Hash());
+  const uint64_t played = a.Hash();
+  a.Undo();
+  EXPECT_NE(played, a.Hash());
+  a.PlayMove(Point(0, 3), 4);
+  EXPECT_EQ(played, a.Hash());
+  a.Undo();
+  a.Undo();
+  a.Undo();
+  EXPECT_EQ(empty, a.Hash());
+  // Presets hash as their cells; taking one back rebuilds the same hash.
+  Board::MoveList presets;
+  presets.push_back(Cell(Point(0, 0), 5));
+  Board preset(presets);
+  presets.push_back(Cell(Point(4, 4), 3));
+  Board twoPresets(presets);
+  twoPresets.Undo();
+  EXPECT_EQ(preset.Hash(), twoPresets.Hash());
+  EXPECT_NE(empty, preset.Hash());
+}
 }
 
 #endif //_HPS_SUDOKILL_CORE_GTEST_H_
@@ -0,0 +1,70 @@
+#include "differential.h"
+#include "timer.h"
+#include <string>
+#include <iostream>
+#include <stdlib.h>
+#include <omp.h>
+
+using namespace hps;
+
+int main(int argc, char** argv)
+{
+  if ((argc < 2) || (argc > 4))
+  {
+    std::cerr << "Usage: " << argv[0] << " NUM_TRACES [MAX_STEPS] [SEED]" << std::endl
+              << "  Plays random traces through Board and ReferenceBoard and"
+              << " prints a shrunk reproducer on divergence." << std::endl;
+    return 1;
+  }
+  const int numTraces = atoi(argv[1]);
+  const int maxSteps = (argc > 2) ? atoi(argv[2]) : 100;
+  const uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) :
+                                     static_cast<uint64_t>(Rng::DefaultSeed);
+
+  Timer timer;
+  // Each trace has its own seed so that a failure repeats on any thread count.
+  int failedTrace = -1;
+  DiffTrace failed;
+  std::string failedWhat;
+#pragma omp parallel
+  {
+    DiffTrace trace;
+    std::string what;
+#pragma omp for schedule(dynamic, 16)
+    for (int traceIdx = 0; traceIdx < numTraces; ++traceIdx)
+    {
+      int stop;
+#pragma omp atomic read
+      stop = failedTrace;
+      if (stop >= 0) { continue; }
+      Rng rng(seed + static_cast<uint64_t>(traceIdx));
+      if (!Differential::RunRandom(rng, maxSteps, &trace, &what))
+      {
+#pragma omp critical(sudokill_diff_failure)
+        {
+          if ((failedTrace < 0) || (traceIdx < failedTrace))
+          {
+            failedTrace = traceIdx;
+            failed = trace;
+            failedWhat = what;
+          }
+        }
+      }
+    }
+  }
+
+  if (failedTrace >= 0)
+  {
+    std::cout << "Trace " << failedTrace << " (seed " << (seed + failedTrace)
+              << ") diverged after " << failed.steps.size() << " steps: "
+              << failedWhat << std::endl;
+    Differential::Shrink(&failed);
+    Differential::Replay(failed, &failedWhat);
+    std::cout << "Shrunk to " << failed.presets.size() << " presets and "
+              << failed.steps.size() << " steps: " << failedWhat << std::endl;
+    Differential::Print(failed, std::cout);
+    return 1;
+  }
+  std::cout << numTraces << " traces agree (" << timer.GetTime() << " s)." << std::endl;
+  return 0;
+}
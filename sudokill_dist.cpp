@@ -0,0 +1,239 @@
+#include "sudokill_core.h"
+#include "board_parser.h"
+#include "distributed.h"
+#include "eval_weights.h"
+#include "timer.h"
+#include "log.h"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+
+using namespace hps;
+
+/// <summary> sudokill_dist command line arguments. </summary>
+struct CommandLineArgs
+{
+  CommandLineArgs()
+  : worker(false), listenAddress(), numThreads(0), workerAddresses(), maxDepth(11),
+    timeLimitSec(0.0), weightsFile(), inputFiles()
+  {}
+  bool worker;
+  std::string listenAddress;
+  /// <summary> Search threads of a worker; 0 is one per CPU. </summary>
+  int numThreads;
+  std::vector<std::string> workerAddresses;
+  int maxDepth;
+  /// <summary> Per position; 0 is no limit. </summary>
+  double timeLimitSec;
+  std::string weightsFile;
+  /// <summary> Read in order; stdin when empty. </summary>
+  std::vector<std::string> inputFiles;
+};
+
+inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
+{
+  assert(args);
+  if (argc < 2)
+  {
+    return false;
+  }
+  const std::string mode(argv[1]);
+  if (("worker" == mode) && (argc >= 3))
+  {
+    args->worker = true;
+    args->listenAddress = argv[2];
+    for (int argIdx = 3; argIdx < argc; ++argIdx)
+    {
+      const std::string arg(argv[argIdx]);
+      if (("--threads" == arg) && (argIdx + 1 < argc))
+      {
+        args->numThreads = atoi(argv[++argIdx]);
+        if (args->numThreads < 0) { return false; }
+      }
+      else
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  if ("master" != mode)
+  {
+    return false;
+  }
+  for (int argIdx = 2; argIdx < argc; ++argIdx)
+  {
+    const std::string arg(argv[argIdx]);
+    if (("--worker" == arg) && (argIdx + 1 < argc))
+    {
+      args->workerAddresses.push_back(argv[++argIdx]);
+    }
+    else if (("--depth" == arg) && (argIdx + 1 < argc))
+    {
+      args->maxDepth = atoi(argv[++argIdx]);
+      if (args->maxDepth < 2) { return false; }
+    }
+    else if (("--time" == arg) && (argIdx + 1 < argc))
+    {
+      args->timeLimitSec = atof(argv[++argIdx]);
+      if (args->timeLimitSec < 0.0) { return false; }
+    }
+    else if (("--weights" == arg) && (argIdx + 1 < argc))
+    {
+      args->weightsFile = argv[++argIdx];
+    }
+    else if ((0 == arg.compare(0, 2, "--")) && ("--" != arg))
+    {
+      return false;
+    }
+    else
+    {
+      args->inputFiles.push_back(arg);
+    }
+  }
+  return !args->workerAddresses.empty();
+}
+
+/// <summary> Serve masters one after another, forever. </summary>
+int RunWorker(const CommandLineArgs& args)
+{
+  const int listenFd = DistributedProtocol::Listen(args.listenAddress);
+  if (listenFd < 0)
+  {
+    std::cerr << "ERROR: cannot listen on " << args.listenAddress << "." << std::endl;
+    return 1;
+  }
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = args.numThreads;
+  DistributedWorker worker(poolOptions);
+  std::cerr << "Listening on " << args.listenAddress << "." << std::endl;
+  for (;;)
+  {
+    const int fd = DistributedProtocol::Accept(listenFd);
+    if (fd < 0)
+    {
+      std::cerr << "ERROR: cannot accept a master." << std::endl;
+      close(listenFd);
+      return 1;
+    }
+    std::cerr << "Master connected." << std::endl;
+    const bool ok = worker.Serve(fd);
+    std::cerr << "Master " << (ok ? "disconnected." : "broke the protocol.") << std::endl;
+  }
+}
+
+/// <summary> One line per position, as the workers search it. </summary>
+int RunMaster(const CommandLineArgs& args)
+{
+  EvalWeights weights;
+  if (!args.weightsFile.empty() && !weights.Load(args.weightsFile))
+  {
+    std::cerr << "ERROR: cannot load weights " << args.weightsFile << "." << std::endl;
+    return 1;
+  }
+  DistributedSearch search(weights);
+  for (size_t workerIdx = 0; workerIdx < args.workerAddresses.size(); ++workerIdx)
+  {
+    const std::string& address = args.workerAddresses[workerIdx];
+    if (!search.AddWorker(DistributedProtocol::Connect(address)))
+    {
+      std::cerr << "ERROR: cannot connect to worker " << address << "." << std::endl;
+      return 1;
+    }
+  }
+  std::vector<std::string> inputFiles = args.inputFiles;
+  if (inputFiles.empty())
+  {
+    inputFiles.push_back("-");
+  }
+  size_t positions = 0;
+  long long nodes = 0;
+  Timer timer;
+  for (size_t fileIdx = 0; fileIdx < inputFiles.size(); ++fileIdx)
+  {
+    const std::string& path = inputFiles[fileIdx];
+    std::ifstream file;
+    if ("-" != path)
+    {
+      file.open(path.c_str());
+      if (!file.good())
+      {
+        std::cerr << "ERROR: cannot read " << path << "." << std::endl;
+        return 1;
+      }
+    }
+    std::istream& in = ("-" != path) ? file : std::cin;
+    std::string stateString;
+    while (Parser::ReadStateString(in, &stateString))
+    {
+      Board board;
+      if (!Parser::Parse(stateString, &board))
+      {
+        std::cerr << "ERROR: bad state in " << path << " at position "
+                  << positions << "." << std::endl;
+        return 1;
+      }
+      stateString.clear();
+      const int depth = AlphaBetaPruning::DepthCap(board, args.maxDepth);
+      Timer positionTimer;
+      DistributedSearch::Result result;
+      std::cout << "position " << positions;
+      if (search.Search(board, depth, args.timeLimitSec, &result))
+      {
+        std::cout << " depth " << depth << " seldepth " << result.selDepth
+                  << " nodes " << result.nodes << " time " << positionTimer.GetTime()
+                  << (result.complete ? "" : " partial") << " score ";
+        Parser::PrintScore(std::cout, result.score);
+        std::cout << " move " << result.move.location.x << " " << result.move.location.y
+                  << " " << result.move.value << "\n";
+        nodes += result.nodes;
+      }
+      else
+      {
+        std::cout << ((0 == search.Workers()) ? " no workers" : " no moves") << "\n";
+      }
+      std::cout.flush();
+      ++positions;
+      if (0 == search.Workers())
+      {
+        std::cerr << "ERROR: lost every worker." << std::endl;
+        return 1;
+      }
+    }
+  }
+  const double seconds = timer.GetTime();
+  std::cerr << "Searched " << positions << " positions in " << seconds << " s ("
+            << ((seconds > 0.0) ? (nodes / seconds) : 0.0) << " nodes/sec) on "
+            << search.Workers() << " workers." << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  // Keep warnings off the result lines.
+  Logger::Get().SetSink(&std::cerr);
+  CommandLineArgs args;
+  if (!ExtractArgs(argc, argv, &args))
+  {
+    std::cerr << "Usage: " << argv[0] << " worker ADDRESS [--threads N]" << std::endl
+              << "       " << argv[0]
+              << " master --worker ADDRESS [--worker ADDRESS...] [--depth D]"
+              << " [--time SEC] [--weights FILE] [FILE...]" << std::endl
+              << "  A worker listens on ADDRESS, unix:PATH or [HOST:]PORT, and searches"
+              << " the root plys its master sends on N threads (default one per CPU)."
+              << std::endl
+              << "  A master reads game states between " << Parser::StateStringBegin()
+              << " and " << Parser::StateStringEnd()
+              << " from the files, or stdin, splits the root plys of each among the"
+              << " workers, and prints the best move." << std::endl
+              << "  --depth D is the search depth, at least 2 (default 11)." << std::endl
+              << "  --time SEC stops the workers after SEC seconds per position and"
+              << " drops those that do not answer within "
+              << DistributedSearch::StopGraceMs << " ms (default no limit)." << std::endl
+              << "  --weights FILE evaluates with the weights in FILE." << std::endl;
+    return 1;
+  }
+  return args.worker ? RunWorker(args) : RunMaster(args);
+}
@@ -1,6 +1,30 @@
 #include "sudokill_core_gtest.h"
+#include "candidate_masks_gtest.h"
+#include "propagation_gtest.h"
+#include "evaluation_gtest.h"
+#include "eval_cache_gtest.h"
+#include "nnue_gtest.h"
+#include "eval_weights_gtest.h"
+#include "game_record_gtest.h"
+#include "time_manager_gtest.h"
+#include "alphabetapruning_gtest.h"
+#include "compact_board_gtest.h"
+#include "perft_gtest.h"
+#include "differential_gtest.h"
+#include "trace_gtest.h"
+#include "perf_counters_gtest.h"
+#include "log_gtest.h"
+#include "thread_pool_gtest.h"
 #include "board_parser_gtest.h"
 #include "player_gtest.h"
+#include "tuner_gtest.h"
+#include "analysis_gtest.h"
+#include "engine_gtest.h"
+#include "sudokill_c_gtest.h"
+#ifndef WIN32
+#include "distributed_gtest.h"
+#endif
+#include "rand_bound_gtest.h"
 #include "gtest/gtest.h"
 #ifdef WIN32
 #include <time.h>
@@ -16,7 +40,7 @@ int main(int argc, char** argv)
   //const unsigned int randSeed = 1319414691;
   //const unsigned int randSeed = 1319433120;
   std::cout << "Random seed: " << randSeed << "." << std::endl;
-  srand(randSeed);
+  hps::math::SeedRng(randSeed);
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_catch_exceptions = false;
   return RUN_ALL_TESTS();
@@ -0,0 +1,49 @@
+#ifndef _HPS_SUDOKILL_GTEST_UTIL_H_
+#define _HPS_SUDOKILL_GTEST_UTIL_H_
+
+#include "sudokill_core.h"
+#include "rand_bound.h"
+
+namespace hps
+{
+namespace sudokill_gtest
+{
+
+/// <summary> A position numMoves into a fixed game, which plays the
+///   (moveIdx * stride)th valid move in turn, or fewer if the game ends.
+/// </summary>
+inline Board Position(const int numMoves, const int stride)
+{
+  Board board;
+  Board::MoveList plys;
+  for (int moveIdx = 0; moveIdx < numMoves; ++moveIdx)
+  {
+    board.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      break;
+    }
+    board.PlayMove(plys[(moveIdx * stride) % plys.size()]);
+  }
+  return board;
+}
+
+/// <summary> Play random valid moves until none remain or count hit. </summary>
+inline void PlayRandomMoves(const int count, Board* board)
+{
+  Board::MoveList moves;
+  for (int i = 0; i < count; ++i)
+  {
+    board->ValidMoves(&moves);
+    if (moves.empty())
+    {
+      break;
+    }
+    board->PlayMove(moves[RandBound(static_cast<int>(moves.size()))]);
+  }
+}
+
+}
+}
+
+#endif //_HPS_SUDOKILL_GTEST_UTIL_H_
@@ -0,0 +1,227 @@
+#include "sudokill_core.h"
+#include "board_parser.h"
+#include "perft.h"
+#include "alphabetapruning.h"
+#include "evaluation.h"
+#include "eval_cache.h"
+#include "nnue.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdlib.h>
+
+using namespace hps;
+
+/// <summary> sudokill_perft command line arguments. </summary>
+struct CommandLineArgs
+{
+  CommandLineArgs()
+  : depth(0), divide(false), search(false), threads(0), evalCacheMb(0), nnueFile(),
+    stateFile()
+  {}
+  int depth;
+  bool divide;
+  bool search;
+  int threads;
+  int evalCacheMb;
+  std::string nnueFile;
+  std::string stateFile;
+};
+
+inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
+{
+  assert(args);
+  for (int argIdx = 1; argIdx < argc; ++argIdx)
+  {
+    const std::string arg(argv[argIdx]);
+    if ("--divide" == arg)
+    {
+      args->divide = true;
+    }
+    else if ("--search" == arg)
+    {
+      args->search = true;
+    }
+    else if (("--threads" == arg) && (argIdx + 1 < argc))
+    {
+      args->threads = atoi(argv[++argIdx]);
+    }
+    else if (("--eval-cache" == arg) && (argIdx + 1 < argc))
+    {
+      args->evalCacheMb = atoi(argv[++argIdx]);
+    }
+    else if (("--nnue" == arg) && (argIdx + 1 < argc))
+    {
+      args->nnueFile = argv[++argIdx];
+    }
+    else if (0 == args->depth)
+    {
+      args->depth = atoi(arg.c_str());
+      if (args->depth < 1) { return false; }
+    }
+    else if (args->stateFile.empty())
+    {
+      args->stateFile = arg;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return args->depth > 0;
+}
+
+/// <summary> Time one search with the evaluator, behind a cache if asked. </summary>
+template <typename BoardEvaulationFunction>
+int TimedSearch(const CommandLineArgs& args,
+                const BoardEvaulationFunction& f,
+                AlphaBetaPruning::Params* params,
+                Board* board,
+                Cell* ply,
+                PerfCounters* counters,
+                PerfCounters::Sample* sample)
+{
+  int minimax;
+  if (args.evalCacheMb > 0)
+  {
+    EvalCache cache(static_cast<size_t>(args.evalCacheMb) << 20);
+    CachedEvaluationFunc<BoardEvaulationFunction> cached(f, &cache);
+    counters->Start();
+    minimax = AlphaBetaPruning::Run(params, board, &cached, ply);
+    counters->Stop(sample);
+    std::cout << "eval cache: " << cache.Size() << " entries, " << cache.Hits()
+              << " hits, " << cache.Misses() << " misses\n";
+  }
+  else
+  {
+    counters->Start();
+    minimax = AlphaBetaPruning::Run(params, board, &f, ply);
+    counters->Stop(sample);
+  }
+  return minimax;
+}
+
+/// <summary> Read the whole stream. </summary>
+inline std::string ReadAll(std::istream& stream)
+{
+  return std::string(std::istreambuf_iterator<char>(stream),
+                     std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv)
+{
+  CommandLineArgs args;
+  if (!ExtractArgs(argc, argv, &args))
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " DEPTH [--divide | --search] [--threads N] [--eval-cache MB]"
+              << " [--nnue FILE] [STATE_FILE]" << std::endl
+              << "  Reads a state string (MOVE START ... MOVE END) from"
+              << " STATE_FILE or stdin." << std::endl
+              << "  Empty input is the empty board." << std::endl
+              << "  --search times an alpha-beta search to DEPTH instead"
+              << " of perft." << std::endl
+              << "  --threads N sets the perft or search threads (default"
+              << " one per CPU)." << std::endl
+              << "  --eval-cache MB puts an MB evaluation cache in front of"
+              << " the search's evaluator." << std::endl
+              << "  --nnue FILE makes the search evaluate with the network"
+              << " in FILE." << std::endl;
+    return 1;
+  }
+
+  // Load the position.
+  std::string stateString;
+  if (args.stateFile.empty())
+  {
+    stateString = ReadAll(std::cin);
+  }
+  else
+  {
+    std::ifstream stateFile(args.stateFile.c_str());
+    if (!stateFile.good())
+    {
+      std::cerr << "ERROR: cannot open " << args.stateFile << "." << std::endl;
+      return 1;
+    }
+    stateString = ReadAll(stateFile);
+  }
+  Board board;
+  if ((std::string::npos != stateString.find(Parser::StateStringBegin())) &&
+      !Parser::Parse(stateString, &board))
+  {
+    std::cerr << "ERROR: malformed state string." << std::endl;
+    return 1;
+  }
+
+  // Open the counters before any thread pool starts so they include it.
+  PerfCounters counters;
+  PerfCounters::Sample sample;
+  if (args.search)
+  {
+    if (args.depth < 2)
+    {
+      std::cerr << "ERROR: search DEPTH must be at least 2." << std::endl;
+      return 1;
+    }
+    ThreadPool::Options poolOptions;
+    poolOptions.numThreads = args.threads;
+    ThreadPool::ConfigureSearch(poolOptions);
+    // Start the pool outside of the measurement.
+    ThreadPool::Search();
+    AlphaBetaPruning::Params params;
+    params.maxDepth = args.depth;
+    Cell ply;
+    int minimax;
+    NnueNetwork network;
+    if (!args.nnueFile.empty())
+    {
+      if (!network.Load(args.nnueFile))
+      {
+        std::cerr << "ERROR: cannot load network " << args.nnueFile << "." << std::endl;
+        return 1;
+      }
+      board.AttachNetwork(&network);
+      const NnueEvaluationFunc f(board.GetPlayerMovesCount());
+      minimax = TimedSearch(args, f, &params, &board, &ply, &counters, &sample);
+    }
+    else
+    {
+      const ShrinkPossibleMovesEvaluationFunc f;
+      minimax = TimedSearch(args, f, &params, &board, &ply, &counters, &sample);
+    }
+    std::cout << "search(" << args.depth << ") = " << ply.location.x << " "
+              << ply.location.y << " " << ply.value << " (minimax "
+              << minimax << ", " << params.nodes << " nodes, selective depth "
+              << params.selDepth << ")\n";
+    PerfCounters::Print(sample, params.nodes, "node", std::cout);
+    std::cout.flush();
+    return 0;
+  }
+
+  std::vector<Perft::DivideEntry> entries;
+  counters.Start();
+  const uint64_t nodes = Perft::Divide(board, args.depth, args.threads, &entries);
+  counters.Stop(&sample);
+  const double seconds = sample.seconds;
+  if (args.divide)
+  {
+    for (size_t entryIdx = 0; entryIdx < entries.size(); ++entryIdx)
+    {
+      const Perft::DivideEntry& entry = entries[entryIdx];
+      std::cout << entry.ply.location.x << " " << entry.ply.location.y << " "
+                << entry.ply.value << ": " << entry.nodes << "\n";
+    }
+  }
+  std::cout << "perft(" << args.depth << ") = " << nodes << "\n"
+            << "nodes/sec: "
+            << ((seconds > 0.0) ? static_cast<double>(nodes) / seconds : 0.0)
+            << "\n";
+  PerfCounters::Print(sample, nodes, "node", std::cout);
+  std::cout.flush();
+  return 0;
+}
@@ -0,0 +1,215 @@
+#include "sudokill_core.h"
+#include "alphabetapruning.h"
+#include "eval_weights.h"
+#include "game_record.h"
+#include "rand_bound.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include <string>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace hps;
+
+/// <summary> sudokill_replay command line arguments. </summary>
+struct CommandLineArgs
+{
+  CommandLineArgs()
+  : recordFile(), depth(0), threads(1), seed(Rng::DefaultSeed), weightsFile(),
+    outFile(), first(0), count(0), quiet(false)
+  {}
+  std::string recordFile;
+  int depth;
+  int threads;
+  uint64_t seed;
+  std::string weightsFile;
+  std::string outFile;
+  size_t first;
+  size_t count;
+  bool quiet;
+};
+
+inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
+{
+  assert(args);
+  for (int argIdx = 1; argIdx < argc; ++argIdx)
+  {
+    const std::string arg(argv[argIdx]);
+    if (("--depth" == arg) && (argIdx + 1 < argc))
+    {
+      args->depth = atoi(argv[++argIdx]);
+      if (args->depth < 2) { return false; }
+    }
+    else if (("--threads" == arg) && (argIdx + 1 < argc))
+    {
+      args->threads = atoi(argv[++argIdx]);
+      if (args->threads < 1) { return false; }
+    }
+    else if (("--seed" == arg) && (argIdx + 1 < argc))
+    {
+      args->seed = strtoull(argv[++argIdx], NULL, 10);
+    }
+    else if (("--weights" == arg) && (argIdx + 1 < argc))
+    {
+      args->weightsFile = argv[++argIdx];
+    }
+    else if (("--out" == arg) && (argIdx + 1 < argc))
+    {
+      args->outFile = argv[++argIdx];
+    }
+    else if (("--first" == arg) && (argIdx + 1 < argc))
+    {
+      args->first = static_cast<size_t>(atol(argv[++argIdx]));
+    }
+    else if (("--count" == arg) && (argIdx + 1 < argc))
+    {
+      args->count = static_cast<size_t>(atol(argv[++argIdx]));
+    }
+    else if ("--quiet" == arg)
+    {
+      args->quiet = true;
+    }
+    else if (args->recordFile.empty())
+    {
+      args->recordFile = arg;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return !args->recordFile.empty();
+}
+
+int main(int argc, char** argv)
+{
+  CommandLineArgs args;
+  if (!ExtractArgs(argc, argv, &args))
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " RECORD_FILE [--depth D] [--threads N] [--seed S] [--weights FILE]"
+              << " [--first I] [--count N] [--out FILE] [--quiet]" << std::endl
+              << "  Searches the recorded positions again and compares with the"
+              << " recorded moves." << std::endl
+              << "  --depth D searches to depth D instead of each record's depth."
+              << std::endl
+              << "  --threads N searches on N threads (default 1, which is"
+              << " repeatable)." << std::endl
+              << "  --seed S seeds the random numbers of each position with S"
+              << " plus its index." << std::endl
+              << "  --weights FILE evaluates with the weights in FILE." << std::endl
+              << "  --out FILE records the replayed moves, to compare runs."
+              << std::endl;
+    return 1;
+  }
+
+  GameRecordFile records;
+  if (!records.Open(args.recordFile))
+  {
+    std::cerr << "ERROR: cannot read game record " << args.recordFile << "." << std::endl;
+    return 1;
+  }
+  EvalWeights weights;
+  if (!args.weightsFile.empty() && !weights.Load(args.weightsFile))
+  {
+    std::cerr << "ERROR: cannot load weights " << args.weightsFile << "." << std::endl;
+    return 1;
+  }
+  GameRecorder out;
+  if (!args.outFile.empty() && !out.Open(args.outFile))
+  {
+    std::cerr << "ERROR: cannot open game record " << args.outFile << "." << std::endl;
+    return 1;
+  }
+  ThreadPool::Options poolOptions;
+  poolOptions.numThreads = args.threads;
+  ThreadPool pool(poolOptions);
+
+  const size_t last = (0 == args.count) ? records.Size() :
+                      std::min(records.Size(), args.first + args.count);
+  size_t replayed = 0;
+  size_t sameMoves = 0;
+  size_t sameScores = 0;
+  double recordedSec = 0.0;
+  double replaySec = 0.0;
+  uint64_t recordedNodes = 0;
+  uint64_t replayNodes = 0;
+  for (size_t recordIdx = args.first; recordIdx < last; ++recordIdx)
+  {
+    GameRecord record;
+    if (!records.Get(recordIdx, &record))
+    {
+      std::cerr << "ERROR: record " << recordIdx << " is corrupt." << std::endl;
+      return 1;
+    }
+    // Random moves have nothing to compare.
+    if (record.flags & GameRecord::Flag_Random)
+    {
+      continue;
+    }
+    Board board;
+    record.ToBoard(&board);
+    Board::MoveList plys;
+    board.ValidMoves(&plys);
+    if (plys.empty())
+    {
+      continue;
+    }
+    SeedRng(args.seed + recordIdx);
+    AlphaBetaPruning::Params params;
+    params.maxDepth = (args.depth > 0) ? args.depth : std::max<int>(record.depth, 2);
+    params.pool = &pool;
+    const WeightedEvaluationFunc f(weights, board.GetPlayerMovesCount());
+    Cell ply;
+    Timer timer;
+    const int minimax = AlphaBetaPruning::Run(&params, &board, &f, &ply);
+    const double seconds = timer.GetTime();
+
+    const bool sameMove = ply == record.GetMove();
+    const bool sameScore = minimax == record.score;
+    ++replayed;
+    sameMoves += sameMove ? 1 : 0;
+    sameScores += sameScore ? 1 : 0;
+    recordedSec += record.latencyUs * 1e-6;
+    replaySec += seconds;
+    recordedNodes += record.nodes;
+    replayNodes += static_cast<uint64_t>(params.nodes);
+    if (!args.quiet)
+    {
+      const Cell recorded = record.GetMove();
+      std::cout << recordIdx << ": game " << record.game << " round " << record.round
+                << " depth " << params.maxDepth
+                << " recorded " << recorded.location.x << " " << recorded.location.y
+                << " " << recorded.value << " (" << record.score << ", "
+                << record.nodes << " nodes, " << (record.latencyUs * 1e-3) << " ms)"
+                << " replay " << ply.location.x << " " << ply.location.y << " "
+                << ply.value << " (" << minimax << ", " << params.nodes << " nodes, "
+                << (seconds * 1e3) << " ms)" << (sameMove ? "" : " MOVE DIFFERS")
+                << "\n";
+    }
+    if (out.IsOpen())
+    {
+      GameRecord replay = record;
+      replay.SetMove(ply);
+      replay.depth = static_cast<uint8_t>(params.maxDepth);
+      replay.selDepth = static_cast<uint8_t>(params.selDepth);
+      replay.score = minimax;
+      replay.nodes = static_cast<uint64_t>(params.nodes);
+      replay.latencyUs = static_cast<uint32_t>(seconds * 1e6);
+      replay.flags = params.complete ? GameRecord::Flag_Complete : 0;
+      if (!out.Append(replay))
+      {
+        std::cerr << "ERROR: cannot write game record " << args.outFile << "." << std::endl;
+        return 1;
+      }
+    }
+  }
+  std::cout << "replayed " << replayed << " of " << records.Size() << " records: "
+            << sameMoves << " same moves, " << sameScores << " same scores\n"
+            << "recorded: " << recordedSec << " s, " << recordedNodes << " nodes\n"
+            << "replay: " << replaySec << " s, " << replayNodes << " nodes, "
+            << ((replaySec > 0.0) ? static_cast<double>(replayNodes) / replaySec : 0.0)
+            << " nodes/sec\n";
+  std::cout.flush();
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include "eval_weights.h"
+#include "tuner.h"
+#include "timer.h"
+#include <string>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace hps;
+
+/// <summary> sudokill_tune command line arguments. </summary>
+struct CommandLineArgs
+{
+  CommandLineArgs()
+  : iterations(0), pairs(32), depth(3), threads(0), seed(Rng::DefaultSeed),
+    startFile(), outFile("sudokill.weights")
+  {}
+  int iterations;
+  int pairs;
+  int depth;
+  int threads;
+  uint64_t seed;
+  std::string startFile;
+  std::string outFile;
+};
+
+inline bool ExtractArgs(const int argc, char** argv, CommandLineArgs* args)
+{
+  assert(args);
+  for (int argIdx = 1; argIdx < argc; ++argIdx)
+  {
+    const std::string arg(argv[argIdx]);
+    if (("--pairs" == arg) && (argIdx + 1 < argc))
+    {
+      args->pairs = atoi(argv[++argIdx]);
+      if (args->pairs < 1) { return false; }
+    }
+    else if (("--depth" == arg) && (argIdx + 1 < argc))
+    {
+      args->depth = atoi(argv[++argIdx]);
+      if (args->depth < 2) { return false; }
+    }
+    else if (("--threads" == arg) && (argIdx + 1 < argc))
+    {
+      args->threads = atoi(argv[++argIdx]);
+    }
+    else if (("--seed" == arg) && (argIdx + 1 < argc))
+    {
+      args->seed = strtoull(argv[++argIdx], NULL, 10);
+    }
+    else if (("--start" == arg) && (argIdx + 1 < argc))
+    {
+      args->startFile = argv[++argIdx];
+    }
+    else if (("--out" == arg) && (argIdx + 1 < argc))
+    {
+      args->outFile = argv[++argIdx];
+    }
+    else if (0 == args->iterations)
+    {
+      args->iterations = atoi(arg.c_str());
+      if (args->iterations < 1) { return false; }
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return args->iterations > 0;
+}
+
+int main(int argc, char** argv)
+{
+  CommandLineArgs args;
+  if (!ExtractArgs(argc, argv, &args))
+  {
+    std::cerr << "Usage: " << argv[0]
+              << " ITERATIONS [--pairs N] [--depth D] [--threads N] [--seed S]"
+              << " [--start FILE] [--out FILE]" << std::endl
+              << "  Tunes the evaluation weights by SPSA over self-play." << std::endl
+              << "  --pairs N plays N pairs of games per iteration (default 32)."
+              << std::endl
+              << "  --depth D searches every move to depth D (default 3)." << std::endl
+              << "  --threads N plays N games at once (default one per CPU)."
+              << std::endl
+              << "  --start FILE starts from the weights in FILE instead of the"
+              << " defaults." << std::endl
+              << "  --out FILE writes the weights to FILE after every iteration"
+              << " (default sudokill.weights); play with them through"
+              << " SUDOKILL_WEIGHTS=FILE." << std::endl;
+    return 1;
+  }
+
+  EvalWeights start;
+  if (!args.startFile.empty() && !start.Load(args.startFile))
+  {
+    std::cerr << "ERROR: cannot load weights " << args.startFile << "." << std::endl;
+    return 1;
+  }
+  SelfPlay::Options selfPlayOptions;
+  selfPlayOptions.depth = args.depth;
+  selfPlayOptions.numThreads = args.threads;
+  SelfPlay selfPlay(selfPlayOptions);
+  std::cout << "Tuning with " << selfPlay.Threads() << " threads." << std::endl;
+
+  Spsa::Options spsaOptions;
+  spsaOptions.pairsPerIteration = args.pairs;
+  spsaOptions.seed = args.seed;
+  Spsa spsa(spsaOptions, &selfPlay, start);
+  const EvalWeights::Field* fields = EvalWeights::Fields();
+  Timer timer;
+  while (spsa.Iteration() < args.iterations)
+  {
+    const double score = spsa.Step();
+    const EvalWeights weights = spsa.Weights();
+    std::cout << "iteration " << spsa.Iteration() << ": score " << score;
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      std::cout << " " << fields[fieldIdx].name << "=" << weights.*(fields[fieldIdx].member);
+    }
+    std::cout << std::endl;
+    // Write every iteration so that a stopped run leaves its weights.
+    if (!weights.Save(args.outFile))
+    {
+      std::cerr << "ERROR: cannot write weights " << args.outFile << "." << std::endl;
+      return 1;
+    }
+  }
+  std::cout << args.iterations << " iterations of " << (2 * args.pairs)
+            << " games in " << timer.GetTime() << " s." << std::endl;
+  return 0;
+}
@@ -0,0 +1,386 @@
+#ifndef _HPS_UTIL_THREAD_POOL_H_
+#define _HPS_UTIL_THREAD_POOL_H_
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace hps
+{
+namespace util
+{
+
+/// <summary> A fixed team of worker threads that park between jobs. </summary>
+/// <remarks>
+///   <para> Run() wakes every worker with the job and blocks until all have
+///     returned, so a job is a parallel region like an OpenMP team's. Workers
+///     wait on a condition variable between jobs; they neither spin nor
+///     exit. Only one thread may call Run() at a time.
+///   </para>
+///   <para> On Linux the workers may be pinned, one per allowed CPU in
+///     ascending order, optionally using only the first hardware thread of
+///     each core. Pinning happens before a worker runs any job, so memory a
+///     worker touches first is allocated on its NUMA node by the kernel's
+///     default first-touch policy.
+///   </para>
+/// </remarks>
+class ThreadPool
+{
+public:
+  struct Options
+  {
+    Options() : numThreads(0), pin(false), avoidSmt(false) {}
+    /// <summary> Worker count; 0 is one per usable CPU. </summary>
+    int numThreads;
+    /// <summary> Bind each worker to one CPU. </summary>
+    bool pin;
+    /// <summary> Use one hardware thread per core. </summary>
+    bool avoidSmt;
+  };
+
+  explicit ThreadPool(const Options& options_ = Options())
+  : options(options_),
+    cpus(UsableCpus(options_.avoidSmt)),
+    workers(),
+    lock(),
+    wake(),
+    done(),
+    jobFunc(NULL),
+    jobContext(NULL),
+    generation(0),
+    running(0),
+    stop(false)
+  {
+    int numThreads = options.numThreads;
+    if (numThreads <= 0)
+    {
+      numThreads = cpus.empty() ? static_cast<int>(std::thread::hardware_concurrency())
+                                : static_cast<int>(cpus.size());
+      numThreads = (numThreads > 0) ? numThreads : 1;
+    }
+    for (int workerIdx = 0; workerIdx < numThreads; ++workerIdx)
+    {
+      workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, workerIdx));
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
+    }
+    wake.notify_all();
+    for (size_t workerIdx = 0; workerIdx < workers.size(); ++workerIdx)
+    {
+      workers[workerIdx].join();
+    }
+  }
+
+  inline int Size() const
+  {
+    return static_cast<int>(workers.size());
+  }
+
+  /// <summary> CPU of a pinned worker, or -1. </summary>
+  inline int WorkerCpu(const int workerIdx) const
+  {
+    if (!options.pin || cpus.empty())
+    {
+      return -1;
+    }
+    return cpus[workerIdx % cpus.size()];
+  }
+
+  /// <summary> Call (*job)(workerIdx) on every worker and wait for all. </summary>
+  template <typename Job>
+  void Run(Job* job)
+  {
+    assert(job);
+    std::unique_lock<std::mutex> guard(lock);
+    assert((0 == running) && "ThreadPool::Run() is not reentrant.");
+    jobFunc = &CallJob<Job>;
+    jobContext = job;
+    running = Size();
+    ++generation;
+    wake.notify_all();
+    done.wait(guard, [this] { return 0 == running; });
+    jobFunc = NULL;
+    jobContext = NULL;
+  }
+
+  /// <summary> Set the options of the search pool. Call before the first
+  ///   Search(); later calls have no effect.
+  /// </summary>
+  static void ConfigureSearch(const Options& searchOptions)
+  {
+    SearchOptions() = searchOptions;
+  }
+
+  /// <summary> The process's search pool, created on first use. </summary>
+  static ThreadPool& Search()
+  {
+    static ThreadPool s_search(SearchOptions());
+    return s_search;
+  }
+
+private:
+  typedef void (*JobFunc)(void*, int);
+
+  ThreadPool(const ThreadPool&);
+  ThreadPool& operator=(const ThreadPool&);
+
+  template <typename Job>
+  static void CallJob(void* job, const int workerIdx)
+  {
+    (*static_cast<Job*>(job))(workerIdx);
+  }
+
+  static Options& SearchOptions()
+  {
+    static Options s_options;
+    return s_options;
+  }
+
+  void WorkerLoop(const int workerIdx)
+  {
+    Pin(WorkerCpu(workerIdx));
+    std::unique_lock<std::mutex> guard(lock);
+    size_t seen = 0;
+    for (;;)
+    {
+      wake.wait(guard, [this, seen] { return stop || (generation != seen); });
+      if (stop)
+      {
+        return;
+      }
+      seen = generation;
+      const JobFunc func = jobFunc;
+      void* context = jobContext;
+      guard.unlock();
+      func(context, workerIdx);
+      guard.lock();
+      if (0 == --running)
+      {
+        done.notify_all();
+      }
+    }
+  }
+
+  static void Pin(const int cpu)
+  {
+#ifdef __linux__
+    if (cpu >= 0)
+    {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(cpu, &cpuSet);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+#else
+    (void)cpu;
+#endif
+  }
+
+  /// <summary> CPUs this process may run on, or empty when unknown. </summary>
+  static std::vector<int> UsableCpus(const bool avoidSmt)
+  {
+    std::vector<int> usable;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (0 != sched_getaffinity(0, sizeof(allowed), &allowed))
+    {
+      return usable;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (!CPU_ISSET(cpu, &allowed))
+      {
+        continue;
+      }
+      // Skip a hardware thread when an allowed sibling comes before it.
+      if (avoidSmt)
+      {
+        const std::vector<int> siblings = Siblings(cpu);
+        bool first = true;
+        for (size_t siblingIdx = 0; siblingIdx < siblings.size(); ++siblingIdx)
+        {
+          const int sibling = siblings[siblingIdx];
+          first = first && !((sibling < cpu) && CPU_ISSET(sibling, &allowed));
+        }
+        if (!first)
+        {
+          continue;
+        }
+      }
+      usable.push_back(cpu);
+    }
+#else
+    (void)avoidSmt;
+#endif
+    return usable;
+  }
+
+#ifdef __linux__
+  /// <summary> Hardware threads sharing a core with the CPU, from sysfs
+  ///   lists such as "0,32" or "0-1".
+  /// </summary>
+  static std::vector<int> Siblings(const int cpu)
+  {
+    std::vector<int> siblings;
+    char path[96];
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    FILE* file = fopen(path, "r");
+    if (NULL == file)
+    {
+      return siblings;
+    }
+    char line[256];
+    const char* pos = fgets(line, sizeof(line), file);
+    fclose(file);
+    while ((NULL != pos) && ('\0' != *pos))
+    {
+      char* end;
+      const int first = static_cast<int>(strtol(pos, &end, 10));
+      if (end == pos)
+      {
+        break;
+      }
+      int last = first;
+      if ('-' == *end)
+      {
+        pos = end + 1;
+        last = static_cast<int>(strtol(pos, &end, 10));
+      }
+      for (int sibling = first; sibling <= last; ++sibling)
+      {
+        siblings.push_back(sibling);
+      }
+      pos = (',' == *end) ? (end + 1) : NULL;
+    }
+    return siblings;
+  }
+#endif
+
+  Options options;
+  std::vector<int> cpus;
+  std::vector<std::thread> workers;
+  std::mutex lock;
+  std::condition_variable wake;
+  std::condition_variable done;
+  JobFunc jobFunc;
+  void* jobContext;
+  size_t generation;
+  int running;
+  bool stop;
+};
+
+/// <summary> Workers that run independent searches side by side, each on a
+///   search pool of its own.
+/// </summary>
+/// <remarks>
+///   <para> A pool runs one search at a time, so searches that run at once
+///     need a pool each. ForEach() hands out the items one at a time, so a
+///     worker with long items simply takes fewer.
+///   </para>
+/// </remarks>
+class SearchTeam
+{
+public:
+  /// <summary> numWorkers of 0 is one per CPU; each searches on
+  ///   threadsPerSearch threads, at least 1.
+  /// </summary>
+  SearchTeam(const int numWorkers, const int threadsPerSearch)
+  : workers(PoolOptions(numWorkers)),
+    searchPools()
+  {
+    const ThreadPool::Options searchOptions = PoolOptions((threadsPerSearch > 0) ?
+                                                          threadsPerSearch : 1);
+    for (int workerIdx = 0; workerIdx < workers.Size(); ++workerIdx)
+    {
+      searchPools.push_back(new ThreadPool(searchOptions));
+    }
+  }
+
+  ~SearchTeam()
+  {
+    for (size_t poolIdx = 0; poolIdx < searchPools.size(); ++poolIdx)
+    {
+      delete searchPools[poolIdx];
+    }
+  }
+
+  inline int Size() const
+  {
+    return workers.Size();
+  }
+
+  /// <summary> Call (*item)(itemIdx, searchPool) for each itemIdx in
+  ///   [0, count), on the worker that owns searchPool, and wait for all.
+  /// </summary>
+  template <typename Item>
+  void ForEach(const int count, Item* item)
+  {
+    assert(item);
+    ForEachJob<Item> job;
+    job.self = this;
+    job.item = item;
+    job.count = count;
+    job.next.store(0);
+    workers.Run(&job);
+  }
+
+private:
+  SearchTeam(const SearchTeam&);
+  SearchTeam& operator=(const SearchTeam&);
+
+  template <typename Item>
+  struct ForEachJob
+  {
+    void operator()(const int workerIdx)
+    {
+      for (;;)
+      {
+        const int itemIdx = next.fetch_add(1);
+        if (itemIdx >= count)
+        {
+          return;
+        }
+        (*item)(itemIdx, self->searchPools[workerIdx]);
+      }
+    }
+
+    SearchTeam* self;
+    Item* item;
+    int count;
+    std::atomic<int> next;
+  };
+
+  static ThreadPool::Options PoolOptions(const int numThreads)
+  {
+    ThreadPool::Options poolOptions;
+    poolOptions.numThreads = numThreads;
+    return poolOptions;
+  }
+
+  ThreadPool workers;
+  std::vector<ThreadPool*> searchPools;
+};
+
+}
+using namespace util;
+}
+
+#endif //_HPS_UTIL_THREAD_POOL_H_
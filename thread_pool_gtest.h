@@ -0,0 +1,113 @@
+#ifndef _HPS_UTIL_THREAD_POOL_GTEST_H_
+#define _HPS_UTIL_THREAD_POOL_GTEST_H_
+
+#include "thread_pool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace _hps_util_thread_pool_gtest_h_
+{
+using namespace hps;
+
+/// <summary> Count calls per worker and note each worker's thread. </summary>
+struct CountJob
+{
+  explicit CountJob(const int numThreads)
+  : calls(numThreads, 0),
+    threads(numThreads),
+    total(0)
+  {}
+
+  void operator()(const int workerIdx)
+  {
+    ++calls[workerIdx];
+    threads[workerIdx] = std::this_thread::get_id();
+    total.fetch_add(1);
+  }
+
+  std::vector<int> calls;
+  std::vector<std::thread::id> threads;
+  std::atomic<int> total;
+};
+
+TEST(ThreadPool, RunsEveryWorkerOnce)
+{
+  ThreadPool::Options options;
+  options.numThreads = 3;
+  ThreadPool pool(options);
+  ASSERT_EQ(3, pool.Size());
+  CountJob first(pool.Size());
+  pool.Run(&first);
+  EXPECT_EQ(3, first.total.load());
+  // Workers persist: the next job runs on the same threads.
+  CountJob second(pool.Size());
+  for (int run = 0; run < 100; ++run)
+  {
+    pool.Run(&second);
+  }
+  EXPECT_EQ(300, second.total.load());
+  for (int workerIdx = 0; workerIdx < pool.Size(); ++workerIdx)
+  {
+    EXPECT_EQ(1, first.calls[workerIdx]);
+    EXPECT_EQ(100, second.calls[workerIdx]);
+    EXPECT_EQ(first.threads[workerIdx], second.threads[workerIdx]);
+    EXPECT_NE(std::this_thread::get_id(), first.threads[workerIdx]);
+  }
+}
+
+TEST(ThreadPool, DefaultSize)
+{
+  ThreadPool pool;
+  EXPECT_GE(pool.Size(), 1);
+  EXPECT_EQ(-1, pool.WorkerCpu(0));
+  EXPECT_GE(ThreadPool::Search().Size(), 1);
+}
+
+TEST(SearchTeam, ForEach)
+{
+  SearchTeam team(3, 2);
+  ASSERT_EQ(3, team.Size());
+  std::vector<ThreadPool*> pools(100, NULL);
+  struct PoolItem
+  {
+    void operator()(const int itemIdx, ThreadPool* pool) { (*pools)[itemIdx] = pool; }
+    std::vector<ThreadPool*>* pools;
+  } item = { &pools, };
+  team.ForEach(static_cast<int>(pools.size()), &item);
+  for (size_t itemIdx = 0; itemIdx < pools.size(); ++itemIdx)
+  {
+    ASSERT_TRUE(NULL != pools[itemIdx]);
+    EXPECT_EQ(2, pools[itemIdx]->Size());
+  }
+  // No items runs nothing.
+  team.ForEach(0, &item);
+}
+
+#ifdef __linux__
+TEST(ThreadPool, Pinning)
+{
+  ThreadPool::Options options;
+  options.pin = true;
+  options.avoidSmt = true;
+  ThreadPool pool(options);
+  ASSERT_GE(pool.Size(), 1);
+  std::vector<int> cpus(pool.Size(), -1);
+  struct CpuJob
+  {
+    void operator()(const int workerIdx) { (*cpus)[workerIdx] = sched_getcpu(); }
+    std::vector<int>* cpus;
+  } job = { &cpus, };
+  pool.Run(&job);
+  for (int workerIdx = 0; workerIdx < pool.Size(); ++workerIdx)
+  {
+    ASSERT_GE(pool.WorkerCpu(workerIdx), 0);
+    EXPECT_EQ(pool.WorkerCpu(workerIdx), cpus[workerIdx]);
+  }
+}
+#endif
+
+}
+
+#endif //_HPS_UTIL_THREAD_POOL_GTEST_H_
@@ -0,0 +1,246 @@
+#ifndef _HPS_SUDOKILL_TIME_MANAGER_H_
+#define _HPS_SUDOKILL_TIME_MANAGER_H_
+#include "timer.h"
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+#include <atomic>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Spread the game clock over the moves of a game. </summary>
+/// <remarks>
+///   <para> Each move gets a soft deadline, after which no new search
+///     iteration should start, and a hard deadline, after which a running
+///     search must stop. The soft budget is the remaining clock divided by the
+///     moves we still expect to make, scaled by the branching factor and by
+///     the instability of the scores between iterations.
+///   </para>
+///   <para> Times are seconds measured from BeginMove(). </para>
+/// </remarks>
+class TimeManager
+{
+public:
+  struct Params
+  {
+    Params()
+      : gameTimeSec(120.0),
+        safetyMarginSec(5.0),
+        minMoveTimeSec(0.005),
+        maxMoveFraction(0.2),
+        hardFactor(4.0),
+        typicalBranching(24),
+        instabilityBonus(0.5),
+        panicTimeSec(1.0)
+    {}
+
+    /// <summary> Total thinking time for the game. </summary>
+    double gameTimeSec;
+    /// <summary> Clock kept in reserve for I/O and latency. </summary>
+    double safetyMarginSec;
+    /// <summary> Smallest soft budget for a move. </summary>
+    double minMoveTimeSec;
+    /// <summary> Most of the remaining clock one move may use. </summary>
+    double maxMoveFraction;
+    /// <summary> Hard deadline as a multiple of the soft budget. </summary>
+    double hardFactor;
+    /// <summary> Branching factor that gets an unscaled budget. </summary>
+    int typicalBranching;
+    /// <summary> Soft budget extension per unstable iteration. </summary>
+    double instabilityBonus;
+    /// <summary> Below this much clock every move is an emergency. </summary>
+    double panicTimeSec;
+  };
+
+  TimeManager()
+    : params(),
+      timeUsed(0.0),
+      moveTimer(),
+      softDeadline(0.0),
+      hardDeadline(0.0),
+      baseSoftDeadline(0.0),
+      iterations(0),
+      lastScore(0),
+      lastIterationEnd(0.0),
+      lastIterationTime(0.0),
+      prevIterationTime(0.0),
+      emergency(false),
+      moveActive(false),
+      sharers(1)
+  {}
+
+  /// <summary> Reset the clock for a new game. </summary>
+  inline void NewGame()
+  {
+    timeUsed = 0.0;
+    moveActive = false;
+  }
+
+  /// <summary> Start the clock for a move and allocate its budget. </summary>
+  /// <param name="emptyCells"> Empty cells on the board. </param>
+  /// <param name="branching"> Number of legal moves at the root. </param>
+  void BeginMove(const int emptyCells, const int branching)
+  {
+    assert(!moveActive);
+    moveTimer.Reset();
+    moveActive = true;
+    iterations = 0;
+    lastScore = 0;
+    lastIterationEnd = 0.0;
+    lastIterationTime = 0.0;
+    prevIterationTime = 0.0;
+    Allocate(emptyCells, branching, Remaining());
+  }
+
+  /// <summary> Stop the clock for the current move. </summary>
+  inline void EndMove()
+  {
+    assert(moveActive);
+    timeUsed += moveTimer.GetTime();
+    moveActive = false;
+  }
+
+  /// <summary> Charge clock spent between moves, such as a turn that waited
+  ///   for an engine shared with other games.
+  /// </summary>
+  inline void ChargeWait(const double seconds)
+  {
+    assert(!moveActive && (seconds >= 0.0));
+    timeUsed += seconds;
+  }
+
+  /// <summary> Set how many games wait on the engine, this one included.
+  ///   Each move then takes its share of the budget, so that the games
+  ///   searched after it do not wait through full budgets.
+  /// </summary>
+  inline void ShareEngine(const int games)
+  {
+    assert(games >= 1);
+    sharers = games;
+  }
+
+  /// <summary> Record a finished search iteration. </summary>
+  void IterationComplete(const int score)
+  {
+    const double now = Elapsed();
+    IterationComplete(score, now - lastIterationEnd);
+    lastIterationEnd = now;
+  }
+
+  /// <summary> Record a finished iteration that took the given time. </summary>
+  void IterationComplete(const int score, const double iterationTime)
+  {
+    // A changed best score means the deeper search disagrees; give it time.
+    if ((iterations > 0) && (score != lastScore))
+    {
+      softDeadline = std::min(softDeadline +
+                                (params.instabilityBonus * baseSoftDeadline),
+                              hardDeadline);
+    }
+    ++iterations;
+    lastScore = score;
+    prevIterationTime = lastIterationTime;
+    lastIterationTime = iterationTime;
+  }
+
+  /// <summary> Predict if another iteration finishes before the soft
+  ///   deadline.
+  /// </summary>
+  inline bool StartNextIteration() const
+  {
+    return StartNextIteration(Elapsed());
+  }
+
+  bool StartNextIteration(const double elapsed) const
+  {
+    if (Emergency() || (elapsed >= softDeadline))
+    {
+      return false;
+    }
+    // Each extra ply costs about the ratio of the last two iterations.
+    double growth = static_cast<double>(params.typicalBranching);
+    if (prevIterationTime > 0.0)
+    {
+      growth = std::min(std::max(lastIterationTime / prevIterationTime, 2.0),
+                        growth);
+    }
+    return (elapsed + (lastIterationTime * growth)) <= softDeadline;
+  }
+
+  /// <summary> Ask the current move to stop as soon as possible. Safe to
+  ///   call from any thread.
+  /// </summary>
+  inline void EmergencyStop() { emergency.store(true); }
+
+  inline bool Emergency() const { return emergency.load(); }
+
+  /// <summary> Set when the running search must stop. </summary>
+  inline const std::atomic<bool>* StopSignal() const { return &emergency; }
+  inline double Elapsed() const { return moveActive ? moveTimer.GetTime() : 0.0; }
+  inline double SoftDeadline() const { return softDeadline; }
+  inline double HardDeadline() const { return hardDeadline; }
+  inline bool SoftDeadlinePassed() const { return Elapsed() >= softDeadline; }
+  inline bool HardDeadlinePassed() const { return Elapsed() >= hardDeadline; }
+
+  /// <summary> Clock left for the game, not counting the current move. </summary>
+  inline double Remaining() const
+  {
+    return std::max(params.gameTimeSec - timeUsed, 0.0);
+  }
+
+  inline double TimeUsed() const { return timeUsed; }
+  inline Params& GetParams() { return params; }
+  inline const Params& GetParams() const { return params; }
+
+  /// <summary> Compute the deadlines for a move. </summary>
+  void Allocate(const int emptyCells, const int branching, const double remaining)
+  {
+    const double usable = remaining - params.safetyMarginSec;
+    emergency.store(usable < params.panicTimeSec);
+    if (Emergency())
+    {
+      softDeadline = 0.0;
+      hardDeadline = std::max(0.0, remaining * params.maxMoveFraction);
+      baseSoftDeadline = softDeadline;
+      return;
+    }
+    // We make every other move of those left.
+    const int movesLeft = std::max((emptyCells + 1) / 2, 1);
+    const double complexity =
+      sqrt(static_cast<double>(std::max(branching, 1)) /
+           static_cast<double>(params.typicalBranching));
+    const double cap = (usable * params.maxMoveFraction) / sharers;
+    softDeadline = (usable / movesLeft) * std::min(std::max(complexity, 0.5), 2.0) /
+                   sharers;
+    softDeadline = std::min(std::max(softDeadline, params.minMoveTimeSec), cap);
+    hardDeadline = std::min(softDeadline * params.hardFactor, cap);
+    hardDeadline = std::max(hardDeadline, softDeadline);
+    baseSoftDeadline = softDeadline;
+  }
+
+private:
+  Params params;
+  double timeUsed;
+  Timer moveTimer;
+  double softDeadline;
+  double hardDeadline;
+  double baseSoftDeadline;
+  int iterations;
+  int lastScore;
+  double lastIterationEnd;
+  double lastIterationTime;
+  double prevIterationTime;
+  std::atomic<bool> emergency;
+  bool moveActive;
+  /// <summary> Games waiting on the engine; see ShareEngine(). </summary>
+  int sharers;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_TIME_MANAGER_H_
@@ -0,0 +1,100 @@
+#ifndef _HPS_SUDOKILL_TIME_MANAGER_GTEST_H_
+#define _HPS_SUDOKILL_TIME_MANAGER_GTEST_H_
+
+#include "time_manager.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_time_manager_gtest_h_
+{
+using namespace hps;
+
+TEST(TimeManager, Allocate)
+{
+  TimeManager timeManager;
+  timeManager.Allocate(40, 24, 100.0);
+  const double soft = timeManager.SoftDeadline();
+  EXPECT_GT(soft, 0.0);
+  EXPECT_LE(soft, timeManager.HardDeadline());
+  EXPECT_LE(timeManager.HardDeadline(), 100.0);
+  EXPECT_FALSE(timeManager.Emergency());
+
+  // More legal moves means a harder position and a larger budget.
+  timeManager.Allocate(40, 96, 100.0);
+  EXPECT_GT(timeManager.SoftDeadline(), soft);
+  // Fewer moves left in the game means more time per move.
+  timeManager.Allocate(10, 24, 100.0);
+  EXPECT_GT(timeManager.SoftDeadline(), soft);
+  // Nearly out of time.
+  timeManager.Allocate(40, 24, timeManager.GetParams().safetyMarginSec);
+  EXPECT_TRUE(timeManager.Emergency());
+  EXPECT_FALSE(timeManager.StartNextIteration(0.0));
+}
+
+TEST(TimeManager, StartNextIteration)
+{
+  TimeManager timeManager;
+  timeManager.Allocate(40, 24, 100.0);
+  const double soft = timeManager.SoftDeadline();
+  EXPECT_TRUE(timeManager.StartNextIteration(0.0));
+  EXPECT_FALSE(timeManager.StartNextIteration(soft));
+  // Iterations growing 4x: the next one is predicted to take 4x the last.
+  timeManager.IterationComplete(10, soft * 0.02);
+  timeManager.IterationComplete(10, soft * 0.08);
+  EXPECT_TRUE(timeManager.StartNextIteration(soft * 0.1));
+  timeManager.IterationComplete(10, soft * 0.32);
+  EXPECT_FALSE(timeManager.StartNextIteration(soft * 0.42));
+}
+
+TEST(TimeManager, InstabilityExtendsBudget)
+{
+  TimeManager timeManager;
+  timeManager.Allocate(40, 24, 100.0);
+  const double soft = timeManager.SoftDeadline();
+  timeManager.IterationComplete(10, 0.0);
+  timeManager.IterationComplete(10, 0.0);
+  EXPECT_EQ(soft, timeManager.SoftDeadline());
+  timeManager.IterationComplete(20, 0.0);
+  EXPECT_GT(timeManager.SoftDeadline(), soft);
+  EXPECT_LE(timeManager.SoftDeadline(), timeManager.HardDeadline());
+}
+
+TEST(TimeManager, EmergencyStop)
+{
+  TimeManager timeManager;
+  timeManager.BeginMove(40, 24);
+  EXPECT_TRUE(timeManager.StartNextIteration());
+  timeManager.EmergencyStop();
+  EXPECT_FALSE(timeManager.StartNextIteration());
+  timeManager.EndMove();
+  EXPECT_GE(timeManager.TimeUsed(), 0.0);
+}
+
+TEST(TimeManager, ChargeWait)
+{
+  TimeManager timeManager;
+  const double remaining = timeManager.Remaining();
+  timeManager.ChargeWait(2.5);
+  EXPECT_DOUBLE_EQ(2.5, timeManager.TimeUsed());
+  EXPECT_DOUBLE_EQ(remaining - 2.5, timeManager.Remaining());
+}
+
+TEST(TimeManager, ShareEngine)
+{
+  TimeManager timeManager;
+  timeManager.Allocate(40, 24, 100.0);
+  const double soft = timeManager.SoftDeadline();
+  const double hard = timeManager.HardDeadline();
+  // Four games in line: each takes a quarter, so the last one still
+  // searches within its own budget.
+  timeManager.ShareEngine(4);
+  timeManager.Allocate(40, 24, 100.0);
+  EXPECT_DOUBLE_EQ(soft / 4.0, timeManager.SoftDeadline());
+  EXPECT_DOUBLE_EQ(hard / 4.0, timeManager.HardDeadline());
+  timeManager.ShareEngine(1);
+  timeManager.Allocate(40, 24, 100.0);
+  EXPECT_DOUBLE_EQ(soft, timeManager.SoftDeadline());
+}
+
+}
+
+#endif //_HPS_SUDOKILL_TIME_MANAGER_GTEST_H_
@@ -7,7 +7,7 @@
 #include <time.h>
 #include <windows.h>
 #else
-#include <sys/time.h>
+#include <time.h>
 #endif
 
 namespace hps
@@ -16,6 +16,11 @@ namespace util
 {
 
 /// <summary> A timer class giving double seconds. </summary>
+/// <remarks>
+///   <para> Reads a monotonic clock, so it does not jump when the wall clock
+///     is adjusted and has nanosecond resolution outside Windows.
+///   </para>
+/// </remarks>
 class Timer
 {
 #ifdef WIN32
@@ -55,26 +60,26 @@ public:
   Timer()
     : m_timeStart()
   {
-    gettimeofday(&m_timeStart, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &m_timeStart);
   }
 
   inline double GetTime() const
   {
-    timeval timeEnd;
-    gettimeofday(&timeEnd, NULL);
+    timespec timeEnd;
+    clock_gettime(CLOCK_MONOTONIC, &timeEnd);
     time_t timeWholeS = timeEnd.tv_sec - m_timeStart.tv_sec;
-    double timeMicroS = static_cast<double>(timeEnd.tv_usec -
-                                            m_timeStart.tv_usec);
-    return static_cast<double>(timeWholeS) + (timeMicroS * 1.0e-6);
+    double timeNanoS = static_cast<double>(timeEnd.tv_nsec -
+                                           m_timeStart.tv_nsec);
+    return static_cast<double>(timeWholeS) + (timeNanoS * 1.0e-9);
   }
 
   inline void Reset()
   {
-    gettimeofday(&m_timeStart, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &m_timeStart);
   }
 
 private:
-  timeval m_timeStart;
+  timespec m_timeStart;
 #endif
 };
 
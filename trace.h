@@ -0,0 +1,257 @@
+#ifndef _HPS_UTIL_TRACE_H_
+#define _HPS_UTIL_TRACE_H_
+
+#ifdef WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdint.h>
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+namespace hps
+{
+namespace util
+{
+
+/// <summary> A span of time on one thread, as a Chrome trace complete event. </summary>
+struct TraceEvent
+{
+  /// <summary> Must be a string literal or otherwise outlive the trace. </summary>
+  const char* name;
+  long long arg;
+  uint64_t beginNs;
+  uint64_t endNs;
+};
+
+/// <summary> Fixed ring of the most recent events of one thread. </summary>
+/// <remarks>
+///   <para> Only the owning thread pushes, so a push is a store of the event
+///     and a release of the count, with no lock or read-modify-write.
+///   </para>
+/// </remarks>
+struct TraceRing
+{
+  enum { Capacity = 1 << 14, };
+
+  explicit TraceRing(const int tid_) : written(0), tid(tid_) {}
+
+  inline void Push(const TraceEvent& event)
+  {
+    const uint64_t count = written.load(std::memory_order_relaxed);
+    events[count & (Capacity - 1)] = event;
+    written.store(count + 1, std::memory_order_release);
+  }
+
+  TraceEvent events[Capacity];
+  std::atomic<uint64_t> written;
+  int tid;
+};
+
+/// <summary> Process-wide span recorder written as Chrome trace JSON. </summary>
+/// <remarks>
+///   <para> Spans are recorded only while enabled; when disabled a TraceSpan
+///     costs one relaxed load and a branch. Defining HPS_NO_TRACE compiles
+///     the spans out altogether.
+///   </para>
+///   <para> Each thread records into its own TraceRing, registered on its
+///     first span and kept until exit, so OpenMP pool threads keep their
+///     ids. Write and Clear read the rings of other threads and must only be
+///     called when no spans are open, such as between moves or at exit.
+///   </para>
+///   <para> Load the JSON in chrome://tracing or ui.perfetto.dev. </para>
+/// </remarks>
+class Trace
+{
+public:
+  inline static bool Enabled()
+  {
+#ifdef HPS_NO_TRACE
+    return false;
+#else
+    return State().enabled.load(std::memory_order_relaxed);
+#endif
+  }
+
+  static void Enable()
+  {
+    State().enabled.store(true, std::memory_order_relaxed);
+  }
+
+  static void Disable()
+  {
+    State().enabled.store(false, std::memory_order_relaxed);
+  }
+
+  /// <summary> Monotonic nanoseconds since the process's trace epoch. </summary>
+  inline static uint64_t NowNs()
+  {
+    return ClockNs() - State().epochNs;
+  }
+
+  /// <summary> Record a finished span on the calling thread. </summary>
+  inline static void Record(const char* name,
+                            const long long arg,
+                            const uint64_t beginNs,
+                            const uint64_t endNs)
+  {
+    static thread_local TraceRing* t_ring = NULL;
+    if (NULL == t_ring)
+    {
+      t_ring = Register();
+    }
+    const TraceEvent event = { name, arg, beginNs, endNs, };
+    t_ring->Push(event);
+  }
+
+  /// <summary> Drop all recorded events. </summary>
+  static void Clear()
+  {
+    TraceState& state = State();
+    std::lock_guard<std::mutex> lock(state.registryLock);
+    for (size_t ringIdx = 0; ringIdx < state.rings.size(); ++ringIdx)
+    {
+      state.rings[ringIdx]->written.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /// <summary> Write the recorded events as Chrome trace JSON. </summary>
+  static void Write(std::ostream& out)
+  {
+    TraceState& state = State();
+    std::lock_guard<std::mutex> lock(state.registryLock);
+    out << "{\"traceEvents\":[";
+    const char* separator = "\n";
+    for (size_t ringIdx = 0; ringIdx < state.rings.size(); ++ringIdx)
+    {
+      const TraceRing& ring = *state.rings[ringIdx];
+      out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+          << ring.tid << ",\"args\":{\"name\":\"thread " << ring.tid << "\"}}";
+      separator = ",\n";
+      // Only the last Capacity events survive.
+      const uint64_t written = ring.written.load(std::memory_order_acquire);
+      const uint64_t begin = (written > TraceRing::Capacity) ?
+                             (written - TraceRing::Capacity) : 0;
+      for (uint64_t eventIdx = begin; eventIdx < written; ++eventIdx)
+      {
+        const TraceEvent& event = ring.events[eventIdx & (TraceRing::Capacity - 1)];
+        out << separator << "{\"name\":\"" << event.name
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.tid
+            << ",\"ts\":" << (event.beginNs / 1000) << "." << Frac3(event.beginNs)
+            << ",\"dur\":" << ((event.endNs - event.beginNs) / 1000) << "."
+            << Frac3(event.endNs - event.beginNs)
+            << ",\"args\":{\"arg\":" << event.arg << "}}";
+      }
+    }
+    out << "\n]}" << std::endl;
+  }
+
+  /// <summary> Write the recorded events to a file. </summary>
+  static bool Write(const std::string& path)
+  {
+    std::ofstream out(path.c_str());
+    if (!out.good())
+    {
+      return false;
+    }
+    Write(out);
+    return out.good();
+  }
+
+private:
+  struct TraceState
+  {
+    TraceState() : enabled(false), epochNs(ClockNs()), registryLock(), rings() {}
+    std::atomic<bool> enabled;
+    uint64_t epochNs;
+    std::mutex registryLock;
+    std::vector<TraceRing*> rings;
+  };
+
+  inline static TraceState& State()
+  {
+    static TraceState s_state;
+    return s_state;
+  }
+
+  /// <summary> Give the calling thread a ring. Rings are never freed. </summary>
+  static TraceRing* Register()
+  {
+    TraceState& state = State();
+    std::lock_guard<std::mutex> lock(state.registryLock);
+    TraceRing* ring = new TraceRing(static_cast<int>(state.rings.size()));
+    state.rings.push_back(ring);
+    return ring;
+  }
+
+  inline static uint64_t ClockNs()
+  {
+#ifdef WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER freq;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&freq);
+    return static_cast<uint64_t>(
+      static_cast<double>(counter.QuadPart) * (1.0e9 / static_cast<double>(freq.QuadPart)));
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (static_cast<uint64_t>(now.tv_sec) * 1000000000ULL) +
+           static_cast<uint64_t>(now.tv_nsec);
+#endif
+  }
+
+  /// <summary> Three zero-padded digits of nanoseconds below a microsecond. </summary>
+  inline static std::string Frac3(const uint64_t ns)
+  {
+    const int frac = static_cast<int>(ns % 1000);
+    char digits[4] = { static_cast<char>('0' + (frac / 100)),
+                       static_cast<char>('0' + ((frac / 10) % 10)),
+                       static_cast<char>('0' + (frac % 10)),
+                       '\0', };
+    return std::string(digits);
+  }
+};
+
+/// <summary> Record the lifetime of the object as a span when tracing. </summary>
+class TraceSpan
+{
+public:
+  explicit TraceSpan(const char* name_, const long long arg_ = 0)
+  : name(name_),
+    arg(arg_),
+    active(Trace::Enabled()),
+    beginNs(active ? Trace::NowNs() : 0)
+  {}
+
+  ~TraceSpan()
+  {
+    if (active)
+    {
+      Trace::Record(name, arg, beginNs, Trace::NowNs());
+    }
+  }
+
+private:
+  TraceSpan(const TraceSpan&);
+  TraceSpan& operator=(const TraceSpan&);
+
+  const char* name;
+  long long arg;
+  bool active;
+  uint64_t beginNs;
+};
+
+}
+using namespace util;
+}
+
+#endif //_HPS_UTIL_TRACE_H_
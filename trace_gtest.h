@@ -0,0 +1,84 @@
+#ifndef _HPS_UTIL_TRACE_GTEST_H_
+#define _HPS_UTIL_TRACE_GTEST_H_
+
+#include "trace.h"
+#include "gtest/gtest.h"
+#include <omp.h>
+#include <sstream>
+
+namespace _hps_util_trace_gtest_h_
+{
+using namespace hps;
+
+/// <summary> Count the non-overlapping occurrences of the pattern. </summary>
+int CountOf(const std::string& text, const std::string& pattern)
+{
+  int count = 0;
+  for (size_t pos = text.find(pattern); std::string::npos != pos;
+       pos = text.find(pattern, pos + pattern.size()))
+  {
+    ++count;
+  }
+  return count;
+}
+
+TEST(Trace, DisabledRecordsNothing)
+{
+  Trace::Disable();
+  Trace::Clear();
+  {
+    TraceSpan span("disabled_span");
+  }
+  std::stringstream ss;
+  Trace::Write(ss);
+  EXPECT_EQ(0, CountOf(ss.str(), "disabled_span"));
+}
+
+TEST(Trace, SpansPerThread)
+{
+  enum { NumSpans = 64, };
+  Trace::Clear();
+  Trace::Enable();
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int spanIdx = 0; spanIdx < NumSpans; ++spanIdx)
+  {
+    TraceSpan span("parallel_span", spanIdx);
+  }
+  {
+    TraceSpan outer("outer_span");
+    TraceSpan inner("inner_span");
+  }
+  Trace::Disable();
+  std::stringstream ss;
+  Trace::Write(ss);
+  const std::string json = ss.str();
+  EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+  EXPECT_EQ(NumSpans, CountOf(json, "\"name\":\"parallel_span\""));
+  EXPECT_EQ(1, CountOf(json, "\"name\":\"outer_span\""));
+  EXPECT_EQ(1, CountOf(json, "\"name\":\"inner_span\""));
+  EXPECT_EQ(1, CountOf(json, "\"args\":{\"arg\":63}"));
+  EXPECT_LE(1, CountOf(json, "\"ph\":\"M\""));
+  Trace::Clear();
+}
+
+TEST(Trace, RingKeepsLatest)
+{
+  Trace::Clear();
+  Trace::Enable();
+  for (int spanIdx = 0; spanIdx < TraceRing::Capacity + 10; ++spanIdx)
+  {
+    TraceSpan span("ring_span", spanIdx);
+  }
+  Trace::Disable();
+  std::stringstream ss;
+  Trace::Write(ss);
+  const std::string json = ss.str();
+  EXPECT_EQ(static_cast<int>(TraceRing::Capacity), CountOf(json, "\"name\":\"ring_span\""));
+  EXPECT_EQ(0, CountOf(json, "\"args\":{\"arg\":9}}"));
+  EXPECT_EQ(1, CountOf(json, "\"args\":{\"arg\":10}}"));
+  Trace::Clear();
+}
+
+}
+
+#endif //_HPS_UTIL_TRACE_GTEST_H_
@@ -0,0 +1,262 @@
+#ifndef _HPS_SUDOKILL_TUNER_H_
+#define _HPS_SUDOKILL_TUNER_H_
+#include "sudokill_core.h"
+#include "alphabetapruning.h"
+#include "eval_weights.h"
+#include "player.h"
+#include "rand_bound.h"
+#include "thread_pool.h"
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace hps
+{
+namespace sudokill
+{
+
+/// <summary> Plays matches between two sets of weights on every core. </summary>
+/// <remarks>
+///   <para> Each game searches to a fixed depth, so matches are short and
+///     repeatable: a game depends only on the weights and its seed. Games
+///     come in pairs with the same seed and the sides swapped.
+///   </para>
+///   <para> A SearchTeam plays the games, each worker searching on one
+///     thread.
+///   </para>
+/// </remarks>
+class SelfPlay
+{
+public:
+  struct Options
+  {
+    Options() : depth(3), numThreads(0) {}
+    /// <summary> Search depth of every move. </summary>
+    int depth;
+    /// <summary> Games played at once; 0 is one per CPU. </summary>
+    int numThreads;
+  };
+
+  explicit SelfPlay(const Options& options_ = Options())
+  : options(options_),
+    games(options_.numThreads, 1)
+  {}
+
+  /// <summary> Move like AlphaBetaPlayer, with a fixed depth instead of a clock. </summary>
+  static void NextMove(const EvalWeights& weights,
+                       const int depth,
+                       ThreadPool* pool,
+                       Rng* rng,
+                       Board* board,
+                       Cell* move)
+  {
+    assert(board && move);
+    Board::MoveList sudokuMoves;
+    board->SudokuValidMoves(&sudokuMoves);
+    if (static_cast<int>(sudokuMoves.size()) > weights.randomPlayMoves)
+    {
+      RandomPlayer(rng).NextMove(*board, move);
+      return;
+    }
+    AlphaBetaPruning::Params params;
+    params.maxDepth = AlphaBetaPruning::DepthCap(*board, depth);
+    params.pool = pool;
+    const WeightedEvaluationFunc f(weights, board->GetPlayerMovesCount());
+    AlphaBetaPruning::Run(&params, board, &f, move);
+  }
+
+  /// <summary> Play one game; returns the index of the winner. </summary>
+  static int PlayGame(const EvalWeights* players[2],
+                      const int depth,
+                      ThreadPool* pool,
+                      const uint64_t seed)
+  {
+    Rng rng(seed);
+    Board board;
+    Board::MoveList moves;
+    for (int turn = 0; ; turn ^= 1)
+    {
+      board.ValidMoves(&moves);
+      if (moves.empty())
+      {
+        return turn ^ 1;
+      }
+      Cell move;
+      NextMove(*players[turn], depth, pool, &rng, &board, &move);
+      assert(board.IsValidMove(move));
+      board.PlayMove(move);
+    }
+  }
+
+  /// <summary> Play numPairs pairs of games from the given seed. </summary>
+  /// <returns> The share of the points that went to first, in [0, 1]. </returns>
+  double Match(const EvalWeights& first,
+               const EvalWeights& second,
+               const int numPairs,
+               const uint64_t seed)
+  {
+    assert(numPairs > 0);
+    MatchGame game;
+    game.depth = options.depth;
+    game.players[0] = &first;
+    game.players[1] = &second;
+    game.seed = seed;
+    game.firstWins.store(0);
+    games.ForEach(2 * numPairs, &game);
+    return static_cast<double>(game.firstWins.load()) / (2 * numPairs);
+  }
+
+  inline int Threads() const
+  {
+    return games.Size();
+  }
+
+private:
+  SelfPlay(const SelfPlay&);
+  SelfPlay& operator=(const SelfPlay&);
+
+  struct MatchGame
+  {
+    void operator()(const int gameIdx, ThreadPool* pool)
+    {
+      // Both games of a pair share the seed; the odd one swaps sides.
+      const int swap = gameIdx & 1;
+      const EvalWeights* sides[2] = { players[swap], players[swap ^ 1], };
+      const int winner = PlayGame(sides, depth, pool,
+                                  seed + static_cast<uint64_t>(gameIdx / 2));
+      firstWins.fetch_add((winner == swap) ? 1 : 0);
+    }
+
+    int depth;
+    const EvalWeights* players[2];
+    uint64_t seed;
+    std::atomic<int> firstWins;
+  };
+
+  Options options;
+  SearchTeam games;
+};
+
+/// <summary> Tune EvalWeights by simultaneous perturbation stochastic
+///   approximation (SPSA) over self-play matches.
+/// </summary>
+/// <remarks>
+///   <para> Each iteration k moves every field by +/- c_k * step at random,
+///     plays the two perturbed weights against each other, and moves the
+///     weights toward the winner by a_k * c_k * step * (score - 1/2) * 2,
+///     where score is the share of the points of the + side. Following
+///     Spall, c_k = 1 / (k + 1)^gamma and a_k = learningRate /
+///     (k + 1 + stability)^alpha.
+///   </para>
+///   <para> The tuned values are kept as reals and rounded for play, so
+///     steps smaller than one still accumulate.
+///   </para>
+/// </remarks>
+class Spsa
+{
+public:
+  struct Options
+  {
+    Options()
+    : pairsPerIteration(32),
+      learningRate(4.0),
+      stability(10.0),
+      alpha(0.602),
+      gamma(0.101),
+      seed(Rng::DefaultSeed)
+    {}
+    /// <summary> Game pairs between the perturbed weights per iteration. </summary>
+    int pairsPerIteration;
+    double learningRate;
+    double stability;
+    double alpha;
+    double gamma;
+    uint64_t seed;
+  };
+
+  Spsa(const Options& options_, SelfPlay* selfPlay_, const EvalWeights& start)
+  : options(options_),
+    selfPlay(selfPlay_),
+    rng(options_.seed),
+    iteration(0),
+    theta(EvalWeights::NumFields)
+  {
+    assert(selfPlay);
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      theta[fieldIdx] = start.*(EvalWeights::Fields()[fieldIdx].member);
+    }
+  }
+
+  /// <summary> Run one iteration; returns the + side's score. </summary>
+  double Step()
+  {
+    const EvalWeights::Field* fields = EvalWeights::Fields();
+    const double ck = 1.0 / pow(iteration + 1.0, options.gamma);
+    const double ak = options.learningRate /
+                      pow(iteration + 1.0 + options.stability, options.alpha);
+    std::vector<double> delta(EvalWeights::NumFields);
+    std::vector<double> plus(EvalWeights::NumFields);
+    std::vector<double> minus(EvalWeights::NumFields);
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      delta[fieldIdx] = (0 == RandBound(rng, 2)) ? -1.0 : 1.0;
+      const double shift = ck * fields[fieldIdx].step * delta[fieldIdx];
+      plus[fieldIdx] = theta[fieldIdx] + shift;
+      minus[fieldIdx] = theta[fieldIdx] - shift;
+    }
+    const double score = selfPlay->Match(Round(plus), Round(minus),
+                                         options.pairsPerIteration, rng());
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      const EvalWeights::Field& field = fields[fieldIdx];
+      theta[fieldIdx] += ak * ck * field.step * delta[fieldIdx] * ((2.0 * score) - 1.0);
+      theta[fieldIdx] = std::max(static_cast<double>(field.minValue),
+                                 std::min(static_cast<double>(field.maxValue),
+                                          theta[fieldIdx]));
+    }
+    ++iteration;
+    return score;
+  }
+
+  /// <summary> The current weights, rounded for play. </summary>
+  inline EvalWeights Weights() const
+  {
+    return Round(theta);
+  }
+
+  inline int Iteration() const
+  {
+    return iteration;
+  }
+
+  /// <summary> Nearest weights, within each field's range. </summary>
+  static EvalWeights Round(const std::vector<double>& values)
+  {
+    assert(EvalWeights::NumFields == static_cast<int>(values.size()));
+    const EvalWeights::Field* fields = EvalWeights::Fields();
+    EvalWeights weights;
+    for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+    {
+      const int value = static_cast<int>(floor(values[fieldIdx] + 0.5));
+      weights.*(fields[fieldIdx].member) =
+        std::max(fields[fieldIdx].minValue, std::min(fields[fieldIdx].maxValue, value));
+    }
+    return weights;
+  }
+
+private:
+  Options options;
+  SelfPlay* selfPlay;
+  Rng rng;
+  int iteration;
+  std::vector<double> theta;
+};
+
+}
+using namespace sudokill;
+}
+
+#endif //_HPS_SUDOKILL_TUNER_H_
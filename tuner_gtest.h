@@ -0,0 +1,58 @@
+#ifndef _HPS_SUDOKILL_TUNER_GTEST_H_
+#define _HPS_SUDOKILL_TUNER_GTEST_H_
+
+#include "tuner.h"
+#include "gtest/gtest.h"
+
+namespace _hps_sudokill_tuner_gtest_h_
+{
+using namespace hps;
+
+TEST(Tuner, SelfPlayIsRepeatable)
+{
+  SelfPlay::Options options;
+  options.depth = 2;
+  options.numThreads = 3;
+  SelfPlay selfPlay(options);
+  ASSERT_EQ(3, selfPlay.Threads());
+  EvalWeights first;
+  EvalWeights second;
+  second.parity = 500;
+  const double score = selfPlay.Match(first, second, 4, 17);
+  EXPECT_GE(score, 0.0);
+  EXPECT_LE(score, 1.0);
+  EXPECT_EQ(score, selfPlay.Match(first, second, 4, 17));
+  // Equal weights split every pair, since the sides swap.
+  EXPECT_EQ(0.5, selfPlay.Match(first, first, 4, 17));
+}
+
+TEST(Tuner, SpsaStaysInRange)
+{
+  SelfPlay::Options options;
+  options.depth = 2;
+  SelfPlay selfPlay(options);
+  Spsa::Options spsaOptions;
+  spsaOptions.pairsPerIteration = 2;
+  EvalWeights start;
+  start.mobility = 0;
+  start.randomPlayMoves = 729;
+  Spsa spsa(spsaOptions, &selfPlay, start);
+  for (int k = 0; k < 3; ++k)
+  {
+    const double score = spsa.Step();
+    EXPECT_GE(score, 0.0);
+    EXPECT_LE(score, 1.0);
+  }
+  EXPECT_EQ(3, spsa.Iteration());
+  const EvalWeights tuned = spsa.Weights();
+  const EvalWeights::Field* fields = EvalWeights::Fields();
+  for (int fieldIdx = 0; fieldIdx < EvalWeights::NumFields; ++fieldIdx)
+  {
+    EXPECT_GE(tuned.*(fields[fieldIdx].member), fields[fieldIdx].minValue);
+    EXPECT_LE(tuned.*(fields[fieldIdx].member), fields[fieldIdx].maxValue);
+  }
+}
+
+}
+
+#endif //_HPS_SUDOKILL_TUNER_GTEST_H_